@@ -98,6 +98,12 @@ void ComposerCommandEngine::dispatchDisplayCommand(const DisplayCommand& command
     //  place SetDisplayBrightness before SetLayerWhitePointNits since current
     //  display brightness is used to validate the layer white point nits.
     DISPATCH_DISPLAY_COMMAND(command, brightness, SetDisplayBrightness);
+    for (const auto& layerCmd : command.layers) {
+        dispatchLayerBufferCommand(command.display, layerCmd);
+    }
+    // the simple layer states of all layers go down in one call, after the
+    // buffers so that the dataspace sees the new buffer format.
+    executeSetLayerStates(command.display, command.layers);
     for (const auto& layerCmd : command.layers) {
         dispatchLayerCommand(command.display, layerCmd);
     }
@@ -113,23 +119,17 @@ void ComposerCommandEngine::dispatchDisplayCommand(const DisplayCommand& command
                                           frameIntervalNs, PresentOrValidateDisplay);
 }
 
-void ComposerCommandEngine::dispatchLayerCommand(int64_t display, const LayerCommand& command) {
+void ComposerCommandEngine::dispatchLayerBufferCommand(int64_t display,
+                                                       const LayerCommand& command) {
     DISPATCH_LAYER_COMMAND(display, command, cursorPosition, CursorPosition);
     DISPATCH_LAYER_COMMAND(display, command, buffer, Buffer);
     DISPATCH_LAYER_COMMAND(display, command, damage, SurfaceDamage);
-    DISPATCH_LAYER_COMMAND(display, command, blendMode, BlendMode);
-    DISPATCH_LAYER_COMMAND(display, command, color, Color);
-    DISPATCH_LAYER_COMMAND(display, command, composition, Composition);
-    DISPATCH_LAYER_COMMAND(display, command, dataspace, Dataspace);
-    DISPATCH_LAYER_COMMAND(display, command, displayFrame, DisplayFrame);
-    DISPATCH_LAYER_COMMAND(display, command, planeAlpha, PlaneAlpha);
+}
+
+void ComposerCommandEngine::dispatchLayerCommand(int64_t display, const LayerCommand& command) {
     DISPATCH_LAYER_COMMAND(display, command, sidebandStream, SidebandStream);
-    DISPATCH_LAYER_COMMAND(display, command, sourceCrop, SourceCrop);
-    DISPATCH_LAYER_COMMAND(display, command, transform, Transform);
     DISPATCH_LAYER_COMMAND(display, command, visibleRegion, VisibleRegion);
-    DISPATCH_LAYER_COMMAND(display, command, z, ZOrder);
     DISPATCH_LAYER_COMMAND(display, command, colorTransform, ColorTransform);
-    DISPATCH_LAYER_COMMAND(display, command, brightness, Brightness);
     DISPATCH_LAYER_COMMAND(display, command, perFrameMetadata, PerFrameMetadata);
     DISPATCH_LAYER_COMMAND(display, command, perFrameMetadataBlob, PerFrameMetadataBlobs);
     DISPATCH_LAYER_COMMAND_SIMPLE(display, command, blockingRegion, BlockingRegion);
@@ -290,6 +290,24 @@ int ComposerCommandEngine::executePresentDisplay(int64_t display) {
     return err;
 }
 
+void ComposerCommandEngine::executeSetLayerStates(int64_t display,
+                                                  const std::vector<LayerCommand>& commands) {
+    std::vector<int32_t> errors;
+    auto err = mHal->setLayerStates(display, commands, errors);
+    if (err) {
+        LOG(ERROR) << __func__ << ": err " << err;
+        mWriter->setError(mCommandIndex, err);
+        return;
+    }
+
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (errors[i]) {
+            LOG(ERROR) << __func__ << ": layer " << commands[i].layer << " err " << errors[i];
+            mWriter->setError(mCommandIndex, errors[i]);
+        }
+    }
+}
+
 void ComposerCommandEngine::executeSetLayerCursorPosition(int64_t display, int64_t layer,
                                        const common::Point& cursorPosition) {
     auto err = mHal->setLayerCursorPosition(display, layer, cursorPosition.x, cursorPosition.y);
@@ -330,60 +348,6 @@ void ComposerCommandEngine::executeSetLayerSurfaceDamage(int64_t display, int64_
     }
 }
 
-void ComposerCommandEngine::executeSetLayerBlendMode(int64_t display, int64_t layer,
-                                                     const ParcelableBlendMode& blendMode) {
-    auto err = mHal->setLayerBlendMode(display, layer, blendMode.blendMode);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerColor(int64_t display, int64_t layer,
-                                                 const Color& color) {
-    auto err = mHal->setLayerColor(display, layer, color);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerComposition(int64_t display, int64_t layer,
-                                                       const ParcelableComposition& composition) {
-    auto err = mHal->setLayerCompositionType(display, layer, composition.composition);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerDataspace(int64_t display, int64_t layer,
-                                                     const ParcelableDataspace& dataspace) {
-    auto err = mHal->setLayerDataspace(display, layer, dataspace.dataspace);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerDisplayFrame(int64_t display, int64_t layer,
-                                                        const common::Rect& rect) {
-    auto err = mHal->setLayerDisplayFrame(display, layer, rect);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerPlaneAlpha(int64_t display, int64_t layer,
-                                                      const PlaneAlpha& planeAlpha) {
-    auto err = mHal->setLayerPlaneAlpha(display, layer, planeAlpha.alpha);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
 void ComposerCommandEngine::executeSetLayerSidebandStream(int64_t display, int64_t layer,
                                                  const AidlNativeHandle& sidebandStream) {
     buffer_handle_t handle = ::android::makeFromAidl(sidebandStream);
@@ -401,24 +365,6 @@ void ComposerCommandEngine::executeSetLayerSidebandStream(int64_t display, int64
     }
 }
 
-void ComposerCommandEngine::executeSetLayerSourceCrop(int64_t display, int64_t layer,
-                                                      const common::FRect& sourceCrop) {
-    auto err = mHal->setLayerSourceCrop(display, layer, sourceCrop);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
-void ComposerCommandEngine::executeSetLayerTransform(int64_t display, int64_t layer,
-                                                     const ParcelableTransform& transform) {
-    auto err = mHal->setLayerTransform(display, layer, transform.transform);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
 void ComposerCommandEngine::executeSetLayerVisibleRegion(int64_t display, int64_t layer,
                           const std::vector<std::optional<common::Rect>>& visibleRegion) {
     auto err = mHal->setLayerVisibleRegion(display, layer, visibleRegion);
@@ -428,15 +374,6 @@ void ComposerCommandEngine::executeSetLayerVisibleRegion(int64_t display, int64_
     }
 }
 
-void ComposerCommandEngine::executeSetLayerZOrder(int64_t display, int64_t layer,
-                                                  const ZOrder& zOrder) {
-    auto err = mHal->setLayerZOrder(display, layer, zOrder.z);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
 void ComposerCommandEngine::executeSetLayerPerFrameMetadata(int64_t display, int64_t layer,
                 const std::vector<std::optional<PerFrameMetadata>>& perFrameMetadata) {
     auto err = mHal->setLayerPerFrameMetadata(display, layer, perFrameMetadata);
@@ -455,15 +392,6 @@ void ComposerCommandEngine::executeSetLayerColorTransform(int64_t display, int64
     }
 }
 
-void ComposerCommandEngine::executeSetLayerBrightness(int64_t display, int64_t layer,
-                                                      const LayerBrightness& brightness) {
-    auto err = mHal->setLayerBrightness(display, layer, brightness.brightness);
-    if (err) {
-        LOG(ERROR) << __func__ << ": err " << err;
-        mWriter->setError(mCommandIndex, err);
-    }
-}
-
 void ComposerCommandEngine::executeSetLayerPerFrameMetadataBlobs(int64_t display, int64_t layer,
                       const std::vector<std::optional<PerFrameMetadataBlob>>& metadata) {
     auto err = mHal->setLayerPerFrameMetadataBlobs(display, layer, metadata);
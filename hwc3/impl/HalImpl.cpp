@@ -1041,6 +1041,96 @@ int32_t HalImpl::setLayerZOrder(int64_t display, int64_t layer, uint32_t z) {
     return halLayer->setLayerZOrder(z);
 }
 
+int32_t HalImpl::setLayerStates(int64_t display, const std::vector<LayerCommand>& commands,
+                               std::vector<int32_t>& outErrors) {
+    std::vector<ExynosLayerStateDelta> deltas;
+    std::vector<size_t> commandIndices;
+    deltas.reserve(commands.size());
+    commandIndices.reserve(commands.size());
+    for (size_t i = 0; i < commands.size(); i++) {
+        const auto& command = commands[i];
+        ExynosLayerStateDelta delta;
+        bool hasState = false;
+
+        a2h::translate(command.layer, delta.layer);
+        if (command.blendMode) {
+            int32_t hwcMode;
+            a2h::translate(command.blendMode->blendMode, hwcMode);
+            delta.blendMode = hwcMode;
+            hasState = true;
+        }
+        if (command.color) {
+            hwc_color_t hwcColor;
+            a2h::translate(*command.color, hwcColor);
+            delta.color = hwcColor;
+            hasState = true;
+        }
+        if (command.composition) {
+            int32_t hwcType;
+            a2h::translate(command.composition->composition, hwcType);
+            delta.compositionType = hwcType;
+            hasState = true;
+        }
+        if (command.dataspace) {
+            int32_t hwcDataspace;
+            a2h::translate(command.dataspace->dataspace, hwcDataspace);
+            delta.dataspace = hwcDataspace;
+            hasState = true;
+        }
+        if (command.displayFrame) {
+            hwc_rect_t hwcFrame;
+            a2h::translate(*command.displayFrame, hwcFrame);
+            delta.displayFrame = hwcFrame;
+            hasState = true;
+        }
+        if (command.planeAlpha) {
+            delta.planeAlpha = command.planeAlpha->alpha;
+            hasState = true;
+        }
+        if (command.sourceCrop) {
+            hwc_frect_t hwcCrop;
+            a2h::translate(*command.sourceCrop, hwcCrop);
+            delta.sourceCrop = hwcCrop;
+            hasState = true;
+        }
+        if (command.transform) {
+            int32_t hwcTransform;
+            a2h::translate(command.transform->transform, hwcTransform);
+            delta.transform = hwcTransform;
+            hasState = true;
+        }
+        if (command.z) {
+            delta.z = command.z->z;
+            hasState = true;
+        }
+        if (command.brightness) {
+            delta.brightness = command.brightness->brightness;
+            hasState = true;
+        }
+
+        if (hasState) {
+            deltas.push_back(std::move(delta));
+            commandIndices.push_back(i);
+        }
+    }
+
+    outErrors.assign(commands.size(), HWC2_ERROR_NONE);
+    if (deltas.empty()) {
+        return HWC2_ERROR_NONE;
+    }
+
+    ExynosDisplay* halDisplay;
+    RET_IF_ERR(getHalDisplay(display, halDisplay));
+
+    std::vector<int32_t> hwcErrors;
+    halDisplay->setLayerStates(deltas, hwcErrors);
+    for (size_t i = 0; i < hwcErrors.size(); i++) {
+        outErrors[commandIndices[i]] = hwcErrors[i];
+    }
+
+    return HWC2_ERROR_NONE;
+}
+
 int32_t HalImpl::setOutputBuffer(int64_t display, buffer_handle_t buffer,
                                  const ndk::ScopedFileDescriptor& releaseFence) {
     ExynosDisplay* halDisplay;
@@ -141,6 +141,8 @@ class HalImpl : public IComposerHal {
                           const std::vector<std::optional<common::Rect>>& visible) override;
     int32_t setLayerBrightness(int64_t display, int64_t layer, float brightness) override;
     int32_t setLayerZOrder(int64_t display, int64_t layer, uint32_t z) override;
+    int32_t setLayerStates(int64_t display, const std::vector<LayerCommand>& commands,
+                           std::vector<int32_t>& outErrors) override;
     int32_t setOutputBuffer(int64_t display, buffer_handle_t buffer,
                             const ndk::ScopedFileDescriptor& releaseFence) override;
     int32_t setPowerMode(int64_t display, PowerMode mode) override;
@@ -224,6 +224,11 @@ class IComposerHal {
                                  const std::vector<std::optional<common::Rect>>& visible) = 0;
     virtual int32_t setLayerBrightness(int64_t display, int64_t layer, float brightness) = 0;
     virtual int32_t setLayerZOrder(int64_t display, int64_t layer, uint32_t z) = 0;
+    // Applies blend mode, color, composition, dataspace, display frame, plane alpha,
+    // source crop, transform, z order and brightness of all layer commands at once.
+    // outErrors holds one error per command.
+    virtual int32_t setLayerStates(int64_t display, const std::vector<LayerCommand>& commands,
+                                   std::vector<int32_t>& outErrors) = 0;
     virtual int32_t setOutputBuffer(int64_t display, buffer_handle_t buffer,
                                     const ndk::ScopedFileDescriptor& releaseFence) = 0;
     virtual int32_t setPowerMode(int64_t display, PowerMode mode) = 0;
@@ -1,8 +1,21 @@
 #ifndef __EXYNOS_SYNC_FENCE__
 #define __EXYNOS_SYNC_FENCE__
 
+#include <linux/types.h>
+
 #define SYNC_IOC_MAGIC      '>'
 #define SYNC_IOC_FENCE_NAME    _IOWR(SYNC_IOC_MAGIC, 10, char[32])
 
+/* sw_sync timeline of /sys/kernel/debug/sync/sw_sync */
+struct sw_sync_create_fence_data {
+    __u32 value;
+    char name[32];
+    __s32 fence;
+};
+
+#define SW_SYNC_IOC_MAGIC           'W'
+#define SW_SYNC_IOC_CREATE_FENCE    _IOWR(SW_SYNC_IOC_MAGIC, 0, struct sw_sync_create_fence_data)
+#define SW_SYNC_IOC_INC             _IOW(SW_SYNC_IOC_MAGIC, 1, __u32)
+
 #endif
 
@@ -35,8 +35,11 @@ ifdef BOARD_LIBACRYL_DEFAULT_BLTER
 else
     LOCAL_CFLAGS += -DLIBACRYL_DEFAULT_BLTER=\"no_default_blter\"
 endif
+ifeq ($(BOARD_LIBACRYL_G2D_EMULATOR), true)
+    LOCAL_CFLAGS += -DLIBACRYL_G2D_EMULATOR
+endif
 
-LOCAL_SHARED_LIBRARIES := liblog libutils libcutils libion_google android.hardware.graphics.common-V3-ndk
+LOCAL_SHARED_LIBRARIES := liblog libutils libcutils libsync libion_google android.hardware.graphics.common-V3-ndk
 ifdef BOARD_LIBACRYL_G2D_HDR_PLUGIN
     LOCAL_SHARED_LIBRARIES += $(BOARD_LIBACRYL_G2D_HDR_PLUGIN)
     LOCAL_CFLAGS += -DLIBACRYL_G2D_HDR_PLUGIN
@@ -66,9 +69,12 @@ LOCAL_C_INCLUDES += $(TOP)/hardware/google/graphics/$(TARGET_BOARD_PLATFORM)/lib
 
 LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/include
 
-LOCAL_SRC_FILES := acrylic.cpp acrylic_g2d.cpp
+LOCAL_SRC_FILES := acrylic.cpp acrylic_g2d.cpp acrylic_sw.cpp
 LOCAL_SRC_FILES += acrylic_factory.cpp acrylic_layer.cpp acrylic_formats.cpp
 LOCAL_SRC_FILES += acrylic_performance.cpp acrylic_device.cpp
+ifeq ($(BOARD_LIBACRYL_G2D_EMULATOR), true)
+LOCAL_SRC_FILES += acrylic_g2d_emulator.cpp
+endif
 
 LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE := libacryl
@@ -0,0 +1,71 @@
+/*
+ * Copyright Samsung Electronics Co.,LTD.
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_ACRYLIC_CSC_H__
+#define __HARDWARE_EXYNOS_ACRYLIC_CSC_H__
+
+#include <cstdint>
+
+enum {
+    G2D_CSC_STD_UNDEFINED = -1,
+    G2D_CSC_STD_601       = 0,
+    G2D_CSC_STD_709       = 1,
+    G2D_CSC_STD_2020      = 2,
+    G2D_CSC_STD_P3        = 3,
+
+    G2D_CSC_STD_COUNT     = 4,
+};
+
+enum {
+    G2D_CSC_RANGE_LIMITED,
+    G2D_CSC_RANGE_FULL,
+
+    G2D_CSC_RANGE_COUNT,
+};
+
+static const char csc_std_to_matrix_index[] = {
+    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_UNSPECIFIED
+    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_BT709
+    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_625
+    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_625_UNADJUSTED
+    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_525
+    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_525_UNADJUSTED
+    G2D_CSC_STD_2020,                         // HAL_DATASPACE_STANDARD_BT2020
+    G2D_CSC_STD_2020,                         // HAL_DATASPACE_STANDARD_BT2020_CONSTANT_LUMINANCE
+    static_cast<char>(G2D_CSC_STD_UNDEFINED), // HAL_DATASPACE_STANDARD_BT470M
+    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_FILM
+    G2D_CSC_STD_P3,                           // HAL_DATASPACE_STANDARD_DCI_P3
+    static_cast<char>(G2D_CSC_STD_UNDEFINED), // HAL_DATASPACE_STANDARD_ADOBE_RGB
+};
+
+/*
+ * YCbCr to RGB conversion matrices shared by the G2D command builder and the
+ * software compositor. Coefficients are signed fixed point with 9 fractional
+ * bits in the order of {R, G, B} x {Y, Cb, Cr}.
+ */
+static const uint16_t YCbCr2sRGBCoefficients[G2D_CSC_STD_COUNT * G2D_CSC_RANGE_COUNT][9] = {
+    {0x0254, 0x0000, 0x0331, 0x0254, 0xFF37, 0xFE60, 0x0254, 0x0409, 0x0000}, // 601 limited
+    {0x0200, 0x0000, 0x02BE, 0x0200, 0xFF54, 0xFE9B, 0x0200, 0x0377, 0x0000}, // 601 full
+    {0x0254, 0x0000, 0x0396, 0x0254, 0xFF93, 0xFEEF, 0x0254, 0x043A, 0x0000}, // 709 limited
+    {0x0200, 0x0000, 0x0314, 0x0200, 0xFFA2, 0xFF16, 0x0200, 0x03A1, 0x0000}, // 709 full
+    {0x0254, 0x0000, 0x035B, 0x0254, 0xFFA0, 0xFEB3, 0x0254, 0x0449, 0x0000}, // 2020 limited
+    {0x0200, 0x0000, 0x02E2, 0x0200, 0xFFAE, 0xFEE2, 0x0200, 0x03AE, 0x0000}, // 2020 full
+    {0x0254, 0x0000, 0x03AE, 0x0254, 0xFF96, 0xFEEE, 0x0254, 0x0456, 0x0000}, // DCI-P3 limited
+    {0x0200, 0x0000, 0x0329, 0x0200, 0xFFA5, 0xFF15, 0x0200, 0x03B9, 0x0000}, // DCI-P3 full
+};
+
+#endif /* __HARDWARE_EXYNOS_ACRYLIC_CSC_H__ */
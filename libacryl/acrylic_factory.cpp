@@ -22,6 +22,7 @@
 #include <cstring>
 
 #include "acrylic_g2d.h"
+#include "acrylic_sw.h"
 #include "acrylic_internal.h"
 #include "acrylic_capability.h"
 
@@ -30,7 +31,10 @@ Acrylic *Acrylic::createInstance(const char *spec)
     Acrylic *compositor = nullptr;
 
     ALOGD_TEST("Creating a new Acrylic instance of '%s'", spec);
-    compositor = createAcrylicCompositorG2D(spec);
+    if (strcmp(spec, LIBACRYL_SW_COMPOSITOR) == 0)
+        compositor = createAcrylicCompositorSW(spec);
+    else
+        compositor = createAcrylicCompositorG2D(spec);
     if (compositor) {
         ALOGI("%s compositor added", spec);
     }
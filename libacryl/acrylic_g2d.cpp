@@ -18,6 +18,7 @@
 #define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
 
 #include "acrylic_g2d.h"
+#include "acrylic_csc.h"
 
 #include <alloca.h>
 #include <exynos_format.h> // hardware/smasung_slsi/exynos/include
@@ -29,51 +30,9 @@
 #include <utils/Trace.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
-enum {
-    G2D_CSC_STD_UNDEFINED = -1,
-    G2D_CSC_STD_601       = 0,
-    G2D_CSC_STD_709       = 1,
-    G2D_CSC_STD_2020      = 2,
-    G2D_CSC_STD_P3        = 3,
-
-    G2D_CSC_STD_COUNT     = 4,
-};
-
-enum {
-    G2D_CSC_RANGE_LIMITED,
-    G2D_CSC_RANGE_FULL,
-
-    G2D_CSC_RANGE_COUNT,
-};
-
-static char csc_std_to_matrix_index[] = {
-    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_UNSPECIFIED
-    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_BT709
-    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_625
-    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_625_UNADJUSTED
-    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_525
-    G2D_CSC_STD_601,                          // HAL_DATASPACE_STANDARD_BT601_525_UNADJUSTED
-    G2D_CSC_STD_2020,                         // HAL_DATASPACE_STANDARD_BT2020
-    G2D_CSC_STD_2020,                         // HAL_DATASPACE_STANDARD_BT2020_CONSTANT_LUMINANCE
-    static_cast<char>(G2D_CSC_STD_UNDEFINED), // HAL_DATASPACE_STANDARD_BT470M
-    G2D_CSC_STD_709,                          // HAL_DATASPACE_STANDARD_FILM
-    G2D_CSC_STD_P3,                           // HAL_DATASPACE_STANDARD_DCI_P3
-    static_cast<char>(G2D_CSC_STD_UNDEFINED), // HAL_DATASPACE_STANDARD_ADOBE_RGB
-};
-
-static uint16_t YCbCr2sRGBCoefficients[G2D_CSC_STD_COUNT * G2D_CSC_RANGE_COUNT][9] = {
-    {0x0254, 0x0000, 0x0331, 0x0254, 0xFF37, 0xFE60, 0x0254, 0x0409, 0x0000}, // 601 limited
-    {0x0200, 0x0000, 0x02BE, 0x0200, 0xFF54, 0xFE9B, 0x0200, 0x0377, 0x0000}, // 601 full
-    {0x0254, 0x0000, 0x0396, 0x0254, 0xFF93, 0xFEEF, 0x0254, 0x043A, 0x0000}, // 709 limited
-    {0x0200, 0x0000, 0x0314, 0x0200, 0xFFA2, 0xFF16, 0x0200, 0x03A1, 0x0000}, // 709 full
-    {0x0254, 0x0000, 0x035B, 0x0254, 0xFFA0, 0xFEB3, 0x0254, 0x0449, 0x0000}, // 2020 limited
-    {0x0200, 0x0000, 0x02E2, 0x0200, 0xFFAE, 0xFEE2, 0x0200, 0x03AE, 0x0000}, // 2020 full
-    {0x0254, 0x0000, 0x03AE, 0x0254, 0xFF96, 0xFEEE, 0x0254, 0x0456, 0x0000}, // DCI-P3 limited
-    {0x0200, 0x0000, 0x0329, 0x0200, 0xFFA5, 0xFF15, 0x0200, 0x03B9, 0x0000}, // DCI-P3 full
-};
-
 static uint16_t sRGB2YCbCrCoefficients[G2D_CSC_STD_COUNT * G2D_CSC_RANGE_COUNT][9] = {
     {0x0083, 0x0102, 0x0032, 0xFFB4, 0xFF6B, 0x00E1, 0x00E1, 0xFF44, 0xFFDB}, // 601 limited
     {0x0099, 0x012D, 0x003A, 0xFFA8, 0xFF53, 0x0106, 0x0106, 0xFF25, 0xFFD5}, // 601 full
@@ -167,7 +126,7 @@ public:
     }
 
 private:
-    void writeSingle(unsigned int base, g2d_reg regs[], uint16_t matrix[9]) {
+    void writeSingle(unsigned int base, g2d_reg regs[], const uint16_t matrix[9]) {
         for (unsigned int idx = 0; idx < CSC_MATRIX_REGISTER_COUNT; idx++) {
             regs[idx].offset = base;
             regs[idx].value = matrix[idx];
@@ -562,6 +521,8 @@ AcrylicCompositorG2D::AcrylicCompositorG2D(const HW2DCapability &capability, boo
 
     mUsePolyPhaseFilter = getCapabilities().supportedMinDecimation() == hw2d_coord_t{4, 4};
 
+    invalidateCommandCache();
+
     ALOGD_TEST("Created a new Acrylic for G2D on %p", this);
 }
 
@@ -637,15 +598,78 @@ static lossy_formats sbwc_lossy_formats[] {
 };
 
 
-bool AcrylicCompositorG2D::prepareImage(AcrylicCanvas &layer, struct g2d_layer &image, uint32_t cmd[], int index)
+/*
+ * Configure the buffers and the acquire fence of @image. They are the only part of
+ * the image descriptor that changes every frame. image.num_buffers should be
+ * configured in advance.
+ */
+static bool prepareImageBuffer(AcrylicCanvas &layer, struct g2d_layer &image)
 {
-    image.flags = 0;
+    image.flags &= ~G2D_LAYERFLAG_ACQUIRE_FENCE;
 
     if (layer.getFence() >= 0) {
         image.flags |= G2D_LAYERFLAG_ACQUIRE_FENCE;
         image.fence = layer.getFence();
     }
 
+    if (layer.getBufferType() == AcrylicCanvas::MT_EMPTY) {
+        image.buffer_type = G2D_BUFTYPE_EMPTY;
+        return true;
+    }
+
+    if (layer.getBufferCount() < image.num_buffers) {
+        ALOGE("HAL Format %#x requires %d buffers but %d buffers are given",
+                layer.getFormat(), image.num_buffers, layer.getBufferCount());
+        return false;
+    }
+
+    if (layer.getBufferType() == AcrylicCanvas::MT_DMABUF) {
+        image.buffer_type = G2D_BUFTYPE_DMABUF;
+        for (unsigned int i = 0; i < image.num_buffers; i++) {
+            image.buffer[i].dmabuf.fd = layer.getDmabuf(i);
+            image.buffer[i].dmabuf.offset = layer.getOffset(i);
+            image.buffer[i].length = layer.getBufferLength(i);
+        }
+    } else {
+        LOGASSERT(layer.getBufferType() == AcrylicCanvas::MT_USERPTR,
+                  "Unknown buffer type %d", layer.getBufferType());
+        image.buffer_type = G2D_BUFTYPE_USERPTR;
+        for (unsigned int i = 0; i < image.num_buffers; i++) {
+            image.buffer[i].userptr = layer.getUserptr(i);
+            image.buffer[i].length = layer.getBufferLength(i);
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The attributes of the canvas that affect the commands of the image.
+ */
+static uint32_t getCanvasAttributes(AcrylicCanvas &canvas)
+{
+    uint32_t attr = AcrylicCanvas::ATTR_NONE;
+
+    if (canvas.isProtected())
+        attr |= AcrylicCanvas::ATTR_PROTECTED;
+    if (canvas.isCompressed())
+        attr |= AcrylicCanvas::ATTR_COMPRESSED;
+    if (canvas.isUOrder())
+        attr |= AcrylicCanvas::ATTR_UORDER;
+    if (canvas.isOTF())
+        attr |= AcrylicCanvas::ATTR_OTF;
+    if (canvas.isSolidColor())
+        attr |= AcrylicCanvas::ATTR_SOLIDCOLOR;
+    if (canvas.isCompressedWideblk())
+        attr |= AcrylicCanvas::ATTR_COMPRESSED_WIDEBLK;
+
+    return attr;
+}
+
+bool AcrylicCompositorG2D::prepareImage(AcrylicCanvas &layer, struct g2d_layer &image, uint32_t cmd[], int index)
+{
+    image.flags = 0;
+
     if (layer.isProtected())
         image.flags |= G2D_LAYERFLAG_SECURE;
 
@@ -661,35 +685,11 @@ bool AcrylicCompositorG2D::prepareImage(AcrylicCanvas &layer, struct g2d_layer &
         }
     }
 
-    if (layer.getBufferType() == AcrylicCanvas::MT_EMPTY) {
-        image.buffer_type = G2D_BUFTYPE_EMPTY;
-    } else {
-        if (layer.getBufferCount() < g2dfmt->num_bufs) {
-            ALOGE("HAL Format %#x requires %d buffers but %d buffers are given",
-                    layer.getFormat(), g2dfmt->num_bufs, layer.getBufferCount());
-            return false;
-        }
-
-        if (layer.getBufferType() == AcrylicCanvas::MT_DMABUF) {
-            image.buffer_type = G2D_BUFTYPE_DMABUF;
-            for (unsigned int i = 0; i < g2dfmt->num_bufs; i++) {
-                image.buffer[i].dmabuf.fd = layer.getDmabuf(i);
-                image.buffer[i].dmabuf.offset = layer.getOffset(i);
-                image.buffer[i].length = layer.getBufferLength(i);
-            }
-        } else {
-            LOGASSERT(layer.getBufferType() == AcrylicCanvas::MT_USERPTR,
-                      "Unknown buffer type %d", layer.getBufferType());
-            image.buffer_type = G2D_BUFTYPE_USERPTR;
-            for (unsigned int i = 0; i < g2dfmt->num_bufs; i++) {
-                image.buffer[i].userptr = layer.getUserptr(i);
-                image.buffer[i].length = layer.getBufferLength(i);
-            }
-        }
-    }
-
     image.num_buffers = g2dfmt->num_bufs;
 
+    if (!prepareImageBuffer(layer, image))
+        return false;
+
     hw2d_coord_t xy = layer.getImageDimension();
 
     cmd[G2DSFR_IMG_COLORMODE] = g2dfmt->g2dfmt;
@@ -997,6 +997,8 @@ bool AcrylicCompositorG2D::reallocLayer(unsigned int layercount)
 
     mMaxSourceCount = 0;
 
+    invalidateCommandCache();
+
     mTask.source = new g2d_layer[layercount];
     if (!mTask.source) {
         ALOGE("Failed to allocate %u source image descriptors", layercount);
@@ -1024,6 +1026,93 @@ bool AcrylicCompositorG2D::reallocLayer(unsigned int layercount)
     return true;
 }
 
+void AcrylicCompositorG2D::invalidateCommandCache()
+{
+    for (auto &cache : mSourceCache)
+        cache.valid = false;
+
+    mTargetCacheValid = false;
+    mFilterLayerCount = 0;
+    mFilterCoefficients.clear();
+}
+
+bool AcrylicCompositorG2D::reuseSource(AcrylicLayer &layer, unsigned int index, unsigned int image_index,
+                                       hw2d_coord_t target_size)
+{
+    G2DSourceCache &cache = mSourceCache[index];
+
+    if (!cache.valid || (cache.layer != &layer))
+        return false;
+
+    // Format, dataspace and dimension are unchanged if they are not modified
+    // since the last execution by the same layer
+    if (layer.getSettingFlags() & (AcrylicCanvas::SETTING_TYPE_MODIFIED |
+                                   AcrylicCanvas::SETTING_DIMENSION_MODIFIED))
+        return false;
+
+    if ((cache.image_index != image_index) ||
+            (cache.target_size != target_size) ||
+            (cache.crop != layer.getImageRect()) ||
+            (cache.window != layer.getTargetRect()) ||
+            (cache.attr != getCanvasAttributes(layer)) ||
+            (cache.blending != layer.getCompositingMode()) ||
+            (cache.transform != layer.getTransform()) ||
+            (cache.solid_color != layer.getSolidColor()) ||
+            (cache.alpha != layer.getPlaneAlpha()))
+        return false;
+
+    // The cached commands are the ones before CSC and HDR configuration
+    // that are applied every execution
+    memcpy(mTask.commands.source[index], cache.cmd, sizeof(cache.cmd));
+
+    if (layer.isSolidColor())
+        return true;
+
+    return prepareImageBuffer(layer, mTask.source[index]);
+}
+
+void AcrylicCompositorG2D::storeSource(AcrylicLayer &layer, unsigned int index, unsigned int image_index,
+                                       hw2d_coord_t target_size)
+{
+    G2DSourceCache &cache = mSourceCache[index];
+
+    cache.layer = &layer;
+    cache.image_index = image_index;
+    cache.target_size = target_size;
+    cache.crop = layer.getImageRect();
+    cache.window = layer.getTargetRect();
+    cache.attr = getCanvasAttributes(layer);
+    cache.blending = layer.getCompositingMode();
+    cache.transform = layer.getTransform();
+    cache.solid_color = layer.getSolidColor();
+    cache.alpha = layer.getPlaneAlpha();
+    memcpy(cache.cmd, mTask.commands.source[index], sizeof(cache.cmd));
+    cache.valid = true;
+}
+
+void AcrylicCompositorG2D::updateFilterCoefficientCache(unsigned int layercount)
+{
+    bool modified = mFilterLayerCount != layercount;
+
+    // Filter coefficients are determined by the scaling factors and the color format
+    for (unsigned int i = 0; i < layercount; i++) {
+        uint32_t *cmd = mTask.commands.source[i];
+        uint32_t keys[3] = {cmd[G2DSFR_SRC_XSCALE], cmd[G2DSFR_SRC_YSCALE], cmd[G2DSFR_IMG_COLORMODE]};
+
+        if (memcmp(mFilterKeys[i], keys, sizeof(keys)) != 0) {
+            memcpy(mFilterKeys[i], keys, sizeof(keys));
+            modified = true;
+        }
+    }
+
+    if (!modified)
+        return;
+
+    mFilterCoefficients.resize(getFilterCoefficientCount(mTask.commands.source, layercount));
+    updateFilterCoefficients(layercount, mFilterCoefficients.data());
+    mFilterLayerCount = layercount;
+}
+
 int AcrylicCompositorG2D::ioctlG2D(void)
 {
     if (mVersion == 1) {
@@ -1091,11 +1180,23 @@ bool AcrylicCompositorG2D::executeG2D(int fence[], unsigned int num_fences, bool
 
     mTask.flags = 0;
 
-    if (!prepareImage(getCanvas(), mTask.target, mTask.commands.target, -1)) {
+    uint32_t target_attr = getCanvasAttributes(getCanvas());
+    bool target_reusable = mTargetCacheValid && (mTargetAttr == target_attr) &&
+                           !(getCanvas().getSettingFlags() & (AcrylicCanvas::SETTING_TYPE_MODIFIED |
+                                                              AcrylicCanvas::SETTING_DIMENSION_MODIFIED));
+    mTargetCacheValid = false;
+
+    if (target_reusable) {
+        if (!prepareImageBuffer(getCanvas(), mTask.target))
+            return false;
+    } else if (!prepareImage(getCanvas(), mTask.target, mTask.commands.target, -1)) {
         ALOGE("Failed to configure the target image");
         return false;
     }
 
+    mTargetAttr = target_attr;
+    mTargetCacheValid = true;
+
     if (getCanvas().isOTF())
         mTask.flags |= G2D_FLAG_HWFC;
 
@@ -1104,6 +1205,7 @@ bool AcrylicCompositorG2D::executeG2D(int fence[], unsigned int num_fences, bool
     if (hasBackground) {
         baseidx++;
         prepareSolidLayer(getCanvas(), mTask.source[0], mTask.commands.source[0]);
+        mSourceCache[0].valid = false;
     }
 
     mTask.commands.target[G2DSFR_DST_YCBCRMODE] = 0;
@@ -1114,14 +1216,31 @@ bool AcrylicCompositorG2D::executeG2D(int fence[], unsigned int num_fences, bool
 
     mTask.commands.target[G2DSFR_DST_YCBCRMODE] |= (G2D_LAYER_YCBCRMODE_OFFX | G2D_LAYER_YCBCRMODE_OFFY);
 
+    unsigned int num_reused = 0;
+    int64_t saved_nsec = 0;
+
     for (unsigned int i = baseidx; i < layercount; i++) {
         AcrylicLayer &layer = *getLayer(i - baseidx);
+        hw2d_coord_t target_size = getCanvas().getImageDimension();
+        auto start = std::chrono::steady_clock::now();
+
+        if (reuseSource(layer, i, i - baseidx, target_size)) {
+            int64_t reuse_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - start).count();
+            saved_nsec += std::max<int64_t>(mSourceCache[i].build_nsec - reuse_nsec, 0);
+            num_reused++;
+        } else {
+            mSourceCache[i].valid = false;
 
-        if (!prepareSource(layer, mTask.source[i],
-                           mTask.commands.source[i], getCanvas().getImageDimension(),
-                           i, i - baseidx)) {
-            ALOGE("Failed to configure source layer %u", i - baseidx);
-            return false;
+            if (!prepareSource(layer, mTask.source[i], mTask.commands.source[i],
+                               target_size, i, i - baseidx)) {
+                ALOGE("Failed to configure source layer %u", i - baseidx);
+                return false;
+            }
+
+            storeSource(layer, i, i - baseidx, target_size);
+            mSourceCache[i].build_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - start).count();
         }
 
         if (!cscMatrixWriter.configure(mTask.commands.source[i][G2DSFR_IMG_COLORMODE],
@@ -1158,10 +1277,17 @@ bool AcrylicCompositorG2D::executeG2D(int fence[], unsigned int num_fences, bool
     mTask.num_release_fences = num_fences;
     mTask.release_fence = reinterpret_cast<int *>(alloca(sizeof(int) * num_fences));
 
-    mTask.commands.num_extra_regs = cscMatrixWriter.getRegisterCount() +
-                                    mHdrWriter.getCommandCount();
+    ATRACE_INT("G2D reused source commands", num_reused);
+    ATRACE_INT("G2D saved source command build usec", static_cast<int32_t>(saved_nsec / 1000));
+    ALOGD_TEST("Reused the commands of %u/%u source images, saving %lld nsec", num_reused,
+               layercount - baseidx, static_cast<long long>(saved_nsec));
+
     if (mUsePolyPhaseFilter)
-        mTask.commands.num_extra_regs += getFilterCoefficientCount(mTask.commands.source, layercount);
+        updateFilterCoefficientCache(layercount);
+
+    mTask.commands.num_extra_regs = cscMatrixWriter.getRegisterCount() +
+                                    mHdrWriter.getCommandCount() +
+                                    mFilterCoefficients.size();
 
     mTask.commands.extra = reinterpret_cast<g2d_reg *>(alloca(sizeof(g2d_reg) * mTask.commands.num_extra_regs));
 
@@ -1169,7 +1295,10 @@ bool AcrylicCompositorG2D::executeG2D(int fence[], unsigned int num_fences, bool
 
     regs += cscMatrixWriter.write(regs);
 
-    regs += updateFilterCoefficients(layercount, regs);
+    if (!mFilterCoefficients.empty()) {
+        memcpy(regs, mFilterCoefficients.data(), sizeof(*regs) * mFilterCoefficients.size());
+        regs += mFilterCoefficients.size();
+    }
 
     mHdrWriter.write(regs);
 
@@ -19,6 +19,7 @@
 #define __HARDWARE_EXYNOS_HW2DCOMPOSITOR_G2D_H__
 
 #include <memory>
+#include <vector>
 
 #include <hardware/exynos/acryl.h>
 
@@ -29,6 +30,13 @@
 #include "acrylic_internal.h"
 #include "acrylic_device.h"
 
+#ifdef LIBACRYL_G2D_EMULATOR
+#include "acrylic_g2d_emulator.h"
+typedef AcrylicG2DEmulator G2DDevice;
+#else
+typedef AcrylicDevice G2DDevice;
+#endif
+
 class G2DHdrWriter {
     std::unique_ptr<IG2DHdr10CommandWriter> mWriter;
     g2d_commandlist *mCmds = nullptr;
@@ -117,6 +125,31 @@ public:
 
 struct g2d_fmt;
 
+/*
+ * G2DSourceCache - the commands of a source image built by the previous execution
+ *
+ * The commands of a source image depend on the configurations below in addition
+ * to the image format and the image dimension that are tracked by the setting
+ * flags of AcrylicCanvas. The commands are reused as long as none of them are
+ * changed. Only the buffers and the acquire fence are updated in that case.
+ * build_nsec is the time taken to build the commands, which is what a reuse saves.
+ */
+struct G2DSourceCache {
+    bool valid;
+    AcrylicLayer *layer;
+    unsigned int image_index;
+    hw2d_coord_t target_size;
+    hw2d_rect_t crop;
+    hw2d_rect_t window;
+    uint32_t attr;
+    uint32_t blending;
+    uint32_t transform;
+    uint32_t solid_color;
+    uint8_t alpha;
+    uint32_t cmd[G2DSFR_SRC_FIELD_COUNT];
+    int64_t build_nsec;
+};
+
 class AcrylicCompositorG2D: public Acrylic {
 public:
     AcrylicCompositorG2D(const HW2DCapability &capability, bool newcolormode);
@@ -143,8 +176,14 @@ private:
     bool prepareSolidLayer(AcrylicLayer &layer, struct g2d_layer &image, uint32_t cmd[], hw2d_coord_t target_size, unsigned int index);
     bool reallocLayer(unsigned int layercount);
     unsigned int updateFilterCoefficients(unsigned int layercount, g2d_reg regs[]);
-
-    AcrylicDevice mDev;
+    bool reuseSource(AcrylicLayer &layer, unsigned int index, unsigned int image_index,
+                     hw2d_coord_t target_size);
+    void storeSource(AcrylicLayer &layer, unsigned int index, unsigned int image_index,
+                     hw2d_coord_t target_size);
+    void updateFilterCoefficientCache(unsigned int layercount);
+    void invalidateCommandCache();
+
+    G2DDevice     mDev;
     g2d_task	  mTask;
     G2DHdrWriter  mHdrWriter;
     unsigned int  mMaxSourceCount;
@@ -152,6 +191,13 @@ private:
     unsigned int mVersion;
     bool mUsePolyPhaseFilter;
 
+    G2DSourceCache mSourceCache[G2D_MAX_IMAGES];
+    bool mTargetCacheValid;
+    uint32_t mTargetAttr;
+    std::vector<g2d_reg> mFilterCoefficients;
+    uint32_t mFilterKeys[G2D_MAX_IMAGES][3];
+    unsigned int mFilterLayerCount;
+
     g2d_fmt *halfmt_to_g2dfmt_tbl;
     size_t len_halfmt_to_g2dfmt_tbl;
 };
@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include "acrylic_g2d_emulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <log/log.h>
+#include <sync/sync.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "acrylic_internal.h"
+
+#define G2D_EMUL_VERSION          1
+#define G2D_EMUL_FENCE_TIMEOUT_MS 1000
+
+/*
+ * The ABI of sw_sync. The header of libsync that declares it is private and
+ * the same declarations are in libhwc2.1/include/exynos_sync.h.
+ */
+#define G2D_EMUL_SW_SYNC_DEBUGFS  "/sys/kernel/debug/sync/sw_sync"
+#define G2D_EMUL_SW_SYNC_DEV      "/dev/sw_sync"
+
+struct g2d_emul_sw_sync_create_fence_data {
+    __u32 value;
+    char name[32];
+    __s32 fence;
+};
+
+#define G2D_EMUL_SW_SYNC_IOC_MAGIC        'W'
+#define G2D_EMUL_SW_SYNC_IOC_CREATE_FENCE \
+        _IOWR(G2D_EMUL_SW_SYNC_IOC_MAGIC, 0, struct g2d_emul_sw_sync_create_fence_data)
+#define G2D_EMUL_SW_SYNC_IOC_INC          _IOW(G2D_EMUL_SW_SYNC_IOC_MAGIC, 1, __u32)
+
+// The layout of the CSC matrices written by CSCMatrixWriter in acrylic_g2d.cpp
+#define G2D_EMUL_CSC_SRC_BASE     0x2000
+#define G2D_EMUL_CSC_COEF_COUNT   9
+#define G2D_EMUL_CSC_MAX_MATRICES 4
+
+struct G2DEmulPixel {
+    float r, g, b, a;
+};
+
+struct G2DEmulImage {
+    uint32_t colormode;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    uint8_t *plane[2];
+    void *map[G2D_MAX_BUFFERS];
+    size_t map_len[G2D_MAX_BUFFERS];
+    int map_fd[G2D_MAX_BUFFERS];
+    unsigned int num_maps;
+};
+
+struct G2DEmulCSC {
+    int16_t coef[G2D_EMUL_CSC_MAX_MATRICES][G2D_EMUL_CSC_COEF_COUNT];
+};
+
+static void syncDmabuf(int fd, uint64_t flags)
+{
+    struct dma_buf_sync sync = { flags };
+
+    if (::ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0)
+        ALOGERR("Failed to sync dmabuf %d with flags %#llx", fd, static_cast<unsigned long long>(flags));
+}
+
+static void unmapImage(G2DEmulImage &img)
+{
+    for (unsigned int i = 0; i < img.num_maps; i++) {
+        syncDmabuf(img.map_fd[i], DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+        munmap(img.map[i], img.map_len[i]);
+    }
+
+    img.num_maps = 0;
+}
+
+static bool waitFence(const g2d_layer &layer)
+{
+    if (!(layer.flags & G2D_LAYERFLAG_ACQUIRE_FENCE) || (layer.fence < 0))
+        return true;
+
+    if (sync_wait(layer.fence, G2D_EMUL_FENCE_TIMEOUT_MS) < 0) {
+        ALOGERR("Failed to wait for acquire fence %d", layer.fence);
+        return false;
+    }
+
+    return true;
+}
+
+static bool mapImage(const g2d_layer &layer, const uint32_t cmd[], G2DEmulImage &img)
+{
+    img.colormode = cmd[G2DSFR_IMG_COLORMODE];
+    img.width = static_cast<int32_t>(cmd[G2DSFR_IMG_WIDTH]);
+    img.height = static_cast<int32_t>(cmd[G2DSFR_IMG_HEIGHT]);
+    img.stride = static_cast<int32_t>(cmd[G2DSFR_IMG_STRIDE]);
+    img.num_maps = 0;
+
+    if (layer.flags & G2D_LAYERFLAG_COLORFILL)
+        return true;
+
+    if (img.colormode & (G2D_DATAFORMAT_AFBC | G2D_DATAFORMAT_UORDER | G2D_DATAFORMAT_SBWC)) {
+        ALOGE("Compressed or U-Order image of colormode %#x is not emulated", img.colormode);
+        return false;
+    }
+
+    if (layer.flags & (G2D_LAYERFLAG_SECURE | G2D_LAYERFLAG_MFC_STRIDE)) {
+        ALOGE("Secure image or MFC stride (flags %#x) is not emulated", layer.flags);
+        return false;
+    }
+
+    size_t plane0_len;
+    uint32_t datafmt = img.colormode & G2D_DATAFMT_MASK;
+
+    if (IS_YUV(img.colormode)) {
+        if ((datafmt != G2D_DATAFMT_YUV420SP) || (img.colormode & G2D_FMT_YCBCR_BITDEPTH_MASK)) {
+            ALOGE("YCbCr colormode %#x is not emulated", img.colormode);
+            return false;
+        }
+        // G2D calculates the stride of YCbCr images from the width
+        img.stride = img.width;
+        plane0_len = img.stride * img.height;
+    } else {
+        if ((datafmt != G2D_DATAFMT_8888) && (datafmt != G2D_DATAFMT_888) && (datafmt != G2D_DATAFMT_565)) {
+            ALOGE("RGB colormode %#x is not emulated", img.colormode);
+            return false;
+        }
+        plane0_len = img.stride * img.height;
+    }
+
+    if ((layer.num_buffers == 0) || (layer.num_buffers > 2)) {
+        ALOGE("Invalid number of buffers %u", layer.num_buffers);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < layer.num_buffers; i++) {
+        if (layer.buffer_type == G2D_BUFTYPE_USERPTR) {
+            img.plane[i] = static_cast<uint8_t *>(layer.buffer[i].userptr);
+        } else if (layer.buffer_type == G2D_BUFTYPE_DMABUF) {
+            size_t len = layer.buffer[i].dmabuf.offset + layer.buffer[i].length;
+            void *addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, layer.buffer[i].dmabuf.fd, 0);
+            if (addr == MAP_FAILED) {
+                ALOGERR("Failed to map dmabuf %d of %zu bytes", layer.buffer[i].dmabuf.fd, len);
+                unmapImage(img);
+                return false;
+            }
+
+            img.map[img.num_maps] = addr;
+            img.map_len[img.num_maps] = len;
+            img.map_fd[img.num_maps] = layer.buffer[i].dmabuf.fd;
+            img.num_maps++;
+
+            syncDmabuf(layer.buffer[i].dmabuf.fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+
+            img.plane[i] = static_cast<uint8_t *>(addr) + layer.buffer[i].dmabuf.offset;
+        } else {
+            ALOGE("Invalid buffer type %u", layer.buffer_type);
+            unmapImage(img);
+            return false;
+        }
+    }
+
+    size_t required = plane0_len;
+    if (IS_YUV(img.colormode)) {
+        if (layer.num_buffers == 1) {
+            img.plane[1] = img.plane[0] + plane0_len;
+            required += plane0_len / 2;
+        } else if (layer.buffer[1].length < plane0_len / 2) {
+            ALOGE("Too small chroma buffer %u for %dx%d", layer.buffer[1].length, img.width, img.height);
+            unmapImage(img);
+            return false;
+        }
+    }
+
+    if (layer.buffer[0].length < required) {
+        ALOGE("Too small buffer %u for %dx%d of colormode %#x (%zu bytes required)",
+              layer.buffer[0].length, img.width, img.height, img.colormode, required);
+        unmapImage(img);
+        return false;
+    }
+
+    return true;
+}
+
+static inline float swizzle(const float comp[4], uint32_t colormode, unsigned int channel)
+{
+    unsigned int sel = (colormode >> (channel * 4)) & 0xF;
+
+    // the selector 5 configures the channel to be always one.
+    return (sel < 4) ? comp[sel] : 1.0f;
+}
+
+static G2DEmulPixel loadRGB(const G2DEmulImage &img, int32_t x, int32_t y)
+{
+    const uint8_t *p = img.plane[0] + y * img.stride;
+    float comp[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+    switch (img.colormode & G2D_DATAFMT_MASK) {
+    case G2D_DATAFMT_8888:
+        p += x * 4;
+        for (int i = 0; i < 4; i++)
+            comp[i] = p[i] / 255.0f;
+        break;
+    case G2D_DATAFMT_888:
+        p += x * 3;
+        for (int i = 0; i < 3; i++)
+            comp[i] = p[i] / 255.0f;
+        break;
+    default: { // G2D_DATAFMT_565
+        p += x * 2;
+        uint16_t v = p[0] | (p[1] << 8);
+        comp[0] = (v & 0x1F) / 31.0f;
+        comp[1] = ((v >> 5) & 0x3F) / 63.0f;
+        comp[2] = (v >> 11) / 31.0f;
+        break;
+    }
+    }
+
+    return {swizzle(comp, img.colormode, 2), swizzle(comp, img.colormode, 1),
+            swizzle(comp, img.colormode, 0), swizzle(comp, img.colormode, 3)};
+}
+
+static G2DEmulPixel loadYCbCr(const G2DEmulImage &img, int32_t x, int32_t y,
+                              const int16_t coef[G2D_EMUL_CSC_COEF_COUNT], bool wide)
+{
+    const uint8_t *c = img.plane[1] + (y / 2) * img.stride + (x & ~1);
+    float yv = img.plane[0][y * img.stride + x] - (wide ? 0.0f : 16.0f);
+    float cb = c[0] - 128.0f;
+    float cr = c[1] - 128.0f;
+
+    if ((img.colormode & G2D_YUVORDER_MASK) != (G2D_FMT_NV12 & G2D_YUVORDER_MASK))
+        std::swap(cb, cr);
+
+    float rgb[3];
+    for (int i = 0; i < 3; i++) {
+        float v = (coef[i * 3] * yv + coef[i * 3 + 1] * cb + coef[i * 3 + 2] * cr) / 512.0f;
+        rgb[i] = std::min(std::max(v / 255.0f, 0.0f), 1.0f);
+    }
+
+    return {rgb[0], rgb[1], rgb[2], 1.0f};
+}
+
+static void storeRGB(G2DEmulImage &img, int32_t x, int32_t y, const G2DEmulPixel &px)
+{
+    uint8_t *p = img.plane[0] + y * img.stride;
+    const float channels[4] = {px.b, px.g, px.r, px.a};
+    float comp[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    for (unsigned int ch = 0; ch < 4; ch++) {
+        unsigned int sel = (img.colormode >> (ch * 4)) & 0xF;
+        if (sel < 4)
+            comp[sel] = channels[ch];
+    }
+
+    switch (img.colormode & G2D_DATAFMT_MASK) {
+    case G2D_DATAFMT_8888:
+        p += x * 4;
+        for (int i = 0; i < 4; i++)
+            p[i] = static_cast<uint8_t>(lroundf(comp[i] * 255.0f));
+        break;
+    case G2D_DATAFMT_888:
+        p += x * 3;
+        for (int i = 0; i < 3; i++)
+            p[i] = static_cast<uint8_t>(lroundf(comp[i] * 255.0f));
+        break;
+    default: { // G2D_DATAFMT_565
+        p += x * 2;
+        uint16_t v = static_cast<uint16_t>(lroundf(comp[0] * 31.0f)) |
+                     (static_cast<uint16_t>(lroundf(comp[1] * 63.0f)) << 5) |
+                     (static_cast<uint16_t>(lroundf(comp[2] * 31.0f)) << 11);
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+        break;
+    }
+    }
+}
+
+class G2DEmulSource {
+public:
+    G2DEmulSource(const G2DEmulImage &img, const uint32_t cmd[], const G2DEmulCSC &csc)
+        : mImage(img), mLeft(cmd[G2DSFR_IMG_LEFT]), mTop(cmd[G2DSFR_IMG_TOP]),
+          mRight(cmd[G2DSFR_IMG_RIGHT] - 1), mBottom(cmd[G2DSFR_IMG_BOTTOM] - 1),
+          mYCbCr(IS_YUV(img.colormode)),
+          mWide(!!(cmd[G2DSFR_SRC_YCBCRMODE] & G2D_LAYER_YCBCRMODE_WIDE)),
+          mCoef(csc.coef[cmd[G2DSFR_SRC_YCBCRMODE] & (G2D_EMUL_CSC_MAX_MATRICES - 1)]) {
+    }
+
+    G2DEmulPixel fetch(int32_t x, int32_t y) const {
+        x = std::min(std::max(x, mLeft), mRight);
+        y = std::min(std::max(y, mTop), mBottom);
+
+        return mYCbCr ? loadYCbCr(mImage, x, y, mCoef, mWide) : loadRGB(mImage, x, y);
+    }
+
+    G2DEmulPixel nearest(float sx, float sy) const {
+        return fetch(static_cast<int32_t>(floorf(sx + 0.5f)), static_cast<int32_t>(floorf(sy + 0.5f)));
+    }
+
+    G2DEmulPixel bilinear(float sx, float sy) const {
+        float fx = floorf(sx), fy = floorf(sy);
+        float wx = sx - fx, wy = sy - fy;
+        int32_t x = static_cast<int32_t>(fx), y = static_cast<int32_t>(fy);
+        G2DEmulPixel p00 = fetch(x, y), p01 = fetch(x + 1, y);
+        G2DEmulPixel p10 = fetch(x, y + 1), p11 = fetch(x + 1, y + 1);
+        auto lerp = [wx, wy](float v00, float v01, float v10, float v11) {
+            return (v00 * (1 - wx) + v01 * wx) * (1 - wy) + (v10 * (1 - wx) + v11 * wx) * wy;
+        };
+
+        return {lerp(p00.r, p01.r, p10.r, p11.r), lerp(p00.g, p01.g, p10.g, p11.g),
+                lerp(p00.b, p01.b, p10.b, p11.b), lerp(p00.a, p01.a, p10.a, p11.a)};
+    }
+
+private:
+    const G2DEmulImage &mImage;
+    int32_t mLeft, mTop, mRight, mBottom;
+    bool mYCbCr;
+    bool mWide;
+    const int16_t *mCoef;
+};
+
+static G2DEmulPixel blendPixel(uint32_t blend, float ga, const G2DEmulPixel &s, const G2DEmulPixel &d)
+{
+    float inv = 1.0f - s.a * ga;
+    float sm = (blend == G2D_BLEND_NONE) ? ga * s.a : ga;
+
+    if (blend == G2D_BLEND_SRCCOPY)
+        return {ga * s.r, ga * s.g, ga * s.b, ga * s.a};
+
+    return {sm * s.r + inv * d.r, sm * s.g + inv * d.g, sm * s.b + inv * d.b, ga * s.a + inv * d.a};
+}
+
+static bool composeSource(G2DEmulImage &target, const uint32_t tcmd[],
+                          const g2d_layer &layer, const uint32_t cmd[], const G2DEmulCSC &csc)
+{
+    uint32_t blend = cmd[G2DSFR_SRC_BLEND];
+    if ((blend != G2D_BLEND_NONE) && (blend != G2D_BLEND_SRCOVER) && (blend != G2D_BLEND_SRCCOPY)) {
+        ALOGE("Unknown blending mode %#x", blend);
+        return false;
+    }
+
+    if (cmd[G2DSFR_SRC_HDRMODE] != 0) {
+        ALOGE("HDR mode %#x is not emulated", cmd[G2DSFR_SRC_HDRMODE]);
+        return false;
+    }
+
+    G2DEmulImage img;
+    if (!waitFence(layer) || !mapImage(layer, cmd, img))
+        return false;
+
+    bool colorfill = (cmd[G2DSFR_SRC_SELECT] == G2D_LAYERSEL_COLORFILL);
+    uint32_t color = cmd[G2DSFR_SRC_COLOR];
+    G2DEmulPixel fill = {((color >> 16) & 0xFF) / 255.0f, ((color >> 8) & 0xFF) / 255.0f,
+                         (color & 0xFF) / 255.0f, (color >> 24) / 255.0f};
+
+    G2DEmulSource source(img, cmd, csc);
+
+    int32_t wl = cmd[G2DSFR_SRC_DSTLEFT], wt = cmd[G2DSFR_SRC_DSTTOP];
+    int32_t ww = cmd[G2DSFR_SRC_DSTRIGHT] - wl, wh = cmd[G2DSFR_SRC_DSTBOTTOM] - wt;
+    int32_t left = std::max(wl, static_cast<int32_t>(tcmd[G2DSFR_IMG_LEFT]));
+    int32_t top = std::max(wt, static_cast<int32_t>(tcmd[G2DSFR_IMG_TOP]));
+    int32_t right = std::min(wl + ww, static_cast<int32_t>(tcmd[G2DSFR_IMG_RIGHT]));
+    int32_t bottom = std::min(wt + wh, static_cast<int32_t>(tcmd[G2DSFR_IMG_BOTTOM]));
+
+    bool rot90 = !!(cmd[G2DSFR_SRC_ROTATE] & G2D_ROTATEDIR_ROT90CCW);
+    uint32_t flip = (cmd[G2DSFR_SRC_ROTATE] >> G2D_ROTATEDIR_FLIP_SHIFT) & 3;
+    float xscale = cmd[G2DSFR_SRC_XSCALE] / static_cast<float>(1 << G2D_SCALEFACTOR_FRACBITS);
+    float yscale = cmd[G2DSFR_SRC_YSCALE] / static_cast<float>(1 << G2D_SCALEFACTOR_FRACBITS);
+    bool interpolate = cmd[G2DSFR_SRC_SCALECONTROL] != 0;
+    bool opaque = !!(cmd[G2DSFR_SRC_COMMAND] & G2D_LAYERCMD_OPAQUE);
+    float ga = (cmd[G2DSFR_SRC_ALPHA] & 0xFF) / 255.0f;
+
+    for (int32_t y = top; y < bottom; y++) {
+        for (int32_t x = left; x < right; x++) {
+            G2DEmulPixel s = fill;
+
+            if (!colorfill) {
+                // Undo flip then 90 degree counter-clockwise rotation to find the
+                // position in the scaled source image
+                int32_t u = x - wl, v = y - wt;
+                if (flip & 1)
+                    u = ww - 1 - u;
+                if (flip & 2)
+                    v = wh - 1 - v;
+
+                int32_t a = rot90 ? (wh - 1 - v) : u;
+                int32_t b = rot90 ? u : v;
+                float sx = cmd[G2DSFR_IMG_LEFT] + (a + 0.5f) * xscale - 0.5f;
+                float sy = cmd[G2DSFR_IMG_TOP] + (b + 0.5f) * yscale - 0.5f;
+
+                s = interpolate ? source.bilinear(sx, sy) : source.nearest(sx, sy);
+            }
+
+            // The opaque layer does not read the target image
+            G2DEmulPixel d = opaque ? G2DEmulPixel{0.0f, 0.0f, 0.0f, 0.0f} : loadRGB(target, x, y);
+
+            storeRGB(target, x, y, blendPixel(blend, ga, s, d));
+        }
+    }
+
+    unmapImage(img);
+
+    return true;
+}
+
+static void decodeExtraRegisters(const g2d_commands &commands, G2DEmulCSC &csc)
+{
+    memset(&csc, 0, sizeof(csc));
+
+    for (unsigned int i = 0; i < commands.num_extra_regs; i++) {
+        uint32_t offset = commands.extra[i].offset;
+
+        if ((offset < G2D_EMUL_CSC_SRC_BASE) || (offset >= G2D_EMUL_CSC_SRC_BASE +
+                    G2D_EMUL_CSC_MAX_MATRICES * G2D_EMUL_CSC_COEF_COUNT * sizeof(uint32_t)))
+            continue;
+
+        unsigned int idx = (offset - G2D_EMUL_CSC_SRC_BASE) / sizeof(uint32_t);
+        csc.coef[idx / G2D_EMUL_CSC_COEF_COUNT][idx % G2D_EMUL_CSC_COEF_COUNT] =
+                static_cast<int16_t>(commands.extra[i].value);
+    }
+}
+
+AcrylicG2DEmulator::AcrylicG2DEmulator(const char *path)
+    : mDevPath(path), mPriority(-1), mTimelineValue(0)
+{
+    ALOGI("G2D emulator replaces %s", path);
+
+    mTimeline = open(G2D_EMUL_SW_SYNC_DEBUGFS, O_RDWR | O_CLOEXEC);
+    if (mTimeline < 0)
+        mTimeline = open(G2D_EMUL_SW_SYNC_DEV, O_RDWR | O_CLOEXEC);
+    if (mTimeline < 0)
+        ALOGW("sw_sync is not available: release fences of the G2D emulator are -1");
+}
+
+AcrylicG2DEmulator::~AcrylicG2DEmulator()
+{
+    // closing the timeline signals the fences that are not signaled yet
+    if (mTimeline >= 0)
+        close(mTimeline);
+}
+
+void AcrylicG2DEmulator::createReleaseFences(int32_t *fences, unsigned int count)
+{
+    count = std::min(count, static_cast<unsigned int>(G2D_MAX_RELEASE_FENCES));
+
+    for (unsigned int i = 0; i < count; i++)
+        fences[i] = -1;
+
+    if (mTimeline < 0)
+        return;
+
+    g2d_emul_sw_sync_create_fence_data data = {};
+    data.value = mTimelineValue + 1;
+    strncpy(data.name, "g2d_emul", sizeof(data.name) - 1);
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (::ioctl(mTimeline, G2D_EMUL_SW_SYNC_IOC_CREATE_FENCE, &data) < 0) {
+            ALOGE("Failed to create a release fence on sw_sync: %s", strerror(errno));
+            for (unsigned int k = 0; k < i; k++) {
+                close(fences[k]);
+                fences[k] = -1;
+            }
+            return;
+        }
+        fences[i] = data.fence;
+    }
+
+    // The task is already completed. Signal the fences before they are returned.
+    __u32 inc = 1;
+    if (::ioctl(mTimeline, G2D_EMUL_SW_SYNC_IOC_INC, &inc) < 0)
+        ALOGE("Failed to signal the release fences on sw_sync: %s", strerror(errno));
+    else
+        mTimelineValue++;
+}
+
+bool AcrylicG2DEmulator::process(g2d_task &task)
+{
+    ATRACE_CALL();
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t *tcmd = task.commands.target;
+
+    if (task.flags & G2D_FLAG_HWFC) {
+        ALOGE("HWFC target is not emulated");
+        return false;
+    }
+
+    if (IS_YUV(tcmd[G2DSFR_IMG_COLORMODE])) {
+        ALOGE("YCbCr target of colormode %#x is not emulated", tcmd[G2DSFR_IMG_COLORMODE]);
+        return false;
+    }
+
+    if (task.num_source > G2D_MAX_IMAGES) {
+        ALOGE("Too many source images %u", task.num_source);
+        return false;
+    }
+
+    G2DEmulCSC csc;
+    decodeExtraRegisters(task.commands, csc);
+
+    G2DEmulImage target;
+    if (!waitFence(task.target) || !mapImage(task.target, tcmd, target))
+        return false;
+
+    bool okay = true;
+    for (unsigned int i = 0; okay && (i < task.num_source); i++) {
+        if (!(task.commands.source[i][G2DSFR_SRC_COMMAND] & G2D_LAYERCMD_VALID))
+            continue;
+
+        okay = composeSource(target, tcmd, task.source[i], task.commands.source[i], csc);
+        if (!okay)
+            ALOGE("Failed to emulate source image %u", i);
+    }
+
+    unmapImage(target);
+
+    task.laptime_in_usec = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start).count());
+
+    return okay;
+}
+
+int AcrylicG2DEmulator::ioctl(int cmd, void *arg)
+{
+    switch (static_cast<unsigned int>(cmd)) {
+    case G2D_IOC_VERSION:
+        *static_cast<uint32_t *>(arg) = G2D_EMUL_VERSION;
+        return 0;
+    case G2D_IOC_PRIORITY:
+        mPriority = *static_cast<int32_t *>(arg);
+        return 0;
+    case G2D_IOC_PERFORMANCE:
+        return 0;
+    case G2D_IOC_PROCESS: {
+        g2d_task &task = *static_cast<g2d_task *>(arg);
+
+        if (!process(task))
+            task.flags |= G2D_FLAG_ERROR;
+
+        createReleaseFences(task.release_fence, task.num_release_fences);
+
+        return 0;
+    }
+    case G2D_IOC_COMPAT_PROCESS: {
+        g2d_compat_task &compat = *static_cast<g2d_compat_task *>(arg);
+        uint32_t target[G2DSFR_DST_FIELD_COUNT] = {};
+        g2d_task task;
+
+        memcpy(&task, &compat, sizeof(compat) - sizeof(compat.commands));
+        memcpy(target, compat.commands.target, sizeof(compat.commands.target));
+
+        task.commands.target = target;
+        for (unsigned int i = 0; i < G2D_MAX_IMAGES; i++)
+            task.commands.source[i] = compat.commands.source[i];
+        task.commands.extra = compat.commands.extra;
+        task.commands.num_extra_regs = compat.commands.num_extra_regs;
+
+        if (!process(task))
+            task.flags |= G2D_FLAG_ERROR;
+
+        compat.flags = task.flags;
+        compat.laptime_in_usec = task.laptime_in_usec;
+        createReleaseFences(compat.release_fence, compat.num_release_fences);
+
+        return 0;
+    }
+    default:
+        ALOGE("Unknown ioctl command %#x to the G2D emulator of %s", cmd, mDevPath.c_str());
+        errno = ENOTTY;
+        return -1;
+    }
+}
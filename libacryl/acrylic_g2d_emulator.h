@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_ACRYLIC_G2D_EMULATOR_H__
+#define __HARDWARE_EXYNOS_ACRYLIC_G2D_EMULATOR_H__
+
+#include <string>
+
+#include <uapi/g2d.h>
+
+/*
+ * AcrylicG2DEmulator - CPU stand-in for the G2D driver
+ *
+ * AcrylicG2DEmulator has the same interface as AcrylicDevice and takes its place
+ * in AcrylicCompositorG2D if LIBACRYL_G2D_EMULATOR is defined. It decodes the
+ * commands of G2D_IOC_PROCESS and G2D_IOC_COMPAT_PROCESS and processes them on
+ * the CPU so that AcrylicCompositorG2D is exercised and profiled without G2D.
+ *
+ * A task is completed before ioctl() returns. Therefore the release fences are
+ * created on a sw_sync timeline and signaled before they are returned, and
+ * laptime_in_usec is the time taken to process the task on the CPU. The release
+ * fences are -1 if sw_sync is not available.
+ *
+ * The emulator supports the uncompressed RGB formats of 8888, 888 and 565,
+ * 8-bit YCbCr 4:2:0 semi-planar sources, color fill, scaling, rotation, flip,
+ * plane alpha and the three blending modes of AcrylicCompositorG2D.
+ * Compressed images, YCbCr targets and HDR processing are rejected with
+ * G2D_FLAG_ERROR. Polyphase filter coefficients are ignored and scaling is
+ * always bilinear.
+ */
+class AcrylicG2DEmulator {
+public:
+    AcrylicG2DEmulator(const char *path);
+    ~AcrylicG2DEmulator();
+    int ioctl(int cmd, void *arg);
+private:
+    bool process(g2d_task &task);
+    void createReleaseFences(int32_t *fences, unsigned int count);
+
+    std::string mDevPath;
+    int32_t mPriority;
+    int mTimeline;
+    uint32_t mTimelineValue;
+};
+
+#endif //__HARDWARE_EXYNOS_ACRYLIC_G2D_EMULATOR_H__
@@ -0,0 +1,799 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include "acrylic_sw.h"
+
+#include <exynos_format.h> // hardware/smasung_slsi/exynos/include
+#include <hardware/hwcomposer2.h>
+#include <linux/dma-buf.h>
+#include <log/log.h>
+#include <sync/sync.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <system/graphics.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "acrylic_csc.h"
+
+/*
+ * The software compositor composes the target image in bands of SW_TILE_ROWS
+ * rows. Each band is processed row by row: the row of the target is loaded
+ * (or filled with the background color), every source layer is sampled into
+ * a row of separated 16-bit R, G, B and A lanes and blended, then the row is
+ * written back. The per-row kernels work on the separated lanes so that the
+ * compiler vectorizes them.
+ */
+#define SW_TILE_ROWS        32
+#define SW_MAX_WORKERS      3
+#define SW_FENCE_TIMEOUT_MS 1000
+
+static uint32_t all_sw_formats[] = {
+    HAL_PIXEL_FORMAT_RGBA_8888,
+    HAL_PIXEL_FORMAT_BGRA_8888,
+    HAL_PIXEL_FORMAT_RGBX_8888,
+    HAL_PIXEL_FORMAT_RGB_888,
+    HAL_PIXEL_FORMAT_RGB_565,
+    HAL_PIXEL_FORMAT_YCrCb_420_SP,
+    HAL_PIXEL_FORMAT_EXYNOS_YCrCb_420_SP_M,
+    HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP,
+    HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP_M,
+};
+
+static int all_sw_dataspaces[] = {
+    HAL_DATASPACE_UNKNOWN,
+    HAL_DATASPACE_SRGB,
+    HAL_DATASPACE_JFIF,
+    HAL_DATASPACE_BT601_525,
+    HAL_DATASPACE_BT601_625,
+    HAL_DATASPACE_BT709,
+    HAL_DATASPACE_STANDARD_BT709,
+    HAL_DATASPACE_STANDARD_BT709 | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_BT709 | HAL_DATASPACE_RANGE_LIMITED,
+    HAL_DATASPACE_STANDARD_BT601_625,
+    HAL_DATASPACE_STANDARD_BT601_625 | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_BT601_625 | HAL_DATASPACE_RANGE_LIMITED,
+    HAL_DATASPACE_STANDARD_BT601_525,
+    HAL_DATASPACE_STANDARD_BT601_525 | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_BT601_525 | HAL_DATASPACE_RANGE_LIMITED,
+    HAL_DATASPACE_STANDARD_BT2020,
+    HAL_DATASPACE_STANDARD_BT2020 | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_BT2020 | HAL_DATASPACE_RANGE_LIMITED,
+    HAL_DATASPACE_STANDARD_DCI_P3,
+    HAL_DATASPACE_STANDARD_DCI_P3 | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_DCI_P3 | HAL_DATASPACE_RANGE_LIMITED,
+    HAL_DATASPACE_STANDARD_FILM,
+    HAL_DATASPACE_STANDARD_FILM | HAL_DATASPACE_RANGE_FULL,
+    HAL_DATASPACE_STANDARD_FILM | HAL_DATASPACE_RANGE_LIMITED,
+};
+
+static const stHW2DCapability __capability_sw = {
+    {64, 64},       // max_upsampling_num
+    {16, 16},       // max_downsampling_factor
+    {64, 64},       // max_upsizing_num
+    {16, 16},       // max_downsizing_factor
+    {1, 1},         // min_src_dimension
+    {8192, 8192},   // max_src_dimension
+    {1, 1},         // min_dst_dimension
+    {8192, 8192},   // max_dst_dimension
+    {1, 1},         // min_pix_align
+    0,              // rescaling_count
+    HW2DCapability::BLEND_NONE | HW2DCapability::BLEND_SRC_COPY | HW2DCapability::BLEND_SRC_OVER,
+    HW2DCapability::TRANSFORM_ALL,
+    HW2DCapability::FEATURE_PLANE_ALPHA | HW2DCapability::FEATURE_SOLIDCOLOR,
+    ARRSIZE(all_sw_formats),
+    ARRSIZE(all_sw_dataspaces),
+    16,             // max_layers
+    all_sw_formats,
+    all_sw_dataspaces,
+    1,              // base_align
+};
+
+static const HW2DCapability capability_sw(__capability_sw);
+
+AcrylicTilePool::AcrylicTilePool(unsigned int num_workers)
+{
+    for (unsigned int i = 0; i < num_workers; i++)
+        mWorkers.emplace_back(&AcrylicTilePool::workerRoutine, this);
+}
+
+AcrylicTilePool::~AcrylicTilePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+    }
+    mWorkCondition.notify_all();
+
+    for (auto &worker : mWorkers)
+        worker.join();
+}
+
+void AcrylicTilePool::processTiles()
+{
+    unsigned int tile;
+
+    while ((tile = mNextTile.fetch_add(1, std::memory_order_relaxed)) < mNumTiles)
+        (*mFunc)(tile);
+}
+
+void AcrylicTilePool::run(unsigned int num_tiles, const std::function<void(unsigned int)> &func)
+{
+    if (mWorkers.empty() || (num_tiles < 2)) {
+        for (unsigned int i = 0; i < num_tiles; i++)
+            func(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFunc = &func;
+        mNumTiles = num_tiles;
+        mNextTile.store(0, std::memory_order_relaxed);
+        mBusyWorkers = static_cast<unsigned int>(mWorkers.size());
+        mGeneration++;
+    }
+    mWorkCondition.notify_all();
+
+    processTiles();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCondition.wait(lock, [this] { return mBusyWorkers == 0; });
+    mFunc = nullptr;
+}
+
+void AcrylicTilePool::workerRoutine()
+{
+    uint64_t generation = 0;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mWorkCondition.wait(lock, [&] { return mExit || (mGeneration != generation); });
+        if (mExit)
+            return;
+
+        generation = mGeneration;
+
+        lock.unlock();
+        processTiles();
+        lock.lock();
+
+        if (--mBusyWorkers == 0)
+            mDoneCondition.notify_one();
+    }
+}
+
+/*
+ * The image of a source layer or the target mapped to the CPU.
+ */
+struct AcrylicSWImage {
+    uint32_t format = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    uint8_t *plane[2] = {nullptr, nullptr};
+    uint32_t stride[2] = {0, 0};
+
+    void *mapped[MAX_HW2D_PLANES] = {nullptr, };
+    size_t mappedLen[MAX_HW2D_PLANES] = {0, };
+    int mappedFd[MAX_HW2D_PLANES] = {-1, -1, -1, -1};
+    bool writable = false;
+
+    bool solid = false;
+    uint32_t solidColor = 0;
+
+    /* YCbCr to RGB conversion */
+    bool ycbcr = false;
+    bool crcb = false;
+    int32_t csc[9] = {0, };
+    int32_t lumaOffset = 0;
+
+    /* compositing properties of a source layer */
+    hw2d_rect_t crop = {{0, 0}, {0, 0}};
+    hw2d_rect_t window = {{0, 0}, {0, 0}};
+    uint32_t transform = 0;
+    uint32_t blending = HWC_BLENDING_NONE;
+    uint8_t planeAlpha = 255;
+};
+
+/*
+ * A row of pixels in separated lanes. Color values are 8-bit wide in 16-bit
+ * lanes so that products of two 8-bit values do not overflow.
+ */
+struct AcrylicSWRow {
+    std::vector<uint16_t> r, g, b, a;
+
+    explicit AcrylicSWRow(size_t width) : r(width), g(width), b(width), a(width) { }
+
+    inline void set(int32_t x, uint32_t rgba)
+    {
+        r[x] = rgba & 0xFF;
+        g[x] = (rgba >> 8) & 0xFF;
+        b[x] = (rgba >> 16) & 0xFF;
+        a[x] = rgba >> 24;
+    }
+};
+
+static inline uint32_t packRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+static inline uint16_t div255(uint32_t v)
+{
+    v += 128;
+    return static_cast<uint16_t>((v + (v >> 8)) >> 8);
+}
+
+static inline int32_t clampInt(int32_t v, int32_t lo, int32_t hi)
+{
+    return std::min(std::max(v, lo), hi);
+}
+
+static bool isSupportedYCbCr(uint32_t fmt, bool *crcb)
+{
+    switch (fmt) {
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+    case HAL_PIXEL_FORMAT_EXYNOS_YCrCb_420_SP_M:
+        *crcb = true;
+        return true;
+    case HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP:
+    case HAL_PIXEL_FORMAT_EXYNOS_YCbCr_420_SP_M:
+        *crcb = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool configureCSC(AcrylicSWImage &image, int dataspace)
+{
+    unsigned int colorspace = (dataspace & HAL_DATASPACE_STANDARD_MASK) >> HAL_DATASPACE_STANDARD_SHIFT;
+
+    if ((colorspace >= ARRSIZE(csc_std_to_matrix_index)) ||
+            (csc_std_to_matrix_index[colorspace] == static_cast<char>(G2D_CSC_STD_UNDEFINED))) {
+        ALOGE("Data space %d is not supported by the software compositor", dataspace);
+        return false;
+    }
+
+    unsigned int index = csc_std_to_matrix_index[colorspace] * G2D_CSC_RANGE_COUNT;
+    bool full = (dataspace & HAL_DATASPACE_RANGE_FULL) != 0;
+    if (full)
+        index++;
+
+    for (int i = 0; i < 9; i++)
+        image.csc[i] = static_cast<int16_t>(YCbCr2sRGBCoefficients[index][i]);
+    image.lumaOffset = full ? 0 : 16;
+
+    return true;
+}
+
+static void unmapImage(AcrylicSWImage &image)
+{
+    for (int i = 0; i < MAX_HW2D_PLANES; i++) {
+        if (!image.mapped[i])
+            continue;
+
+        struct dma_buf_sync sync;
+        sync.flags = DMA_BUF_SYNC_END | (image.writable ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+        if (ioctl(image.mappedFd[i], DMA_BUF_IOCTL_SYNC, &sync) < 0)
+            ALOGERR("Failed to end CPU access to buffer[%d]", i);
+
+        munmap(image.mapped[i], image.mappedLen[i]);
+        image.mapped[i] = nullptr;
+    }
+}
+
+static bool mapImage(AcrylicCanvas &canvas, AcrylicSWImage &image, bool writable)
+{
+    hw2d_coord_t xy = canvas.getImageDimension();
+
+    image.format = canvas.getFormat();
+    image.width = xy.hori;
+    image.height = xy.vert;
+    image.writable = writable;
+
+    if (canvas.isSolidColor()) {
+        // mSolidColor is in ARGB order
+        uint32_t color = canvas.getSolidColor();
+        image.solid = true;
+        image.solidColor = packRGBA((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, color >> 24);
+        return true;
+    }
+
+    if (canvas.isProtected()) {
+        ALOGE("Protected buffers are not accessible by the software compositor");
+        return false;
+    }
+
+    if (canvas.getBufferType() == AcrylicCanvas::MT_EMPTY) {
+        ALOGE("OTF buffers are not accessible by the software compositor");
+        return false;
+    }
+
+    image.ycbcr = isSupportedYCbCr(image.format, &image.crcb);
+    if (image.ycbcr) {
+        if (writable) {
+            ALOGE("Writing YCbCr format %#x is not supported", image.format);
+            return false;
+        }
+        if (!configureCSC(image, canvas.getDataspace()))
+            return false;
+    }
+
+    unsigned int bufcnt = halfmt_buf_count(image.format);
+    if (canvas.getBufferCount() < bufcnt) {
+        ALOGE("HAL Format %#x requires %u buffers but %u buffers are given",
+              image.format, bufcnt, canvas.getBufferCount());
+        return false;
+    }
+
+    uint8_t *buffer[MAX_HW2D_PLANES] = {nullptr, };
+
+    for (unsigned int i = 0; i < bufcnt; i++) {
+        size_t len = canvas.getBufferLength(i);
+        size_t offset = canvas.getOffset(i);
+        size_t required = halfmt_plane_length(image.format, i, image.width, image.height);
+
+        if (len < offset + required) {
+            ALOGE("Too small buffer[%u] %zu bytes with offset %zu for %dx%d of format %#x",
+                  i, len, offset, image.width, image.height, image.format);
+            return false;
+        }
+
+        if (canvas.getBufferType() == AcrylicCanvas::MT_DMABUF) {
+            int fd = canvas.getDmabuf(i);
+            int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+
+            void *addr = mmap(NULL, len, prot, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                ALOGERR("Failed to map buffer[%u] of %zu bytes", i, len);
+                return false;
+            }
+
+            image.mapped[i] = addr;
+            image.mappedLen[i] = len;
+            image.mappedFd[i] = fd;
+
+            struct dma_buf_sync sync;
+            sync.flags = DMA_BUF_SYNC_START | (writable ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+            if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0)
+                ALOGERR("Failed to begin CPU access to buffer[%u]", i);
+
+            buffer[i] = static_cast<uint8_t *>(addr) + offset;
+        } else {
+            buffer[i] = static_cast<uint8_t *>(canvas.getUserptr(i));
+        }
+    }
+
+    image.plane[0] = buffer[0];
+    if (image.ycbcr) {
+        image.stride[0] = image.width;
+        image.stride[1] = image.width;
+        image.plane[1] = (bufcnt > 1) ? buffer[1] : buffer[0] + image.width * image.height;
+    } else {
+        image.stride[0] = image.width * (halfmt_bpp(image.format) / 8);
+    }
+
+    return true;
+}
+
+static inline uint32_t fetchPixel(const AcrylicSWImage &image, int32_t x, int32_t y)
+{
+    const uint8_t *p;
+
+    if (image.ycbcr) {
+        int32_t luma = image.plane[0][y * image.stride[0] + x] - image.lumaOffset;
+        p = image.plane[1] + (y >> 1) * image.stride[1] + (x & ~1);
+        int32_t cb = (image.crcb ? p[1] : p[0]) - 128;
+        int32_t cr = (image.crcb ? p[0] : p[1]) - 128;
+        const int32_t *m = image.csc;
+
+        int32_t r = (m[0] * luma + m[1] * cb + m[2] * cr + 256) >> 9;
+        int32_t g = (m[3] * luma + m[4] * cb + m[5] * cr + 256) >> 9;
+        int32_t b = (m[6] * luma + m[7] * cb + m[8] * cr + 256) >> 9;
+
+        return packRGBA(clampInt(r, 0, 255), clampInt(g, 0, 255), clampInt(b, 0, 255), 255);
+    }
+
+    p = image.plane[0] + y * image.stride[0];
+
+    switch (image.format) {
+    case HAL_PIXEL_FORMAT_RGBA_8888:
+        p += x * 4;
+        return packRGBA(p[0], p[1], p[2], p[3]);
+    case HAL_PIXEL_FORMAT_RGBX_8888:
+        p += x * 4;
+        return packRGBA(p[0], p[1], p[2], 255);
+    case HAL_PIXEL_FORMAT_BGRA_8888:
+        p += x * 4;
+        return packRGBA(p[2], p[1], p[0], p[3]);
+    case HAL_PIXEL_FORMAT_RGB_888:
+        p += x * 3;
+        return packRGBA(p[0], p[1], p[2], 255);
+    case HAL_PIXEL_FORMAT_RGB_565: {
+        uint32_t v = p[x * 2] | (p[x * 2 + 1] << 8);
+        uint32_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+        return packRGBA((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+    }
+    default:
+        return 0;
+    }
+}
+
+static void storeRow(const AcrylicSWImage &image, int32_t y, const AcrylicSWRow &row)
+{
+    uint8_t *p = image.plane[0] + y * image.stride[0];
+    int32_t width = image.width;
+
+    switch (image.format) {
+    case HAL_PIXEL_FORMAT_RGBA_8888:
+        for (int32_t x = 0; x < width; x++, p += 4) {
+            p[0] = row.r[x]; p[1] = row.g[x]; p[2] = row.b[x]; p[3] = row.a[x];
+        }
+        break;
+    case HAL_PIXEL_FORMAT_RGBX_8888:
+        for (int32_t x = 0; x < width; x++, p += 4) {
+            p[0] = row.r[x]; p[1] = row.g[x]; p[2] = row.b[x]; p[3] = 255;
+        }
+        break;
+    case HAL_PIXEL_FORMAT_BGRA_8888:
+        for (int32_t x = 0; x < width; x++, p += 4) {
+            p[0] = row.b[x]; p[1] = row.g[x]; p[2] = row.r[x]; p[3] = row.a[x];
+        }
+        break;
+    case HAL_PIXEL_FORMAT_RGB_888:
+        for (int32_t x = 0; x < width; x++, p += 3) {
+            p[0] = row.r[x]; p[1] = row.g[x]; p[2] = row.b[x];
+        }
+        break;
+    case HAL_PIXEL_FORMAT_RGB_565:
+        for (int32_t x = 0; x < width; x++, p += 2) {
+            uint32_t v = ((row.r[x] >> 3) << 11) | ((row.g[x] >> 2) << 5) | (row.b[x] >> 3);
+            p[0] = v & 0xFF;
+            p[1] = v >> 8;
+        }
+        break;
+    }
+}
+
+/*
+ * Sample the source pixels of the target pixels in [x0, x1) of the row y.
+ * Target pixel centers are mapped back to the source crop through the inverse
+ * of the layer transform (flips first, then 90 degree clockwise rotation).
+ * Pure copies, flips and rotations take the nearest pixel; every other case
+ * is filtered bilinearly in 16.16 fixed point.
+ */
+static void sampleSpan(const AcrylicSWImage &image, int32_t y, int32_t x0, int32_t x1, AcrylicSWRow &row)
+{
+    if (image.solid) {
+        for (int32_t x = x0; x < x1; x++)
+            row.set(x, image.solidColor);
+        return;
+    }
+
+    const hw2d_rect_t &win = image.window;
+    const hw2d_rect_t &crop = image.crop;
+
+    auto map = [&](double u, double v, double &sx, double &sy) {
+        double fu = u / win.size.hori, fv = v / win.size.vert;
+        double fx, fy;
+
+        if (image.transform & HAL_TRANSFORM_ROT_90) {
+            fx = fv;
+            fy = 1.0 - fu;
+        } else {
+            fx = fu;
+            fy = fv;
+        }
+        if (image.transform & HAL_TRANSFORM_FLIP_H)
+            fx = 1.0 - fx;
+        if (image.transform & HAL_TRANSFORM_FLIP_V)
+            fy = 1.0 - fy;
+
+        sx = crop.pos.hori + fx * crop.size.hori - 0.5;
+        sy = crop.pos.vert + fy * crop.size.vert - 0.5;
+    };
+
+    double u = x0 - win.pos.hori + 0.5, v = y - win.pos.vert + 0.5;
+    double sx, sy, nx, ny;
+
+    map(u, v, sx, sy);
+    map(u + 1.0, v, nx, ny);
+
+    int64_t fx = std::llround(sx * 65536.0), fy = std::llround(sy * 65536.0);
+    int64_t dx = std::llround((nx - sx) * 65536.0), dy = std::llround((ny - sy) * 65536.0);
+
+    int32_t left = crop.pos.hori, right = crop.pos.hori + crop.size.hori - 1;
+    int32_t top = crop.pos.vert, bottom = crop.pos.vert + crop.size.vert - 1;
+
+    bool nearest = ((fx & 0xFFFF) == 0) && ((fy & 0xFFFF) == 0) &&
+                   ((std::abs(dx) == 0x10000 && dy == 0) || (dx == 0 && std::abs(dy) == 0x10000));
+
+    if (nearest) {
+        for (int32_t x = x0; x < x1; x++, fx += dx, fy += dy)
+            row.set(x, fetchPixel(image, clampInt(static_cast<int32_t>(fx >> 16), left, right),
+                                  clampInt(static_cast<int32_t>(fy >> 16), top, bottom)));
+        return;
+    }
+
+    for (int32_t x = x0; x < x1; x++, fx += dx, fy += dy) {
+        int32_t ix = static_cast<int32_t>(fx >> 16), iy = static_cast<int32_t>(fy >> 16);
+        uint32_t wx = (fx >> 8) & 0xFF, wy = (fy >> 8) & 0xFF;
+        int32_t ix0 = clampInt(ix, left, right), ix1 = clampInt(ix + 1, left, right);
+        int32_t iy0 = clampInt(iy, top, bottom), iy1 = clampInt(iy + 1, top, bottom);
+
+        uint32_t p00 = fetchPixel(image, ix0, iy0), p01 = fetchPixel(image, ix1, iy0);
+        uint32_t p10 = fetchPixel(image, ix0, iy1), p11 = fetchPixel(image, ix1, iy1);
+        uint32_t rgba = 0;
+
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint32_t c0 = ((p00 >> shift) & 0xFF) * (256 - wx) + ((p01 >> shift) & 0xFF) * wx;
+            uint32_t c1 = ((p10 >> shift) & 0xFF) * (256 - wx) + ((p11 >> shift) & 0xFF) * wx;
+            rgba |= (((c0 * (256 - wy) + c1 * wy) + 32768) >> 16) << shift;
+        }
+
+        row.set(x, rgba);
+    }
+}
+
+/*
+ * Turn the sampled pixels into premultiplied color with the plane alpha applied:
+ * - NONE:     the per-pixel alpha is ignored
+ * - PREMULT:  the color is already multiplied with the per-pixel alpha
+ * - COVERAGE: the color is multiplied with the per-pixel alpha here
+ */
+static void prepareSpan(AcrylicSWRow &src, int32_t x0, int32_t x1, uint32_t blending, uint32_t plane_alpha)
+{
+    uint16_t *r = src.r.data(), *g = src.g.data(), *b = src.b.data(), *a = src.a.data();
+
+    if ((blending == HWC_BLENDING_NONE) || (blending == HWC2_BLEND_MODE_NONE)) {
+        for (int32_t x = x0; x < x1; x++)
+            a[x] = 255;
+    } else if ((blending == HWC_BLENDING_COVERAGE) || (blending == HWC2_BLEND_MODE_COVERAGE)) {
+        for (int32_t x = x0; x < x1; x++) {
+            r[x] = div255(r[x] * a[x]);
+            g[x] = div255(g[x] * a[x]);
+            b[x] = div255(b[x] * a[x]);
+        }
+    }
+
+    if (plane_alpha == 255)
+        return;
+
+    for (int32_t x = x0; x < x1; x++) {
+        r[x] = div255(r[x] * plane_alpha);
+        g[x] = div255(g[x] * plane_alpha);
+        b[x] = div255(b[x] * plane_alpha);
+        a[x] = div255(a[x] * plane_alpha);
+    }
+}
+
+/* dst = src + dst * (1 - src alpha) on premultiplied color */
+static void blendSpan(AcrylicSWRow &dst, const AcrylicSWRow &src, int32_t x0, int32_t x1)
+{
+    uint16_t *dr = dst.r.data(), *dg = dst.g.data(), *db = dst.b.data(), *da = dst.a.data();
+    const uint16_t *sr = src.r.data(), *sg = src.g.data(), *sb = src.b.data(), *sa = src.a.data();
+
+    for (int32_t x = x0; x < x1; x++) {
+        uint32_t inv = 255 - sa[x];
+        dr[x] = sr[x] + div255(dr[x] * inv);
+        dg[x] = sg[x] + div255(dg[x] * inv);
+        db[x] = sb[x] + div255(db[x] * inv);
+        da[x] = sa[x] + div255(da[x] * inv);
+    }
+}
+
+AcrylicCompositorSW::AcrylicCompositorSW(const HW2DCapability &capability, unsigned int num_workers)
+    : Acrylic(capability), mPool(num_workers), mLaptimeUSec(0)
+{
+    ALOGD_TEST("Created a new Acrylic for software compositor with %u workers", num_workers);
+}
+
+AcrylicCompositorSW::~AcrylicCompositorSW()
+{
+    ALOGD_TEST("Deleting Acrylic for software compositor");
+}
+
+void AcrylicCompositorSW::composeRows(AcrylicSWImage &target, std::vector<AcrylicSWImage> &sources,
+                                      int32_t top, int32_t bottom)
+{
+    AcrylicSWRow dst(target.width);
+    AcrylicSWRow src(target.width);
+    uint16_t r, g, b, a;
+
+    getBackgroundColor(&r, &g, &b, &a);
+
+    for (int32_t y = top; y < bottom; y++) {
+        if (hasBackgroundColor()) {
+            uint32_t color = packRGBA(r >> 8, g >> 8, b >> 8, a >> 8);
+            for (int32_t x = 0; x < target.width; x++)
+                dst.set(x, color);
+        } else {
+            for (int32_t x = 0; x < target.width; x++)
+                dst.set(x, fetchPixel(target, x, y));
+        }
+
+        for (auto &image : sources) {
+            const hw2d_rect_t &win = image.window;
+
+            if ((y < win.pos.vert) || (y >= win.pos.vert + win.size.vert))
+                continue;
+
+            int32_t x0 = std::max<int32_t>(win.pos.hori, 0);
+            int32_t x1 = std::min<int32_t>(win.pos.hori + win.size.hori, target.width);
+            if (x0 >= x1)
+                continue;
+
+            sampleSpan(image, y, x0, x1, src);
+            prepareSpan(src, x0, x1, image.blending, image.planeAlpha);
+            blendSpan(dst, src, x0, x1);
+        }
+
+        storeRow(target, y, dst);
+    }
+}
+
+static bool waitFence(AcrylicCanvas &canvas)
+{
+    int fence = canvas.getFence();
+
+    if (fence < 0)
+        return true;
+
+    if (sync_wait(fence, SW_FENCE_TIMEOUT_MS) < 0) {
+        ALOGERR("Failed to wait for acquire fence %d", fence);
+        return false;
+    }
+
+    return true;
+}
+
+bool AcrylicCompositorSW::executeSW()
+{
+    ATRACE_CALL();
+    if (!validateAllLayers())
+        return false;
+
+    sortLayers();
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The images are mapped and synchronized for the CPU after their producers
+    // and the previous readers of the target are done with them
+    bool okay = true;
+    for (unsigned int i = 0; okay && (i < layerCount()); i++)
+        okay = waitFence(*getLayer(i));
+
+    if (okay)
+        okay = waitFence(getCanvas());
+
+    AcrylicSWImage target;
+    std::vector<AcrylicSWImage> sources(layerCount());
+    okay = okay && mapImage(getCanvas(), target, true);
+
+    if (okay && target.ycbcr) {
+        ALOGE("YCbCr target images are not supported by the software compositor");
+        okay = false;
+    }
+
+    for (unsigned int i = 0; okay && (i < layerCount()); i++) {
+        AcrylicLayer &layer = *getLayer(i);
+        AcrylicSWImage &image = sources[i];
+
+        if (!mapImage(layer, image, false)) {
+            ALOGE("Failed to access source layer %u", i);
+            okay = false;
+            break;
+        }
+
+        image.crop = layer.getImageRect();
+        image.window = layer.getTargetRect();
+        if (area_is_zero(image.window)) {
+            image.window.pos = {0, 0};
+            image.window.size = getCanvas().getImageDimension();
+        }
+        image.transform = layer.getTransform();
+        image.blending = layer.getCompositingMode();
+        image.planeAlpha = layer.getPlaneAlpha();
+    }
+
+    if (okay) {
+        int32_t height = target.height;
+        unsigned int num_tiles = (height + SW_TILE_ROWS - 1) / SW_TILE_ROWS;
+
+        mPool.run(num_tiles, [&](unsigned int tile) {
+            int32_t top = tile * SW_TILE_ROWS;
+            composeRows(target, sources, top, std::min(top + SW_TILE_ROWS, height));
+        });
+    }
+
+    for (auto &image : sources)
+        unmapImage(image);
+    unmapImage(target);
+
+    if (!okay)
+        return false;
+
+    mLaptimeUSec = static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start).count());
+
+    getCanvas().clearSettingModified();
+    getCanvas().setFence(-1);
+
+    for (unsigned int i = 0; i < layerCount(); i++) {
+        getLayer(i)->clearSettingModified();
+        getLayer(i)->setFence(-1);
+    }
+
+    return true;
+}
+
+bool AcrylicCompositorSW::execute(int fence[], unsigned int num_fences)
+{
+    if (!executeSW()) {
+        // Clearing all acquire fences because their buffers are expired.
+        // The clients should configure everything again to start new execution
+        for (unsigned int i = 0; i < layerCount(); i++)
+            getLayer(i)->setFence(-1);
+        getCanvas().setFence(-1);
+
+        return false;
+    }
+
+    // The composition is already completed. No release fence is required.
+    for (unsigned int i = 0; i < num_fences; i++)
+        fence[i] = -1;
+
+    return true;
+}
+
+bool AcrylicCompositorSW::execute(int *handle)
+{
+    if (!executeSW()) {
+        for (unsigned int i = 0; i < layerCount(); i++)
+            getLayer(i)->setFence(-1);
+        getCanvas().setFence(-1);
+
+        return false;
+    }
+
+    if (handle != NULL)
+        *handle = 1; /* dummy handle */
+
+    return true;
+}
+
+bool AcrylicCompositorSW::waitExecution(int __unused handle)
+{
+    return true;
+}
+
+Acrylic *createAcrylicCompositorSW(const char *spec)
+{
+    if (strcmp(spec, LIBACRYL_SW_COMPOSITOR) != 0)
+        return nullptr;
+
+    unsigned int cpus = std::thread::hardware_concurrency();
+    unsigned int workers = (cpus > 1) ? std::min(cpus - 1, static_cast<unsigned int>(SW_MAX_WORKERS)) : 0;
+
+    return new AcrylicCompositorSW(capability_sw, workers);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_ACRYLIC_SW_H__
+#define __HARDWARE_EXYNOS_ACRYLIC_SW_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <hardware/exynos/acryl.h>
+
+#include "acrylic_internal.h"
+
+/*
+ * The spec name of the software compositor for Acrylic::createInstance()
+ * and AcrylicFactory::createAcrylic().
+ */
+#define LIBACRYL_SW_COMPOSITOR "sw_compositor"
+
+/*
+ * AcrylicTilePool - runs the tiles of a frame on a set of worker threads
+ *
+ * The caller of run() also processes tiles so that a pool without workers
+ * degrades to a plain loop on the calling thread.
+ */
+class AcrylicTilePool {
+public:
+    explicit AcrylicTilePool(unsigned int num_workers);
+    ~AcrylicTilePool();
+    void run(unsigned int num_tiles, const std::function<void(unsigned int)> &func);
+private:
+    void workerRoutine();
+    void processTiles();
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mDoneCondition;
+    const std::function<void(unsigned int)> *mFunc = nullptr;
+    unsigned int mNumTiles = 0;
+    std::atomic<unsigned int> mNextTile{0};
+    unsigned int mBusyWorkers = 0;
+    uint64_t mGeneration = 0;
+    bool mExit = false;
+};
+
+struct AcrylicSWImage;
+
+class AcrylicCompositorSW: public Acrylic {
+public:
+    AcrylicCompositorSW(const HW2DCapability &capability, unsigned int num_workers);
+    virtual ~AcrylicCompositorSW();
+    virtual bool execute(int fence[], unsigned int num_fences);
+    virtual bool execute(int *handle = NULL);
+    virtual bool waitExecution(int handle);
+    virtual unsigned int getLaptimeUSec() { return mLaptimeUSec; }
+private:
+    bool executeSW();
+    void composeRows(AcrylicSWImage &target, std::vector<AcrylicSWImage> &sources,
+                     int32_t top, int32_t bottom);
+
+    AcrylicTilePool mPool;
+    unsigned int mLaptimeUSec;
+};
+
+Acrylic *createAcrylicCompositorSW(const char *spec);
+
+#endif //__HARDWARE_EXYNOS_ACRYLIC_SW_H__
@@ -976,6 +976,7 @@ public:
     /*
      * Factory methods of an instance of Acrylic subclasses
      * createInstance() - create the instance exactly specified by @spec
+     *                    "sw_compositor" selects the CPU reference compositor
      * createCompositor() - create an instance of HW 2D compositor defined in board definition
      * createScaler() - create an instance of image post processor defined in board definition
      * createBlter() - create an instance of H/W accelerator of bit block transfer defined in board definition
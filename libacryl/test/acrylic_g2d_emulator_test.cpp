@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sync/sync.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../acrylic_g2d_emulator.h"
+
+/*
+ * Golden tests of AcrylicG2DEmulator. The commands are written as
+ * AcrylicCompositorG2D writes them and the images are passed by user pointers
+ * so that no dma-buf heap is needed. The expected pixels are worked out by hand.
+ */
+
+struct TestImage {
+    TestImage(uint32_t colormode, int32_t width, int32_t height, int32_t bpp)
+        : bpp(bpp), data(width * height * bpp) {
+        cmd[G2DSFR_IMG_COLORMODE] = colormode;
+        cmd[G2DSFR_IMG_STRIDE] = width * bpp;
+        cmd[G2DSFR_IMG_RIGHT] = cmd[G2DSFR_IMG_WIDTH] = width;
+        cmd[G2DSFR_IMG_BOTTOM] = cmd[G2DSFR_IMG_HEIGHT] = height;
+
+        layer.buffer_type = G2D_BUFTYPE_USERPTR;
+        layer.num_buffers = 1;
+        layer.buffer[0].userptr = data.data();
+        layer.buffer[0].length = data.size();
+    }
+
+    uint8_t *pixel(int32_t x, int32_t y) {
+        return &data[y * cmd[G2DSFR_IMG_STRIDE] + x * bpp];
+    }
+
+    void fill(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        for (size_t i = 0; i < data.size(); i += 4) {
+            data[i] = r;
+            data[i + 1] = g;
+            data[i + 2] = b;
+            data[i + 3] = a;
+        }
+    }
+
+    int32_t bpp;
+    std::vector<uint8_t> data;
+    uint32_t cmd[G2DSFR_SRC_FIELD_COUNT] = {};
+    g2d_layer layer = {};
+};
+
+class G2DEmulator : public testing::Test {
+protected:
+    G2DEmulator() : mEmulator("/dev/g2d") {}
+
+    // Places the whole @src at @left, @top of the target without scaling
+    void setWindow(TestImage &src, int32_t left, int32_t top, int32_t width, int32_t height) {
+        src.cmd[G2DSFR_SRC_COMMAND] = G2D_LAYERCMD_VALID;
+        src.cmd[G2DSFR_SRC_DSTLEFT] = left;
+        src.cmd[G2DSFR_SRC_DSTTOP] = top;
+        src.cmd[G2DSFR_SRC_DSTRIGHT] = left + width;
+        src.cmd[G2DSFR_SRC_DSTBOTTOM] = top + height;
+        src.cmd[G2DSFR_SRC_XSCALE] = 1 << G2D_SCALEFACTOR_FRACBITS;
+        src.cmd[G2DSFR_SRC_YSCALE] = 1 << G2D_SCALEFACTOR_FRACBITS;
+        src.cmd[G2DSFR_SRC_ALPHA] = 0xFF;
+        src.cmd[G2DSFR_SRC_BLEND] = G2D_BLEND_SRCOVER;
+    }
+
+    uint32_t process(TestImage &target, std::vector<TestImage *> sources,
+                     std::vector<g2d_reg> extra = {}) {
+        std::vector<g2d_layer> layers;
+        for (auto src : sources)
+            layers.push_back(src->layer);
+
+        int32_t fences[G2D_MAX_RELEASE_FENCES];
+        g2d_task task = {};
+        task.num_source = sources.size();
+        task.source = layers.data();
+        task.target = target.layer;
+        task.num_release_fences = sources.size() + 1;
+        task.release_fence = fences;
+        task.commands.target = target.cmd;
+        for (size_t i = 0; i < sources.size(); i++)
+            task.commands.source[i] = sources[i]->cmd;
+        task.commands.extra = extra.data();
+        task.commands.num_extra_regs = extra.size();
+
+        EXPECT_EQ(0, mEmulator.ioctl(G2D_IOC_PROCESS, &task));
+        // the release fences are signaled already or -1 without sw_sync
+        for (unsigned int i = 0; i < task.num_release_fences; i++) {
+            if (fences[i] < 0)
+                continue;
+            EXPECT_EQ(0, sync_wait(fences[i], 0));
+            close(fences[i]);
+        }
+
+        return task.flags;
+    }
+
+    void expectPixel(TestImage &img, int32_t x, int32_t y, std::vector<uint8_t> expected) {
+        SCOPED_TRACE(testing::Message() << "pixel (" << x << ", " << y << ")");
+        const uint8_t *p = img.pixel(x, y);
+        for (size_t i = 0; i < expected.size(); i++)
+            EXPECT_NEAR(expected[i], p[i], 1) << "component " << i;
+    }
+
+    AcrylicG2DEmulator mEmulator;
+};
+
+TEST_F(G2DEmulator, Version)
+{
+    uint32_t version = 0;
+
+    EXPECT_EQ(0, mEmulator.ioctl(G2D_IOC_VERSION, &version));
+    EXPECT_NE(0U, version);
+}
+
+TEST_F(G2DEmulator, ColorFill)
+{
+    TestImage target(G2D_FMT_ABGR8888, 4, 4, 4);
+    TestImage fill(G2D_FMT_ABGR8888, 2, 2, 4);
+
+    target.fill(0, 0, 0, 0xFF);
+    setWindow(fill, 1, 1, 2, 2);
+    fill.layer.flags = G2D_LAYERFLAG_COLORFILL;
+    fill.layer.num_buffers = 0;
+    fill.cmd[G2DSFR_SRC_SELECT] = G2D_LAYERSEL_COLORFILL;
+    fill.cmd[G2DSFR_SRC_COLOR] = 0xFF112233; // ARGB
+    fill.cmd[G2DSFR_SRC_BLEND] = G2D_BLEND_SRCCOPY;
+
+    ASSERT_EQ(0U, process(target, {&fill}) & G2D_FLAG_ERROR);
+
+    expectPixel(target, 0, 0, {0, 0, 0, 0xFF});
+    expectPixel(target, 1, 1, {0x11, 0x22, 0x33, 0xFF});
+    expectPixel(target, 2, 2, {0x11, 0x22, 0x33, 0xFF});
+    expectPixel(target, 3, 3, {0, 0, 0, 0xFF});
+}
+
+TEST_F(G2DEmulator, Rotate90)
+{
+    TestImage src(G2D_FMT_ABGR8888, 4, 3, 4);
+    TestImage target(G2D_FMT_ABGR8888, 3, 4, 4);
+
+    for (int32_t y = 0; y < 3; y++)
+        for (int32_t x = 0; x < 4; x++)
+            memcpy(src.pixel(x, y), std::vector<uint8_t>{uint8_t(x * 10 + y), 0, 0, 0xFF}.data(), 4);
+
+    // HAL_TRANSFORM_ROT_90 is written as 90 degree counter-clockwise rotation and
+    // flips in both directions
+    setWindow(src, 0, 0, 3, 4);
+    src.cmd[G2DSFR_SRC_COMMAND] |= G2D_LAYERCMD_OPAQUE;
+    src.cmd[G2DSFR_SRC_ROTATE] = G2D_ROTATEDIR_ROT90CCW | (3 << G2D_ROTATEDIR_FLIP_SHIFT);
+
+    ASSERT_EQ(0U, process(target, {&src}) & G2D_FLAG_ERROR);
+
+    // clockwise rotation moves the source pixel (x, y) to (2 - y, x)
+    for (int32_t y = 0; y < 3; y++)
+        for (int32_t x = 0; x < 4; x++)
+            expectPixel(target, 2 - y, x, {uint8_t(x * 10 + y), 0, 0, 0xFF});
+}
+
+TEST_F(G2DEmulator, ScaleNearest)
+{
+    TestImage src(G2D_FMT_ABGR8888, 2, 2, 4);
+    TestImage target(G2D_FMT_ABGR8888, 4, 4, 4);
+
+    memcpy(src.pixel(0, 0), std::vector<uint8_t>{10, 0, 0, 0xFF}.data(), 4);
+    memcpy(src.pixel(1, 0), std::vector<uint8_t>{20, 0, 0, 0xFF}.data(), 4);
+    memcpy(src.pixel(0, 1), std::vector<uint8_t>{30, 0, 0, 0xFF}.data(), 4);
+    memcpy(src.pixel(1, 1), std::vector<uint8_t>{40, 0, 0, 0xFF}.data(), 4);
+
+    setWindow(src, 0, 0, 4, 4);
+    src.cmd[G2DSFR_SRC_XSCALE] = 1 << (G2D_SCALEFACTOR_FRACBITS - 1);
+    src.cmd[G2DSFR_SRC_YSCALE] = 1 << (G2D_SCALEFACTOR_FRACBITS - 1);
+
+    ASSERT_EQ(0U, process(target, {&src}) & G2D_FLAG_ERROR);
+
+    for (int32_t y = 0; y < 4; y++)
+        for (int32_t x = 0; x < 4; x++)
+            expectPixel(target, x, y, {uint8_t(10 + (x / 2) * 10 + (y / 2) * 20), 0, 0, 0xFF});
+}
+
+TEST_F(G2DEmulator, PlaneAlphaSrcOver)
+{
+    TestImage src(G2D_FMT_ABGR8888, 2, 2, 4);
+    TestImage target(G2D_FMT_ABGR8888, 2, 2, 4);
+
+    // premultiplied half transparent red over opaque blue
+    src.fill(0x80, 0, 0, 0x80);
+    target.fill(0, 0, 0xFF, 0xFF);
+    setWindow(src, 0, 0, 2, 2);
+    src.cmd[G2DSFR_SRC_ALPHA] = 0x80;
+
+    ASSERT_EQ(0U, process(target, {&src}) & G2D_FLAG_ERROR);
+
+    // Ga * Sc + (1 - Sa * Ga) * Dc with Ga = Sa = 128/255
+    expectPixel(target, 1, 1, {0x40, 0, 0xBF, 0xFF});
+}
+
+TEST_F(G2DEmulator, NV12ToRGB)
+{
+    TestImage src(G2D_FMT_NV12, 2, 2, 1);
+    TestImage target(G2D_FMT_ABGR8888, 2, 2, 4);
+
+    // the chroma plane follows the luma plane in the same buffer
+    src.data.assign(6, 0x80);
+    src.layer.buffer[0].userptr = src.data.data();
+    src.layer.buffer[0].length = src.data.size();
+    setWindow(src, 0, 0, 2, 2);
+
+    // BT.601 limited range matrix in the 512 scale written by CSCMatrixWriter
+    const int16_t bt601[9] = {596, 0, 817, 596, -200, -416, 596, 1033, 0};
+    std::vector<g2d_reg> extra;
+    for (uint32_t i = 0; i < 9; i++)
+        extra.push_back({0x2000 + i * 4, static_cast<uint32_t>(bt601[i])});
+
+    ASSERT_EQ(0U, process(target, {&src}, extra) & G2D_FLAG_ERROR);
+
+    // (128 - 16) * 596 / 512 = 130.4
+    expectPixel(target, 0, 0, {130, 130, 130, 0xFF});
+    expectPixel(target, 1, 1, {130, 130, 130, 0xFF});
+}
+
+TEST_F(G2DEmulator, RejectCompressedSource)
+{
+    TestImage src(G2D_FMT_ABGR8888 | G2D_DATAFORMAT_AFBC, 2, 2, 4);
+    TestImage target(G2D_FMT_ABGR8888, 2, 2, 4);
+
+    setWindow(src, 0, 0, 2, 2);
+
+    EXPECT_NE(0U, process(target, {&src}) & G2D_FLAG_ERROR);
+}
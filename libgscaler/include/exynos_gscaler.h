@@ -111,6 +111,32 @@ void *exynos_gsc_create_exclusive(
 void exynos_gsc_destroy(
     void *handle);
 
+/*!
+ * Number of the buckets of the histogram of the time to wait for a free
+ * Gscaler in exynos_gsc_create().
+ * [0] no wait, [1] ~1ms, [2] ~2ms, [3] ~4ms, [4] ~8ms, [5] over 8ms,
+ * [6] no Gscaler available until timeout
+ */
+#define GSC_WAIT_HISTOGRAM_BUCKETS 7
+
+/*!
+ * Get the histogram of the time to wait for a free Gscaler
+ *
+ * \ingroup exynos_gscaler
+ *
+ * \param counts
+ *   number of exynos_gsc_create() calls in each bucket[out]
+ *
+ * \param num_buckets
+ *   length of counts[in]
+ *
+ * \return
+ *   number of buckets written to counts, -1 on failure
+ */
+int exynos_gsc_get_wait_histogram(
+    unsigned int *counts,
+    int           num_buckets);
+
 /*!
  * Set csc equation property
  *
@@ -318,6 +344,25 @@ int exynos_gsc_set_dst_addr(
 int exynos_gsc_convert(
     void *handle);
 
+/*!
+ * Keep the streaming session between exynos_gsc_convert() calls
+ *
+ * \ingroup exynos_gscaler
+ *
+ * \param handle
+ *   libgscaler handle[in]
+ *
+ * \param enable
+ *   1 to keep the formats and the streaming state while they are unchanged,
+ *   0 to stop streaming after every conversion (default)[in]
+ *
+ * \return
+ *   error code
+ */
+int exynos_gsc_set_persistent_session(
+    void *handle,
+    int   enable);
+
 /*
  * API for setting GSC subdev crop
  * Used in OTF mode
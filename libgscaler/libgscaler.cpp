@@ -135,6 +135,13 @@ void exynos_gsc_destroy(void *handle)
     Exynos_gsc_Out();
 }
 
+int exynos_gsc_get_wait_histogram(
+    unsigned int *counts,
+    int           num_buckets)
+{
+    return CGscaler::m_gsc_get_wait_histogram(counts, num_buckets);
+}
+
 int exynos_gsc_set_csc_property(
     void        *handle,
     unsigned int eq_auto,
@@ -156,6 +163,13 @@ int exynos_gsc_set_csc_property(
         Exynos_gsc_Out();
         return ret;
     }
+
+    /* the CSC controls are applied by the next run only when a side is dirty */
+    if ((gsc->eq_auto != eq_auto) ||
+        (gsc->range_full != range_full) ||
+        (gsc->v4l2_colorspace != v4l2_colorspace))
+        gsc->src_info.dirty = true;
+
     gsc->eq_auto = eq_auto;
     gsc->range_full = range_full;
     gsc->v4l2_colorspace = v4l2_colorspace;
@@ -184,6 +198,22 @@ int exynos_gsc_set_src_format(
         ALOGE("%s::handle == NULL() fail", __func__);
         return -1;
     }
+
+    /*
+     * S_FMT and REQBUFS are skipped by the next run if the format is unchanged
+     * so that the streaming session is kept between frames.
+     */
+    if ((gsc->src_info.width != width) ||
+        (gsc->src_info.height != height) ||
+        (gsc->src_info.crop_left != crop_left) ||
+        (gsc->src_info.crop_top != crop_top) ||
+        (gsc->src_info.crop_width != crop_width) ||
+        (gsc->src_info.crop_height != crop_height) ||
+        (gsc->src_info.v4l2_colorformat != v4l2_colorformat) ||
+        (gsc->src_info.cacheable != cacheable) ||
+        (gsc->src_info.mode_drm != mode_drm))
+        gsc->src_info.dirty = true;
+
     gsc->src_info.width            = width;
     gsc->src_info.height           = height;
     gsc->src_info.crop_left        = crop_left;
@@ -193,7 +223,6 @@ int exynos_gsc_set_src_format(
     gsc->src_info.v4l2_colorformat = v4l2_colorformat;
     gsc->src_info.cacheable        = cacheable;
     gsc->src_info.mode_drm         = mode_drm;
-    gsc->src_info.dirty            = true;
 
     Exynos_gsc_Out();
 
@@ -220,6 +249,21 @@ int exynos_gsc_set_dst_format(
         return -1;
     }
 
+    /*
+     * S_FMT and REQBUFS are skipped by the next run if the format is unchanged
+     * so that the streaming session is kept between frames.
+     */
+    if ((gsc->dst_info.width != width) ||
+        (gsc->dst_info.height != height) ||
+        (gsc->dst_info.crop_left != crop_left) ||
+        (gsc->dst_info.crop_top != crop_top) ||
+        (gsc->dst_info.crop_width != crop_width) ||
+        (gsc->dst_info.crop_height != crop_height) ||
+        (gsc->dst_info.v4l2_colorformat != v4l2_colorformat) ||
+        (gsc->dst_info.cacheable != cacheable) ||
+        (gsc->dst_info.mode_drm != mode_drm))
+        gsc->dst_info.dirty = true;
+
     gsc->dst_info.width            = width;
     gsc->dst_info.height           = height;
     gsc->dst_info.crop_left        = crop_left;
@@ -227,7 +271,6 @@ int exynos_gsc_set_dst_format(
     gsc->dst_info.crop_width       = crop_width;
     gsc->dst_info.crop_height      = crop_height;
     gsc->dst_info.v4l2_colorformat = v4l2_colorformat;
-    gsc->dst_info.dirty            = true;
     gsc->dst_info.cacheable        = cacheable;
     gsc->dst_info.mode_drm         = mode_drm;
 
@@ -259,6 +302,11 @@ int exynos_gsc_set_rotation(
     if(new_rotation < 0)
         new_rotation = -new_rotation;
 
+    if ((gsc->dst_info.rotation != new_rotation) ||
+        (gsc->dst_info.flip_horizontal != flip_horizontal) ||
+        (gsc->dst_info.flip_vertical != flip_vertical))
+        gsc->dst_info.dirty = true;
+
     gsc->dst_info.rotation        = new_rotation;
     gsc->dst_info.flip_horizontal = flip_horizontal;
     gsc->dst_info.flip_vertical   = flip_vertical;
@@ -284,6 +332,9 @@ int exynos_gsc_set_src_addr(
     gsc->src_info.buf.addr[1] = addr[1];
     gsc->src_info.buf.addr[2] = addr[2];
     gsc->src_info.acquireFenceFd = acquireFenceFd;
+    /* the buffers requested for the other memory type are not reusable */
+    if (gsc->src_info.buf.mem_type != (enum v4l2_memory)mem_type)
+        gsc->src_info.dirty = true;
     gsc->src_info.buf.mem_type = (enum v4l2_memory)mem_type;
 
     Exynos_gsc_Out();
@@ -309,6 +360,9 @@ int exynos_gsc_set_dst_addr(
     gsc->dst_info.buf.addr[1] = addr[1];
     gsc->dst_info.buf.addr[2] = addr[2];
     gsc->dst_info.acquireFenceFd = acquireFenceFd;
+    /* the buffers requested for the other memory type are not reusable */
+    if (gsc->dst_info.buf.mem_type != (enum v4l2_memory)mem_type)
+        gsc->dst_info.dirty = true;
     gsc->dst_info.buf.mem_type = (enum v4l2_memory)mem_type;
 
     Exynos_gsc_Out();
@@ -347,7 +401,7 @@ int exynos_gsc_convert(void *handle)
         gsc->dst_info.releaseFenceFd = -1;
     }
 
-    if (gsc->m_gsc_m2m_stop(handle) < 0) {
+    if (!gsc->persistent_session && (gsc->m_gsc_m2m_stop(handle) < 0)) {
         ALOGE("%s::m_gsc_m2m_stop", __func__);
         goto done;
     }
@@ -360,6 +414,34 @@ done:
     return ret;
 }
 
+int exynos_gsc_set_persistent_session(void *handle, int enable)
+{
+    Exynos_gsc_In();
+
+    CGscaler* gsc = GetGscaler(handle);
+    if (gsc == NULL) {
+        ALOGE("%s::handle == NULL() fail", __func__);
+        return -1;
+    }
+
+    if (gsc->mode != GSC_M2M_MODE) {
+        ALOGE("%s::persistent session is only for M2M mode", __func__);
+        return -1;
+    }
+
+    gsc->persistent_session = !!enable;
+
+    /* close the streaming session kept by the previous conversions */
+    if (!enable && (gsc->m_gsc_m2m_stop(handle) < 0)) {
+        ALOGE("%s::m_gsc_m2m_stop", __func__);
+        return -1;
+    }
+
+    Exynos_gsc_Out();
+
+    return 0;
+}
+
 int exynos_gsc_subdev_s_crop(void *handle,
         exynos_mpp_img __UNUSED__ *src_img, exynos_mpp_img *dst_img)
 {
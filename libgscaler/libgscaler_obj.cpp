@@ -28,6 +28,10 @@
 
 #include <cstdio>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -234,56 +238,163 @@ int CGscaler::m_gsc_m2m_create(int dev)
     return fd;
 }
 
-bool CGscaler::m_gsc_find_and_create(void *handle)
-{
-    Exynos_gsc_In();
-
-    int          i                 = 0;
-    bool         flag_find_new_gsc = false;
-    unsigned int total_sleep_time  = 0;
-    CGscaler* gsc = GetGscaler(handle);
-    if (gsc == NULL) {
-        ALOGE("%s::handle == NULL() fail", __func__);
-        return false;
-    }
-
-    do {
-        for (i = 0; i < NUM_OF_GSC_HW; i++) {
+/*
+ * GscNodeAllocator tracks which CGscaler of this process owns each GSC node.
+ * A node released by m_gsc_m2m_destroy() wakes up the waiters in
+ * m_gsc_find_and_create() at once. The nodes owned by other processes are
+ * only known by the failure of open() and they are retried every
+ * GSC_WAITING_TIME_FOR_TRYLOCK. A node is reserved under the lock and opened
+ * after the lock is dropped, so a slow open() does not block the other threads.
+ */
+class GscNodeAllocator {
+    std::mutex mLock;
+    std::condition_variable mReleased;
+    CGscaler *mOwner[NUM_OF_GSC_HW];
+    unsigned int mWaitHistogram[GSC_WAIT_HISTOGRAM_BUCKETS];
+
+    static bool isAllocatable(int id)
+    {
 #ifndef USES_ONLY_GSC0_GSC1
-            if (i == 0 || i == 3)
+        return (id != 0) && (id != 3);
 #else
-            if (i == 0)
+        return id != 0;
 #endif
-                continue;
+    }
 
-            gsc->gsc_id = i;
-            gsc->gsc_fd = gsc->m_gsc_m2m_create(i);
-            if (gsc->gsc_fd < 0) {
-                gsc->gsc_fd = 0;
-                continue;
+    /* The buckets are described with GSC_WAIT_HISTOGRAM_BUCKETS */
+    void recordWaitTime(bool waited, unsigned int usec, bool found)
+    {
+        int bucket = 0;
+
+        if (!found)
+            bucket = GSC_WAIT_HISTOGRAM_BUCKETS - 1;
+        else if (waited)
+            for (bucket = 1; bucket < GSC_WAIT_HISTOGRAM_BUCKETS - 2; bucket++)
+                if (usec <= (1000u << (bucket - 1)))
+                    break;
+
+        mWaitHistogram[bucket]++;
+    }
+
+public:
+    GscNodeAllocator()
+    {
+        memset(mOwner, 0, sizeof(mOwner));
+        memset(mWaitHistogram, 0, sizeof(mWaitHistogram));
+    }
+
+    bool acquire(CGscaler *gsc)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::microseconds(MAX_GSC_WAITING_TIME_FOR_TRYLOCK);
+        std::unique_lock<std::mutex> lock(mLock);
+        bool waited = false;
+
+        while (true) {
+            for (int i = 0; i < NUM_OF_GSC_HW; i++) {
+                if (!isAllocatable(i) || mOwner[i])
+                    continue;
+
+                // The node is reserved so that other threads can look for
+                // a node while it is opened without the lock
+                mOwner[i] = gsc;
+                lock.unlock();
+                int fd = gsc->m_gsc_m2m_create(i);
+                lock.lock();
+
+                if (fd < 0) {
+                    mOwner[i] = NULL;
+                    mReleased.notify_all();
+                    continue;
+                }
+
+                gsc->gsc_id = i;
+                gsc->gsc_fd = fd;
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start);
+                recordWaitTime(waited, static_cast<unsigned int>(elapsed.count()), true);
+
+                return true;
             }
 
-            flag_find_new_gsc = true;
-            break;
-        }
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                break;
 
-        if (flag_find_new_gsc == false) {
-            usleep(GSC_WAITING_TIME_FOR_TRYLOCK);
-            total_sleep_time += GSC_WAITING_TIME_FOR_TRYLOCK;
             ALOGV("%s::waiting for the gscaler availability", __func__);
+            mReleased.wait_until(lock, std::min(deadline,
+                        now + std::chrono::microseconds(GSC_WAITING_TIME_FOR_TRYLOCK)));
+            waited = true;
+        }
+
+        recordWaitTime(waited, MAX_GSC_WAITING_TIME_FOR_TRYLOCK, false);
+
+        return false;
+    }
+
+    void release(CGscaler *gsc)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+
+            if ((gsc->gsc_id < 0) || (gsc->gsc_id >= NUM_OF_GSC_HW) ||
+                    (mOwner[gsc->gsc_id] != gsc))
+                return;
+
+            mOwner[gsc->gsc_id] = NULL;
         }
 
-    } while(flag_find_new_gsc == false
-            && total_sleep_time < MAX_GSC_WAITING_TIME_FOR_TRYLOCK);
+        mReleased.notify_all();
+    }
+
+    int getWaitHistogram(unsigned int *counts, int num_buckets)
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        if (num_buckets > GSC_WAIT_HISTOGRAM_BUCKETS)
+            num_buckets = GSC_WAIT_HISTOGRAM_BUCKETS;
+
+        for (int i = 0; i < num_buckets; i++)
+            counts[i] = mWaitHistogram[i];
+
+        return num_buckets;
+    }
+};
+
+static GscNodeAllocator gGscNodeAllocator;
 
-    if (flag_find_new_gsc == false)
+bool CGscaler::m_gsc_find_and_create(void *handle)
+{
+    Exynos_gsc_In();
+
+    CGscaler* gsc = GetGscaler(handle);
+    if (gsc == NULL) {
+        ALOGE("%s::handle == NULL() fail", __func__);
+        return false;
+    }
+
+    bool flag_find_new_gsc = gGscNodeAllocator.acquire(gsc);
+    if (flag_find_new_gsc == false) {
+        gsc->gsc_fd = 0;
         ALOGE("%s::we don't have any available gsc.. fail", __func__);
+    }
 
     Exynos_gsc_Out();
 
     return flag_find_new_gsc;
 }
 
+int CGscaler::m_gsc_get_wait_histogram(unsigned int *counts, int num_buckets)
+{
+    if ((counts == NULL) || (num_buckets <= 0)) {
+        ALOGE("%s::invalid histogram buffer(%p, %d)", __func__, counts, num_buckets);
+        return -1;
+    }
+
+    return gGscNodeAllocator.getWaitHistogram(counts, num_buckets);
+}
+
 bool CGscaler::m_gsc_m2m_destroy(void *handle)
 {
     Exynos_gsc_In();
@@ -310,6 +421,8 @@ bool CGscaler::m_gsc_m2m_destroy(void *handle)
         close(gsc->gsc_fd);
     gsc->gsc_fd = 0;
 
+    gGscNodeAllocator.release(gsc);
+
     Exynos_gsc_Out();
 
     return true;
@@ -390,6 +503,10 @@ int CGscaler::m_gsc_m2m_stop(void *handle)
         ret = -1;
     }
 
+    /* the formats and the buffers should be configured again by the next run */
+    gsc->src_info.dirty = true;
+    gsc->dst_info.dirty = true;
+
     Exynos_gsc_Out();
 
     return ret;
@@ -450,6 +567,18 @@ int CGscaler::m_gsc_m2m_run_core(void *handle)
         }
     }
 
+    /*
+     * A streaming session kept by exynos_gsc_set_persistent_session() is
+     * reused as long as the formats are unchanged. Otherwise it should be
+     * stopped before S_FMT and REQBUFS.
+     */
+    if (is_dirty && (gsc->src_info.stream_on || gsc->dst_info.stream_on)) {
+        if (gsc->m_gsc_m2m_stop(handle) < 0) {
+            ALOGE("%s::m_gsc_m2m_stop fail", __func__);
+            return -1;
+        }
+    }
+
     /*
      * need to set the content protection flag before doing reqbufs
      * in set_format
@@ -1515,11 +1644,20 @@ int CGscaler::m_gsc_out_run(void *handle, exynos_mpp_img *src_img)
         buf.length   = src_planes;
 
 
+        /* wait for a done buffer instead of polling DQBUF with sleeps */
         do {
             ret = ioctl(gsc->mdev.gsc_vd_entity->fd, VIDIOC_DQBUF, &buf);
-            if (ret == -EAGAIN) {
-                ALOGE("%s::Retry DQbuf(index=%d)", __func__, buf.index);
-                usleep(10000);
+            if ((ret < 0) && (errno == EAGAIN)) {
+                struct pollfd pfd;
+
+                pfd.fd = gsc->mdev.gsc_vd_entity->fd;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                ALOGV("%s::Waiting for done buffer(index=%d)", __func__, buf.index);
+                if (poll(&pfd, 1, GSC_DQBUF_TIMEOUT_MSEC) <= 0) {
+                    ALOGE("%s::timed out to wait for done buffer", __func__);
+                    break;
+                }
                 dq_retry_cnt++;
                 continue;
             }
@@ -89,6 +89,7 @@ extern "C" {
 
 #define MAX_GSC_WAITING_TIME_FOR_TRYLOCK (16000) // 16msec
 #define GSC_WAITING_TIME_FOR_TRYLOCK      (8000) //  8msec
+#define GSC_DQBUF_TIMEOUT_MSEC            (100)
 
 typedef struct GscalerInfo {
     unsigned int width;
@@ -140,6 +141,7 @@ public:
     int gsc_id;
     bool allow_drm;
     bool protection_enabled;
+    bool persistent_session;        /* keep streaming between exynos_gsc_convert() */
     int gsc_fd;
     int mode;
     unsigned int eq_auto;           /* 0: user, 1: auto */
@@ -166,6 +168,7 @@ public:
         memset(&dst_img, 0, sizeof(exynos_mpp_img));
         mode = __mode;
         protection_enabled = false;
+        persistent_session = false;
         gsc_fd = -1;
         src_info.buf.buf_type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
         dst_info.buf.buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
@@ -181,6 +184,7 @@ public:
         memset(&src_img, 0, sizeof(exynos_mpp_img));
         memset(&dst_img, 0, sizeof(exynos_mpp_img));
         protection_enabled = false;
+        persistent_session = false;
         gsc_fd = -1;
         src_info.buf.buf_type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
         dst_info.buf.buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
@@ -208,6 +212,7 @@ public:
     virtual int FreeMpp(void *handle);
     virtual int SetInputCrop(void *handle, exynos_mpp_img *src, exynos_mpp_img *dst);
     bool m_gsc_find_and_create(void *handle);
+    static int m_gsc_get_wait_histogram(unsigned int *counts, int num_buckets);
     bool m_gsc_out_destroy(void *handle);
     bool m_gsc_cap_destroy(void *handle);
     bool m_gsc_m2m_destroy(void *handle);
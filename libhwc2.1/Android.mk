@@ -134,6 +134,7 @@ LOCAL_SRC_FILES := \
 	DisplaySceneInfo.cpp \
 	ExynosHWCDebug.cpp \
 	libdevice/BrightnessController.cpp \
+	libdevice/BufferDumper.cpp \
 	libdevice/ExynosDisplay.cpp \
 	libdevice/ExynosDevice.cpp \
 	libdevice/ExynosLayer.cpp \
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include "BufferDumper.h"
+
+#include <fcntl.h>
+#include <sync/sync.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <system/thread_defs.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <fstream>
+#include <iterator>
+
+#include "VendorGraphicBuffer.h"
+#include "exynos_sync.h"
+
+using vendor::graphics::VendorGraphicBufferMeta;
+
+BufferDumper::BufferDumper(const std::string& displayName, size_t maxPendingBytes)
+      : mDisplayName(displayName), mMaxPendingBytes(maxPendingBytes) {
+    mTimeline = open("/sys/kernel/debug/sync/sw_sync", O_RDWR | O_CLOEXEC);
+    if (mTimeline < 0) mTimeline = open("/dev/sw_sync", O_RDWR | O_CLOEXEC);
+    if (mTimeline < 0)
+        ALOGW("%s: sw_sync is not available, buffers are copied at present", __func__);
+
+    mThread = std::thread(&BufferDumper::threadLoop, this);
+    pthread_setname_np(mThread.native_handle(), "BufferDumper");
+}
+
+BufferDumper::~BufferDumper() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable()) mThread.join();
+    // Closing the timeline signals any fence left
+    if (mTimeline >= 0) close(mTimeline);
+}
+
+bool BufferDumper::captureBuffer(Frame& frame, const String8& prefix, const exynos_image& image,
+                                 std::ostream& configFile) {
+    ATRACE_NAME(prefix.c_str());
+    if (image.bufferHandle == nullptr) {
+        ALOGE("%s: Buffer handle for %s is NULL", __func__, prefix.c_str());
+        return false;
+    }
+
+    VendorGraphicBufferMeta gmeta(image.bufferHandle);
+    Buffer buffer;
+
+    // dump buffer info
+    dumpExynosImage(buffer.info, image);
+    buffer.info.appendFormat("\nfd[%d, %d, %d] size[%d, %d, %d]\n", gmeta.fd, gmeta.fd1,
+                             gmeta.fd2, gmeta.size, gmeta.size1, gmeta.size2);
+    buffer.info.appendFormat(" offset[%d, %d, %d] format:%d framework_format:%d\n", gmeta.offset,
+                             gmeta.offset1, gmeta.offset2, gmeta.format, gmeta.frameworkFormat);
+    buffer.info.appendFormat(" width:%d height:%d stride:%d vstride:%d\n", gmeta.width,
+                             gmeta.height, gmeta.stride, gmeta.vstride);
+    buffer.info.appendFormat(" producer: 0x%" PRIx64 " consumer: 0x%" PRIx64 " flags: 0x%" PRIx32
+                             "\n",
+                             gmeta.producer_usage, gmeta.consumer_usage, gmeta.flags);
+
+    buffer.infoPath = String8::format("%s/%s-info.txt", kDumpPath, prefix.c_str());
+    buffer.bufferPath =
+            String8::format("%s/%s-%s.raw", kDumpPath, prefix.c_str(),
+                            getFormatStr(image.format, image.compressionInfo.type).c_str());
+
+    // The duplicated fds keep the memory of the buffer until it is copied
+    if (image.acquireFenceFd > 0) buffer.acquireFence = dup(image.acquireFenceFd);
+    int bufferNumber = getBufferNumOfFormat(image.format, image.compressionInfo.type);
+    for (int i = 0; i < bufferNumber; ++i) {
+        if (gmeta.fds[i] <= 0) {
+            ALOGE("%s: gmeta.fds[%d]=%d is invalid", __func__, i, gmeta.fds[i]);
+            continue;
+        }
+        if (gmeta.sizes[i] <= 0) {
+            ALOGE("%s: gmeta.sizes[%d]=%d is invalid", __func__, i, gmeta.sizes[i]);
+            continue;
+        }
+        int fd = dup(gmeta.fds[i]);
+        if (fd < 0) {
+            ALOGE("%s: failed to dup fds[%d]:%d for %s", __func__, i, gmeta.fds[i],
+                  prefix.c_str());
+            continue;
+        }
+        buffer.fds.push_back(fd);
+        buffer.sizes.push_back(gmeta.sizes[i]);
+    }
+
+    if (mTimeline < 0) copyBuffer(buffer);
+
+    // dump info that can be loaded by hwc-tester
+    configFile << "buffers {\n";
+    configFile << "    key: \"" << prefix << "\"\n";
+    configFile << "    format: " << getFormatStr(image.format, image.compressionInfo.type) << "\n";
+    configFile << "    width: " << gmeta.width << "\n";
+    configFile << "    height: " << gmeta.height << "\n";
+    auto usage = gmeta.producer_usage | gmeta.consumer_usage;
+    configFile << "    usage: 0x" << std::hex << usage << std::dec << "\n";
+    configFile << "    filepath: \"" << buffer.bufferPath << "\"\n";
+    configFile << "}\n" << std::endl;
+
+    frame.buffers.push_back(std::move(buffer));
+    return true;
+}
+
+void BufferDumper::copyBuffer(Buffer& buffer) {
+    ATRACE_NAME(buffer.bufferPath.c_str());
+
+    // TODO(b/261232489): Fix fence sync errors
+    // We currently ignore the fence errors and just dump the buffers
+    if (buffer.acquireFence >= 0 && sync_wait(buffer.acquireFence, 1000) < 0) {
+        buffer.info.appendFormat("Failed to sync acquire fence\n");
+        ALOGE("%s: Failed to wait acquire fence %d, errno=(%d, %s)", __func__,
+              buffer.acquireFence, errno, strerror(errno));
+    }
+
+    for (size_t i = 0; i < buffer.fds.size(); ++i) {
+        auto addr = mmap(0, buffer.sizes[i], PROT_READ, MAP_SHARED, buffer.fds[i], 0);
+        if (addr == MAP_FAILED || addr == NULL) {
+            ALOGE("%s: failed to mmap fd %d for %s", __func__, buffer.fds[i],
+                  buffer.bufferPath.c_str());
+            continue;
+        }
+        const char* data = static_cast<const char*>(addr);
+        buffer.planes.emplace_back(data, data + buffer.sizes[i]);
+        munmap(addr, buffer.sizes[i]);
+    }
+
+    closeBuffer(buffer);
+}
+
+void BufferDumper::closeBuffer(Buffer& buffer) {
+    if (buffer.acquireFence >= 0) close(buffer.acquireFence);
+    buffer.acquireFence = -1;
+    for (int fd : buffer.fds) close(fd);
+    buffer.fds.clear();
+}
+
+size_t BufferDumper::frameBytes(const Frame& frame) {
+    size_t bytes = 0;
+    for (auto& buffer : frame.buffers)
+        for (size_t size : buffer.sizes) bytes += size;
+    return bytes;
+}
+
+bool BufferDumper::hasRoom() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFrames.empty() || mPendingBytes < mMaxPendingBytes;
+}
+
+int BufferDumper::queue(Frame&& frame) {
+    int holdFence = -1;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // The files of a new session have the same names as the ones of the old session.
+        // The dropped frames stay queued because their hold fences are signaled in order.
+        for (auto it = std::next(mFrames.begin(), mWriting ? 1 : 0); it != mFrames.end(); ++it) {
+            if (it->dropped || it->frame.session == frame.session) continue;
+            ALOGW("%s: drop frame %03d of an old session", mDisplayName.c_str(),
+                  it->frame.number);
+            it->dropped = true;
+            mDroppedFrames++;
+        }
+
+        // hasRoom() is checked before the frame is captured, so the bound is exceeded
+        // by at most one frame
+        PendingFrame pending;
+        if (mTimeline >= 0) {
+            struct sw_sync_create_fence_data data = {};
+            data.value = ++mHoldPoint;
+            snprintf(data.name, sizeof(data.name), "hwc_dump_%03d", frame.number);
+            if (ioctl(mTimeline, SW_SYNC_IOC_CREATE_FENCE, &data) < 0)
+                ALOGE("%s: failed to create hold fence, errno=(%d, %s)", __func__, errno,
+                      strerror(errno));
+            else
+                holdFence = data.fence;
+            pending.held = true;
+        }
+        pending.frame = std::move(frame);
+        mPendingBytes += frameBytes(pending.frame);
+        mFrames.push_back(std::move(pending));
+    }
+    mCondition.notify_one();
+    return holdFence;
+}
+
+void BufferDumper::writeBuffer(const Buffer& buffer) {
+    ATRACE_NAME(buffer.bufferPath.c_str());
+
+    std::ofstream infoFile(buffer.infoPath.c_str());
+    if (!infoFile) {
+        ALOGE("%s: failed to open file %s", __func__, buffer.infoPath.c_str());
+        return;
+    }
+    infoFile << buffer.info << std::endl;
+
+    std::ofstream bufferFile(buffer.bufferPath.c_str(), std::ios::binary);
+    if (!bufferFile) {
+        ALOGE("%s: failed to open file %s", __func__, buffer.bufferPath.c_str());
+        return;
+    }
+
+    for (auto& plane : buffer.planes) bufferFile.write(plane.data(), plane.size());
+}
+
+void BufferDumper::writeFrame(const Frame& frame) {
+    ATRACE_CALL();
+    ALOGI("%s: dumping frame %03d", mDisplayName.c_str(), frame.number);
+
+    std::ofstream infoFile(frame.displayInfoPath.c_str());
+    if (!infoFile) {
+        ALOGE("%s: failed to open file %s", __func__, frame.displayInfoPath.c_str());
+        return;
+    }
+    infoFile << frame.displayInfo << std::endl;
+
+    for (auto& buffer : frame.buffers) writeBuffer(buffer);
+
+    std::ofstream configFile(frame.testerConfigPath.c_str());
+    if (!configFile) {
+        ALOGE("%s: failed to open file %s", __func__, frame.testerConfigPath.c_str());
+        return;
+    }
+    configFile << frame.testerConfig;
+}
+
+void BufferDumper::threadLoop() {
+    setpriority(PRIO_PROCESS, 0, ANDROID_PRIORITY_BACKGROUND);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this] { return mExit || !mFrames.empty(); });
+        // The pending frames are copied and written before exiting
+        if (mFrames.empty()) break;
+
+        // The frame stays in the list until it is written to account its buffers
+        PendingFrame& pending = mFrames.front();
+        bool dropped = pending.dropped;
+        mWriting = true;
+        lock.unlock();
+
+        for (auto& buffer : pending.frame.buffers) {
+            if (dropped)
+                closeBuffer(buffer);
+            else
+                copyBuffer(buffer);
+        }
+
+        // The producers may write the buffers from now on
+        if (pending.held) {
+            __u32 step = 1;
+            if (ioctl(mTimeline, SW_SYNC_IOC_INC, &step) < 0)
+                ALOGE("%s: failed to signal hold fence, errno=(%d, %s)", __func__, errno,
+                      strerror(errno));
+        }
+
+        if (!dropped) writeFrame(pending.frame);
+
+        lock.lock();
+        mWriting = false;
+        mPendingBytes -= frameBytes(pending.frame);
+        if (!dropped) mWrittenFrames++;
+        mFrames.pop_front();
+    }
+}
+
+void BufferDumper::dump(String8& result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    result.appendFormat("Buffer dump: written %u, dropped %u, pending %zu (%zu / %zu bytes)%s\n",
+                        mWrittenFrames, mDroppedFrames, mFrames.size(), mPendingBytes,
+                        mMaxPendingBytes, (mTimeline < 0) ? ", copied at present" : "");
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BUFFER_DUMPER_H_
+#define _BUFFER_DUMPER_H_
+
+#include <utils/String8.h>
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ExynosHWCHelper.h"
+
+using android::String8;
+
+// BufferDumper writes the frames captured by ExynosDisplay::dumpAllBuffers from a
+// low priority thread so that the present path does not wait for the file system.
+// The present path only duplicates the buffer fds. The worker waits for the acquire
+// fences and copies the contents, then signals the hold fence of the frame, which
+// is merged into the release fences of the dumped buffers so that the producers do
+// not write the buffers before they are copied. Without sw_sync the contents are
+// copied by captureBuffer() instead. The total size of the contents held by the
+// pending frames is bounded by maxPendingBytes.
+class BufferDumper {
+public:
+    static constexpr const char* kDumpPath = "/data/vendor/log/hwc";
+
+    struct Buffer {
+        String8 info;
+        String8 infoPath;
+        String8 bufferPath;
+        // Owned until the contents are copied into planes
+        int acquireFence = -1;
+        std::vector<int> fds;
+        std::vector<size_t> sizes;
+        std::vector<std::vector<char>> planes;
+    };
+
+    struct Frame {
+        // The frames of an older session are not written, see queue()
+        int session = 0;
+        int number = 0;
+        String8 displayInfo;
+        String8 displayInfoPath;
+        std::string testerConfig;
+        String8 testerConfigPath;
+        std::vector<Buffer> buffers;
+    };
+
+    BufferDumper(const std::string& displayName, size_t maxPendingBytes);
+    ~BufferDumper();
+
+    // Adds the buffer of @image to @frame. Returns false if the buffer cannot be
+    // captured.
+    bool captureBuffer(Frame& frame, const String8& prefix, const exynos_image& image,
+                       std::ostream& configFile);
+
+    // Returns false if the pending frames already hold maxPendingBytes so that the
+    // caller can skip capturing a frame.
+    bool hasRoom();
+
+    // Passes @frame to the worker and returns the hold fence of @frame, or -1 if the
+    // contents are already copied. The frames of an older session which are not
+    // being written yet are not written as their files would be overwritten by @frame.
+    int queue(Frame&& frame);
+
+    void dump(String8& result);
+
+private:
+    struct PendingFrame {
+        Frame frame;
+        bool held = false; // the worker signals the timeline for this frame
+        bool dropped = false;
+    };
+
+    static size_t frameBytes(const Frame& frame);
+    static void copyBuffer(Buffer& buffer);
+    static void closeBuffer(Buffer& buffer);
+    static void writeBuffer(const Buffer& buffer);
+    void writeFrame(const Frame& frame);
+    void threadLoop();
+
+    const std::string mDisplayName;
+    const size_t mMaxPendingBytes;
+    // sw_sync timeline advanced once per held frame, -1 if sw_sync is not available
+    int mTimeline = -1;
+    uint32_t mHoldPoint = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::list<PendingFrame> mFrames;
+    size_t mPendingBytes = 0;
+    bool mWriting = false; // mFrames.front() is being copied or written
+    bool mExit = false;
+    uint32_t mWrittenFrames = 0;
+    uint32_t mDroppedFrames = 0;
+
+    std::thread mThread;
+};
+
+#endif // _BUFFER_DUMPER_H_
@@ -38,6 +38,7 @@
 #include <map>
 
 #include "BrightnessController.h"
+#include "BufferDumper.h"
 #include "DisplayTe2Manager.h"
 #include "ExynosExternalDisplay.h"
 #include "ExynosLayer.h"
@@ -62,7 +63,11 @@ namespace AidlCommon = ::aidl::android::hardware::graphics::common;
 extern struct exynos_hwc_control exynosHWCControl;
 extern struct update_time_info updateTimeInfo;
 
-constexpr const char* kBufferDumpPath = "/data/vendor/log/hwc";
+// Size of the layer buffers held by the frames waiting for BufferDumper
+constexpr size_t kBufferDumpMaxPendingBytes = 256 * 1024 * 1024;
+
+// DSI transfer setup of a partial region in the unit of panel lines
+constexpr uint32_t kPartialRegionOverheadLines = 4;
 
 constexpr float kDynamicRecompFpsThreshold = 1.0 / 5.0; // 1 frame update per 5 second
 
@@ -1184,6 +1189,7 @@ int32_t ExynosDisplay::destroyLayer(hwc2_layer_t outLayer) {
         return HWC2_ERROR_BAD_LAYER;
     }
 
+    mLayerHandles.erase(layer);
     if (mLayers.remove(layer) < 0) {
         auto it = std::find(mIgnoreLayers.begin(), mIgnoreLayers.end(), layer);
         if (it == mIgnoreLayers.end()) {
@@ -1214,6 +1220,7 @@ int32_t ExynosDisplay::destroyLayer(hwc2_layer_t outLayer) {
  */
 void ExynosDisplay::destroyLayers() {
     Mutex::Autolock lock(mDRMutex);
+    mLayerHandles.clear();
     for (uint32_t index = 0; index < mLayers.size();) {
         ExynosLayer *layer = mLayers[index];
         mLayers.removeAt(index);
@@ -1229,22 +1236,23 @@ void ExynosDisplay::destroyLayers() {
 
 ExynosLayer *ExynosDisplay::checkLayer(hwc2_layer_t addr) {
     ExynosLayer *temp = (ExynosLayer *)addr;
-    if (!mLayers.isEmpty()) {
-        for (size_t i = 0; i < mLayers.size(); i++) {
-            if (mLayers[i] == temp)
-                return mLayers[i];
-        }
-    }
-
-    if (mIgnoreLayers.size()) {
-        auto it = std::find(mIgnoreLayers.begin(), mIgnoreLayers.end(), temp);
-        return (it == mIgnoreLayers.end()) ? NULL : *it;
-    }
+    if (mLayerHandles.count(temp))
+        return temp;
 
-    ALOGE("HWC2 : %s : %d, wrong layer request!", __func__, __LINE__);
+    if (mIgnoreLayers.empty())
+        ALOGE("HWC2 : %s : %d, wrong layer request!", __func__, __LINE__);
     return NULL;
 }
 
+void ExynosDisplay::setLayerStates(const std::vector<ExynosLayerStateDelta>& deltas,
+                                   std::vector<int32_t>& outErrors) {
+    outErrors.resize(deltas.size());
+    for (size_t i = 0; i < deltas.size(); i++) {
+        ExynosLayer *layer = checkLayer(deltas[i].layer);
+        outErrors[i] = layer ? layer->applyStateDelta(deltas[i]) : HWC2_ERROR_BAD_LAYER;
+    }
+}
+
 void ExynosDisplay::checkIgnoreLayers() {
     Mutex::Autolock lock(mDRMutex);
     for (auto it = mIgnoreLayers.begin(); it != mIgnoreLayers.end();) {
@@ -3023,6 +3031,7 @@ int32_t ExynosDisplay::createLayer(hwc2_layer_t* outLayer) {
 
     /* TODO : Sort sequence should be added to somewhere */
     mLayers.add((ExynosLayer*)layer);
+    mLayerHandles.insert(layer);
 
     /* TODO : Set z-order to max, check outLayer address? */
     layer->setLayerZOrder(1000);
@@ -3437,126 +3446,45 @@ bool ExynosDisplay::isFullScreenComposition() {
     return true;
 }
 
-void dumpBuffer(const String8& prefix, const exynos_image& image, std::ofstream& configFile) {
-    ATRACE_NAME(prefix.c_str());
-    if (image.bufferHandle == nullptr) {
-        ALOGE("%s: Buffer handle for %s is NULL", __func__, prefix.c_str());
-        return;
-    }
-    ALOGI("%s: dumping buffer for %s", __func__, prefix.c_str());
-
-    bool failFenceSync = false;
-    String8 infoDump;
-    if (image.acquireFenceFd > 0 && sync_wait(image.acquireFenceFd, 1000) < 0) {
-        infoDump.appendFormat("Failed to sync acquire fence\n");
-        ALOGE("%s: Failed to wait acquire fence %d, errno=(%d, %s)", __func__, image.acquireFenceFd,
-              errno, strerror(errno));
-        failFenceSync = true;
-    }
-    if (image.releaseFenceFd > 0 && sync_wait(image.releaseFenceFd, 1000) < 0) {
-        infoDump.appendFormat("Failed to sync release fence\n");
-
-        ALOGE("%s: Failed to wait release fence %d, errno=(%d, %s)", __func__, image.releaseFenceFd,
-              errno, strerror(errno));
-        failFenceSync = true;
-    }
-
-    VendorGraphicBufferMeta gmeta(image.bufferHandle);
-    String8 infoPath = String8::format("%s/%s-info.txt", kBufferDumpPath, prefix.c_str());
-    std::ofstream infoFile(infoPath.c_str());
-    if (!infoFile) {
-        ALOGE("%s: failed to open file %s", __func__, infoPath.c_str());
-        return;
-    }
+void ExynosDisplay::dumpAllBuffers() {
+    ATRACE_CALL();
+    if (!mBufferDumper)
+        mBufferDumper = std::make_unique<BufferDumper>(mDisplayName, kBufferDumpMaxPendingBytes);
 
-    // TODO(b/261232489): Fix fence sync errors
-    // We currently ignore the fence errors and just dump the buffers
-
-    // dump buffer info
-    dumpExynosImage(infoDump, image);
-    infoDump.appendFormat("\nfd[%d, %d, %d] size[%d, %d, %d]\n", gmeta.fd, gmeta.fd1, gmeta.fd2,
-                          gmeta.size, gmeta.size1, gmeta.size2);
-    infoDump.appendFormat(" offset[%d, %d, %d] format:%d framework_format:%d\n", gmeta.offset,
-                          gmeta.offset1, gmeta.offset2, gmeta.format, gmeta.frameworkFormat);
-    infoDump.appendFormat(" width:%d height:%d stride:%d vstride:%d\n", gmeta.width, gmeta.height,
-                          gmeta.stride, gmeta.vstride);
-    infoDump.appendFormat(" producer: 0x%" PRIx64 " consumer: 0x%" PRIx64 " flags: 0x%" PRIx32 "\n",
-                          gmeta.producer_usage, gmeta.consumer_usage, gmeta.flags);
-    infoFile << infoDump << std::endl;
-
-    String8 bufferPath =
-            String8::format("%s/%s-%s.raw", kBufferDumpPath, prefix.c_str(),
-                            getFormatStr(image.format, image.compressionInfo.type).c_str());
-    std::ofstream bufferFile(bufferPath.c_str(), std::ios::binary);
-    if (!bufferFile) {
-        ALOGE("%s: failed to open file %s", __func__, bufferPath.c_str());
-        return;
-    }
+    // The frame is captured again at the next present when mBufferDumper has no room
+    if (!mBufferDumper->hasRoom()) return;
 
-    // dump info that can be loaded by hwc-tester
-    configFile << "buffers {\n";
-    configFile << "    key: \"" << prefix << "\"\n";
-    configFile << "    format: " << getFormatStr(image.format, image.compressionInfo.type) << "\n";
-    configFile << "    width: " << gmeta.width << "\n";
-    configFile << "    height: " << gmeta.height << "\n";
-    auto usage = gmeta.producer_usage | gmeta.consumer_usage;
-    configFile << "    usage: 0x" << std::hex << usage << std::dec << "\n";
-    configFile << "    filepath: \"" << bufferPath << "\"\n";
-    configFile << "}\n" << std::endl;
-
-    int bufferNumber = getBufferNumOfFormat(image.format, image.compressionInfo.type);
-    for (int i = 0; i < bufferNumber; ++i) {
-        if (gmeta.fds[i] <= 0) {
-            ALOGE("%s: gmeta.fds[%d]=%d is invalid", __func__, i, gmeta.fds[i]);
-            continue;
-        }
-        if (gmeta.sizes[i] <= 0) {
-            ALOGE("%s: gmeta.sizes[%d]=%d is invalid", __func__, i, gmeta.sizes[i]);
-            continue;
-        }
-        auto addr = mmap(0, gmeta.sizes[i], PROT_READ | PROT_WRITE, MAP_SHARED, gmeta.fds[i], 0);
-        if (addr != MAP_FAILED && addr != NULL) {
-            bufferFile.write(static_cast<char*>(addr), gmeta.sizes[i]);
-            munmap(addr, gmeta.sizes[i]);
-        } else {
-            ALOGE("%s: failed to mmap fds[%d]:%d for %s", __func__, i, gmeta.fds[i]);
-        }
-    }
-}
+    // The files are written by mBufferDumper, only the buffer fds are duplicated here
+    BufferDumper::Frame frame;
+    frame.session = mBufferDumpFrameSession;
+    frame.number = mBufferDumpNum;
 
-void ExynosDisplay::dumpAllBuffers() {
-    ATRACE_CALL();
     // dump layers info
-    String8 infoPath = String8::format("%s/%03d-display-info.txt", kBufferDumpPath, mBufferDumpNum);
-    std::ofstream infoFile(infoPath.c_str());
-    if (!infoFile) {
-        DISPLAY_LOGE("%s: failed to open file %s", __func__, infoPath.c_str());
-        ++mBufferDumpNum;
-        return;
-    }
-    String8 displayDump;
-    dumpLocked(displayDump);
-    infoFile << displayDump << std::endl;
-
-    // dump buffer contents & infos
-    std::vector<String8> allLayerKeys;
-    String8 testerConfigPath =
-            String8::format("%s/%03d-hwc-tester-config.textproto", kBufferDumpPath, mBufferDumpNum);
-    std::ofstream configFile(testerConfigPath.c_str());
-    configFile << std::string(15, '#')
-               << " You can load this config file using hwc-tester to reproduce this frame "
-               << std::string(15, '#') << std::endl;
+    frame.displayInfoPath = String8::format("%s/%03d-display-info.txt", BufferDumper::kDumpPath,
+                                            mBufferDumpNum);
+    dumpLocked(frame.displayInfo);
+
+    struct DumpedLayer {
+        ExynosLayer* layer;
+        int index;
+        String8 prefix;
+        exynos_image srcImg;
+        bool hasMidImg;
+        exynos_image midImg;
+        std::string config;
+    };
+    std::vector<DumpedLayer> dumpedLayers;
     {
         std::scoped_lock lock(mDRMutex);
         for (int i = 0; i < mLayers.size(); ++i) {
-            String8 prefix = String8::format("%03d-%d-src", mBufferDumpNum, i);
-            dumpBuffer(prefix, mLayers[i]->mSrcImg, configFile);
-            if (mLayers[i]->mM2mMPP != nullptr) {
-                String8 midPrefix = String8::format("%03d-%d-mid", mBufferDumpNum, i);
-                exynos_image image = mLayers[i]->mMidImg;
-                mLayers[i]->mM2mMPP->getDstImageInfo(&image);
-                dumpBuffer(midPrefix, image, configFile);
+            DumpedLayer dumped = {mLayers[i], i, String8::format("%03d-%d-src", mBufferDumpNum, i),
+                                  mLayers[i]->mSrcImg, mLayers[i]->mM2mMPP != nullptr};
+            if (dumped.hasMidImg) {
+                dumped.midImg = mLayers[i]->mMidImg;
+                mLayers[i]->mM2mMPP->getDstImageInfo(&dumped.midImg);
             }
+            const String8& prefix = dumped.prefix;
+            std::ostringstream configFile;
             configFile << "layers {\n";
             configFile << "    key: \"" << prefix << "\"\n";
             configFile << "    composition: "
@@ -3596,24 +3524,42 @@ void ExynosDisplay::dumpAllBuffers() {
             configFile << "    z_order: " << mLayers[i]->mZOrder << "\n";
             if (mLayers[i]->mRequestedCompositionType == HWC2_COMPOSITION_SOLID_COLOR) {
                 configFile << "    color: {\n";
-                configFile << "        r: " << mLayers[i]->mColor.r << "\n";
-                configFile << "        g: " << mLayers[i]->mColor.g << "\n";
-                configFile << "        b: " << mLayers[i]->mColor.b << "\n";
-                configFile << "        a: " << mLayers[i]->mColor.a << "\n";
+                configFile << "        r: " << static_cast<int>(mLayers[i]->mColor.r) << "\n";
+                configFile << "        g: " << static_cast<int>(mLayers[i]->mColor.g) << "\n";
+                configFile << "        b: " << static_cast<int>(mLayers[i]->mColor.b) << "\n";
+                configFile << "        a: " << static_cast<int>(mLayers[i]->mColor.a) << "\n";
                 configFile << "    }\n";
             } else if (mLayers[i]->mSrcImg.bufferHandle != nullptr) {
                 configFile << "    buffer_key: \"" << prefix << "\"\n";
             }
             configFile << "}\n" << std::endl;
-            allLayerKeys.push_back(prefix);
+            dumped.config = configFile.str();
+            dumpedLayers.push_back(std::move(dumped));
         }
     }
 
-    if (mClientCompositionInfo.mHasCompositionLayer) {
+    // dump buffer contents & infos
+    frame.testerConfigPath = String8::format("%s/%03d-hwc-tester-config.textproto",
+                                             BufferDumper::kDumpPath, mBufferDumpNum);
+    std::ostringstream configFile;
+    configFile << std::string(15, '#')
+               << " You can load this config file using hwc-tester to reproduce this frame "
+               << std::string(15, '#') << std::endl;
+    for (auto& dumped : dumpedLayers) {
+        mBufferDumper->captureBuffer(frame, dumped.prefix, dumped.srcImg, configFile);
+        if (dumped.hasMidImg) {
+            String8 midPrefix = String8::format("%03d-%d-mid", mBufferDumpNum, dumped.index);
+            mBufferDumper->captureBuffer(frame, midPrefix, dumped.midImg, configFile);
+        }
+        configFile << dumped.config;
+    }
+
+    bool hasClientTarget = mClientCompositionInfo.mHasCompositionLayer;
+    if (hasClientTarget) {
         String8 prefix = String8::format("%03d-client-target", mBufferDumpNum);
         exynos_image src, dst;
         setCompositionTargetExynosImage(COMPOSITION_CLIENT, &src, &dst);
-        dumpBuffer(prefix, src, configFile);
+        mBufferDumper->captureBuffer(frame, prefix, src, configFile);
     }
 
     configFile << "timelines {\n";
@@ -3624,14 +3570,42 @@ void ExynosDisplay::dumpAllBuffers() {
                << AidlComposer3::toString(static_cast<AidlComposer3::ColorMode>(mColorMode))
                << "\n";
     configFile << std::endl;
-    for (auto& layerKey : allLayerKeys) {
+    for (auto& dumped : dumpedLayers) {
         configFile << "    layers: {\n";
-        configFile << "        layer_key: \"" << layerKey << "\"\n";
+        configFile << "        layer_key: \"" << dumped.prefix << "\"\n";
         configFile << "    }\n";
     }
     configFile << "}" << std::endl;
+    frame.testerConfig = configFile.str();
 
+    int holdFence = mBufferDumper->queue(std::move(frame));
     ++mBufferDumpNum;
+    if (holdFence < 0) return;
+
+    // The producers must not write the dumped buffers until they are copied. SurfaceFlinger
+    // releases a layer buffer by its release fence and the client target by the retire fence.
+    {
+        std::scoped_lock lock(mDRMutex);
+        for (auto& dumped : dumpedLayers) {
+            if (std::find(mLayers.begin(), mLayers.end(), dumped.layer) == mLayers.end())
+                continue;
+            if (dumped.srcImg.bufferHandle != nullptr) {
+                int fence = hwc_dup(holdFence, this, FENCE_TYPE_SRC_RELEASE, FENCE_IP_LAYER);
+                dumped.layer->mReleaseFence =
+                        hwc_fence_merge(dumped.layer->mReleaseFence, fence, this,
+                                        FENCE_TYPE_SRC_RELEASE, FENCE_IP_LAYER);
+            }
+            if (dumped.hasMidImg && dumped.midImg.bufferHandle != nullptr)
+                dumped.layer->mM2mMPP->holdDstBuffer(
+                        hwc_dup(holdFence, this, FENCE_TYPE_DST_ACQUIRE, FENCE_IP_LAYER, true));
+        }
+    }
+    if (hasClientTarget && (mDpuData.retire_fence >= 0)) {
+        int fence = hwc_dup(holdFence, this, FENCE_TYPE_RETIRE, FENCE_IP_DPP);
+        mDpuData.retire_fence = hwc_fence_merge(mDpuData.retire_fence, fence, this,
+                                                FENCE_TYPE_RETIRE, FENCE_IP_DPP);
+    }
+    hwcFdClose(holdFence);
 }
 
 int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
@@ -3674,6 +3648,9 @@ int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
     }
 
     Mutex::Autolock lock(mDisplayMutex);
+    const nsecs_t presentStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    funcReturnCallback presentLatencyCallback(
+            [&]() { recordStageLatency(CompositionStage::PRESENT, presentStartTime); });
 
     if (!mHpdStatus) {
         ALOGD("presentDisplay: drop frame: mHpdStatus == false");
@@ -3879,15 +3856,24 @@ int32_t ExynosDisplay::presentDisplay(int32_t* outRetireFence) {
 
     setDisplayWinConfigData();
 
+    nsecs_t stageStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
     if ((ret = deliverWinConfigData()) != NO_ERROR) {
         HWC_LOGE(this, "%s:: fail to deliver win_config (%d)", __func__, ret);
         if (mDpuData.retire_fence > 0)
             fence_close(mDpuData.retire_fence, this, FENCE_TYPE_RETIRE, FENCE_IP_DPP);
         mDpuData.retire_fence = -1;
     }
+    recordStageLatency(CompositionStage::DELIVER_WIN_CONFIG, stageStartTime);
 
+    stageStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
     setReleaseFences();
+    recordStageLatency(CompositionStage::SET_RELEASE_FENCES, stageStartTime);
 
+    int bufferDumpSession = mBufferDumpSession;
+    if (bufferDumpSession != mBufferDumpFrameSession) {
+        mBufferDumpFrameSession = bufferDumpSession;
+        mBufferDumpNum = 0;
+    }
     if (mBufferDumpNum < mBufferDumpCount) {
         dumpAllBuffers();
     }
@@ -4880,6 +4866,9 @@ int32_t ExynosDisplay::validateDisplay(
     DISPLAY_ATRACE_CALL();
     gettimeofday(&updateTimeInfo.lastValidateTime, NULL);
     Mutex::Autolock lock(mDisplayMutex);
+    const nsecs_t validateStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    funcReturnCallback validateLatencyCallback(
+            [&]() { recordStageLatency(CompositionStage::VALIDATE, validateStartTime); });
 
     if (!mHpdStatus) {
         ALOGD("validateDisplay: drop frame: mHpdStatus == false");
@@ -4933,7 +4922,10 @@ int32_t ExynosDisplay::validateDisplay(
             mDevice->dynamicRecompositionThreadCreate();
     }
 
-    if ((ret = mResourceManager->assignResource(this)) != NO_ERROR) {
+    const nsecs_t assignStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    ret = mResourceManager->assignResource(this);
+    recordStageLatency(CompositionStage::ASSIGN_RESOURCE, assignStartTime);
+    if (ret != NO_ERROR) {
         validateError = true;
         HWC_LOGE(this, "%s:: assignResource() fail, display(%d), ret(%d)", __func__, mDisplayId, ret);
         String8 errString;
@@ -5143,6 +5135,37 @@ void ExynosDisplay::dumpLocked(String8& result) {
     if (mDisplayTe2Manager) {
         mDisplayTe2Manager->dump(result);
     }
+    if (mBufferDumper) {
+        mBufferDumper->dump(result);
+    }
+    if (mDisplayInterface) {
+        mDisplayInterface->dump(result);
+    }
+    dumpStageLatency(result);
+}
+
+void ExynosDisplay::recordStageLatency(CompositionStage stage, nsecs_t startTime) {
+    mStageLatency[toUnderlying(stage)].insert(systemTime(SYSTEM_TIME_MONOTONIC) - startTime);
+}
+
+void ExynosDisplay::dumpStageLatency(String8& result) {
+    static constexpr std::array<uint32_t, 4> kPercentiles = {50, 90, 99, 100};
+    static constexpr const char* kStageNames[] = {"validate", "assignResource", "present",
+                                                  "deliverWinConfigData", "setReleaseFences"};
+    static_assert(std::size(kStageNames) == toUnderlying(CompositionStage::MAX));
+
+    result.appendFormat("Composition stage latency (us) over last %zu frames:\n",
+                        kStageLatencyBufferSize);
+    for (uint32_t i = 0; i < toUnderlying(CompositionStage::MAX); i++) {
+        const auto& sampler = mStageLatency[i];
+        if (sampler.elems == 0) continue;
+        auto values = sampler.getPercentiles(kPercentiles);
+        result.appendFormat("\t%-22s samples %3zu, p50 %6" PRId64 ", p90 %6" PRId64
+                            ", p99 %6" PRId64 ", window max %6" PRId64 ", max %6" PRId64 "\n",
+                            kStageNames[i], sampler.elems, values[0] / 1000, values[1] / 1000,
+                            values[2] / 1000, values[3] / 1000, sampler.max / 1000);
+    }
+    result.appendFormat("\n");
 }
 
 void ExynosDisplay::dumpConfig(String8 &result, const exynos_win_config_data &c)
@@ -5745,6 +5768,7 @@ int ExynosDisplay::handleWindowUpdate()
     mDpuData.win_update_region.w = mXres;
     mDpuData.win_update_region.y = 0;
     mDpuData.win_update_region.h = mYres;
+    mDpuData.win_update_regions.clear();
 
     if (exynosHWCControl.windowUpdate != 1) return 0;
 
@@ -5768,6 +5792,7 @@ int ExynosDisplay::handleWindowUpdate()
 
     hwc_rect mergedRect = {(int)mXres, (int)mYres, 0, 0};
     hwc_rect damageRect = {(int)mXres, (int)mYres, 0, 0};
+    std::vector<hwc_rect> damageRects;
 
     for (size_t i = 0; i < mLayers.size(); i++) {
         if (mLayers[i]->mExynosCompositionType == HWC2_COMPOSITION_DISPLAY_DECORATION) {
@@ -5778,6 +5803,7 @@ int ExynosDisplay::handleWindowUpdate()
             DISPLAY_LOGD(eDebugWindowUpdate, "layer(%zu) partial : %d, %d, %d, %d", i,
                     damageRect.left, damageRect.top, damageRect.right, damageRect.bottom);
             mergedRect = expand(mergedRect, damageRect);
+            damageRects.push_back(damageRect);
         }
         else if (excp == eDamageRegionSkip) {
             int32_t windowIndex = mLayers[i]->mWindowIndex;
@@ -5791,10 +5817,12 @@ int ExynosDisplay::handleWindowUpdate()
                 DISPLAY_LOGD(eDebugWindowUpdate, "Skip layer (origin) : %d, %d, %d, %d",
                         damageRect.left, damageRect.top, damageRect.right, damageRect.bottom);
                 mergedRect = expand(mergedRect, damageRect);
+                damageRects.push_back(damageRect);
                 hwc_rect prevDst = {mLastDpuData.configs[i].dst.x, mLastDpuData.configs[i].dst.y,
                     mLastDpuData.configs[i].dst.x + (int)mLastDpuData.configs[i].dst.w,
                     mLastDpuData.configs[i].dst.y + (int)mLastDpuData.configs[i].dst.h};
                 mergedRect = expand(mergedRect, prevDst);
+                damageRects.push_back(prevDst);
             } else {
                 DISPLAY_LOGD(eDebugWindowUpdate, "layer(%zu) skip", i);
                 continue;
@@ -5808,6 +5836,7 @@ int ExynosDisplay::handleWindowUpdate()
             DISPLAY_LOGD(eDebugWindowUpdate, "Full layer update : %d, %d, %d, %d", mLayers[i]->mDisplayFrame.left,
                     mLayers[i]->mDisplayFrame.top, mLayers[i]->mDisplayFrame.right, mLayers[i]->mDisplayFrame.bottom);
             mergedRect = expand(mergedRect, damageRect);
+            damageRects.push_back(damageRect);
         }
         else {
             DISPLAY_LOGD(eDebugWindowUpdate, "Partial canceled, Skip reason (layer %zu) : %d", i, excp);
@@ -5829,6 +5858,31 @@ int ExynosDisplay::handleWindowUpdate()
     if (mergedRect.top < 0) mergedRect.top = 0;
     if (mergedRect.bottom > (int32_t)mYres) mergedRect.bottom = mYres;
 
+    /*
+     * Split the damage into several partial regions only if it saves the DSI
+     * bandwidth compared to the single bounding rect. Damages at the top and
+     * the bottom of the screen do not need the full frame update then.
+     */
+    uint32_t maxRegions = mDisplayInterface->getMaxPartialRegions();
+    if (maxRegions > 1 && damageRects.size() > 1) {
+        uint64_t regionOverhead = (uint64_t)mXres * kPartialRegionOverheadLines;
+        uint64_t mergedCost = (uint64_t)WIDTH(mergedRect) * HEIGHT(mergedRect) + regionOverhead;
+
+        for (auto &rect : damageRects) adjustRect(rect, mXres, mYres);
+        uint64_t cost = reduceDamageRegion(damageRects, maxRegions, regionOverhead);
+
+        if (damageRects.size() > 1 && cost < mergedCost) {
+            for (auto &rect : damageRects) {
+                DISPLAY_LOGD(eDebugWindowUpdate, "Partial region : %d, %d, %d, %d",
+                        rect.left, rect.top, rect.right, rect.bottom);
+                mDpuData.win_update_regions.push_back({rect.left, rect.top,
+                        (uint32_t)WIDTH(rect), (uint32_t)HEIGHT(rect), 0, 0});
+            }
+            DISPLAY_LOGD(eDebugWindowUpdate, "%zu partial regions, cost %" PRIu64 " (merged %" PRIu64 ")",
+                    damageRects.size(), cost, mergedCost);
+        }
+    }
+
     if (mergedRect.left == 0 && mergedRect.right == (int32_t)mXres &&
         mergedRect.top == 0 && mergedRect.bottom == (int32_t)mYres) {
         DISPLAY_LOGD(eDebugWindowUpdate, "Partial : Full size");
@@ -27,6 +27,7 @@
 #include <atomic>
 #include <chrono>
 #include <set>
+#include <unordered_set>
 
 #include "DeconHeader.h"
 #include "ExynosDisplayInterface.h"
@@ -59,11 +60,13 @@ typedef hwc2_composition_t exynos_composition;
 
 class BrightnessController;
 class ExynosLayer;
+struct ExynosLayerStateDelta;
 class ExynosDevice;
 class ExynosMPP;
 class ExynosMPPSource;
 class HistogramController;
 class DisplayTe2Manager;
+class BufferDumper;
 
 namespace aidl {
 namespace google {
@@ -242,6 +245,8 @@ struct exynos_dpu_data
     bool enable_win_update = false;
     std::atomic<bool> enable_readback = false;
     struct decon_frame win_update_region = {0, 0, 0, 0, 0, 0};
+    /* Partial regions inside win_update_region if more than one is updated */
+    std::vector<decon_frame> win_update_regions;
     struct exynos_readback_info readback_info;
 
     void init(size_t configNum, size_t rcdConfigNum) {
@@ -485,6 +490,8 @@ class ExynosDisplay {
          */
         ExynosSortedLayer mLayers;
         std::vector<ExynosLayer*> mIgnoreLayers;
+        /* All layers in mLayers and mIgnoreLayers, used to validate layer handles */
+        std::unordered_set<const ExynosLayer*> mLayerHandles;
 
         ExynosResourceManager *mResourceManager;
 
@@ -597,8 +604,28 @@ class ExynosDisplay {
 
         /* For debugging */
         hwc_display_contents_1_t *mHWC1LayerList;
-        int mBufferDumpCount = 0;
+        /* Set by ExynosHWCService::dumpBuffers, the count before the session */
+        std::atomic<int> mBufferDumpCount = 0;
+        std::atomic<int> mBufferDumpSession = 0;
+        /* The session and the number of the next frame dumped by presentDisplay */
+        int mBufferDumpFrameSession = 0;
         int mBufferDumpNum = 0;
+        std::unique_ptr<BufferDumper> mBufferDumper;
+
+        /* CPU latency of each stage of the composition path, reported by dump */
+        enum class CompositionStage : uint32_t {
+            VALIDATE = 0,
+            ASSIGN_RESOURCE,
+            PRESENT,
+            DELIVER_WIN_CONFIG,
+            SET_RELEASE_FENCES,
+            MAX,
+        };
+        static constexpr size_t kStageLatencyBufferSize = 256;
+        std::array<LatencySampler<kStageLatencyBufferSize>, toUnderlying(CompositionStage::MAX)>
+                mStageLatency;
+        void recordStageLatency(CompositionStage stage, nsecs_t startTime);
+        void dumpStageLatency(String8& result);
 
         /* Support Multi-resolution scheme */
         int mOldScalerMode;
@@ -657,6 +684,14 @@ class ExynosDisplay {
 
         ExynosLayer *checkLayer(hwc2_layer_t addr);
 
+        /**
+         * Applies the simple layer properties of one display command.
+         * Each layer is resolved once and reports one geometry change.
+         * @param outErrors error of each delta, HWC2_ERROR_NONE on success
+         */
+        void setLayerStates(const std::vector<ExynosLayerStateDelta>& deltas,
+                            std::vector<int32_t>& outErrors);
+
         void checkIgnoreLayers();
         virtual void doPreProcessing();
 
@@ -428,6 +428,11 @@ int32_t ExynosLayer::setLayerBuffer(buffer_handle_t buffer, int32_t acquireFence
                 mDisplay->mBufferUpdates++;
         }
     }
+
+    /* Create the DRM framebuffer of a new buffer ahead of presentDisplay() */
+    if ((mLayerBuffer != NULL) && (mLayerBuffer != mLastLayerBuffer) &&
+        (mDisplay->mDisplayInterface != nullptr))
+        mDisplay->mDisplayInterface->preImportLayerBuffer(this, mLayerBuffer);
     mPrevAcquireFence =
             fence_close(mPrevAcquireFence, mDisplay, FENCE_TYPE_SRC_ACQUIRE, FENCE_IP_UNDEFINED);
     mAcquireFence = fence_close(mAcquireFence, mDisplay, FENCE_TYPE_SRC_ACQUIRE, FENCE_IP_UNDEFINED);
@@ -642,6 +647,47 @@ int32_t ExynosLayer::setLayerZOrder(uint32_t z) {
     return HWC2_ERROR_NONE;
 }
 
+int32_t ExynosLayer::applyStateDelta(const ExynosLayerStateDelta& delta) {
+    int32_t ret = HWC2_ERROR_NONE;
+    auto apply = [&ret](int32_t err) {
+        if (err != HWC2_ERROR_NONE && ret == HWC2_ERROR_NONE) ret = err;
+    };
+    /*
+     * The per-field path skips the display update while the layer is a
+     * refresh rate indicator, checked at each call. Notify the display if
+     * the layer was not one at either end of the delta.
+     */
+    const bool wasRefreshRateIndicator =
+            (mRequestedCompositionType == HWC2_COMPOSITION_REFRESH_RATE_INDICATOR);
+
+    mDeferGeometryChanged = true;
+    mDeferredGeometryChanged = 0;
+
+    /* Same order as ComposerCommandEngine::dispatchLayerCommand() */
+    if (delta.blendMode) apply(ExynosLayer::setLayerBlendMode(*delta.blendMode));
+    if (delta.color) apply(ExynosLayer::setLayerColor(*delta.color));
+    if (delta.compositionType) apply(ExynosLayer::setLayerCompositionType(*delta.compositionType));
+    if (delta.dataspace) apply(ExynosLayer::setLayerDataspace(*delta.dataspace));
+    if (delta.displayFrame) apply(ExynosLayer::setLayerDisplayFrame(*delta.displayFrame));
+    if (delta.planeAlpha) apply(ExynosLayer::setLayerPlaneAlpha(*delta.planeAlpha));
+    if (delta.sourceCrop) apply(ExynosLayer::setLayerSourceCrop(*delta.sourceCrop));
+    if (delta.transform) apply(ExynosLayer::setLayerTransform(*delta.transform));
+    if (delta.z) apply(ExynosLayer::setLayerZOrder(*delta.z));
+    if (delta.brightness) apply(ExynosLayer::setLayerBrightness(*delta.brightness));
+
+    mDeferGeometryChanged = false;
+    if (mDeferredGeometryChanged) {
+        mLastUpdateTime = systemTime(CLOCK_MONOTONIC);
+        mGeometryChanged |= mDeferredGeometryChanged;
+        if (!wasRefreshRateIndicator ||
+            mRequestedCompositionType != HWC2_COMPOSITION_REFRESH_RATE_INDICATOR)
+            mDisplay->setGeometryChanged(mDeferredGeometryChanged);
+        mDeferredGeometryChanged = 0;
+    }
+
+    return ret;
+}
+
 int32_t ExynosLayer::setLayerPerFrameMetadata(uint32_t numElements,
         const int32_t* /*hw2_per_frame_metadata_key_t*/ keys, const float* metadata)
 {
@@ -1190,6 +1236,11 @@ void ExynosLayer::printLayer()
 
 void ExynosLayer::setGeometryChanged(uint64_t changedBit)
 {
+    if (mDeferGeometryChanged) {
+        mDeferredGeometryChanged |= changedBit;
+        return;
+    }
+
     mLastUpdateTime = systemTime(CLOCK_MONOTONIC);
     mGeometryChanged |= changedBit;
     if (mRequestedCompositionType != HWC2_COMPOSITION_REFRESH_RATE_INDICATOR)
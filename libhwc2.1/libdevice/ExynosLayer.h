@@ -24,6 +24,7 @@
 #include <utils/Timers.h>
 
 #include <array>
+#include <optional>
 #include <unordered_map>
 
 #include "ExynosDisplay.h"
@@ -82,6 +83,26 @@ enum {
     HWC2_COMPOSITION_EXYNOS = 32,
 };
 
+/*
+ * Simple layer properties carried by one LayerCommand. Each set field is
+ * applied by ExynosLayer::applyStateDelta() with a single geometry update
+ * for the whole delta. Buffer, sideband stream, regions and metadata keep
+ * going through their own setters.
+ */
+struct ExynosLayerStateDelta {
+    hwc2_layer_t layer = 0;
+    std::optional<int32_t> blendMode;
+    std::optional<hwc_color_t> color;
+    std::optional<int32_t> compositionType;
+    std::optional<int32_t> dataspace;
+    std::optional<hwc_rect_t> displayFrame;
+    std::optional<float> planeAlpha;
+    std::optional<hwc_frect_t> sourceCrop;
+    std::optional<int32_t> transform;
+    std::optional<uint32_t> z;
+    std::optional<float> brightness;
+};
+
 class ExynosLayer : public ExynosMPPSource {
     public:
 
@@ -389,6 +410,13 @@ class ExynosLayer : public ExynosMPPSource {
         virtual int32_t setLayerPerFrameMetadata(uint32_t numElements,
                 const int32_t* /*hw2_per_frame_metadata_key_t*/ keys, const float* metadata);
 
+        /* applyStateDelta(delta)
+         * Applies every field set in delta and reports the combined geometry
+         * change once. All fields are applied even if one of them fails; the
+         * first error is returned.
+         */
+        int32_t applyStateDelta(const ExynosLayerStateDelta& delta);
+
         /* setLayerPerFrameMetadataBlobs(...,numElements, keys, sizes, blobs)
          * Descriptor: HWC2_FUNCTION_SET_LAYER_PER_FRAME_METADATA_BLOBS
          * Parameters:
@@ -514,6 +542,10 @@ class ExynosLayer : public ExynosMPPSource {
     private:
         ExynosVideoMeta *mMetaParcel;
         int allocMetaParcel();
+
+        /* Set while applyStateDelta() collects geometry bits */
+        bool mDeferGeometryChanged = false;
+        uint64_t mDeferredGeometryChanged = 0;
 };
 
 #endif //_EXYNOSLAYER_H
@@ -23,6 +23,7 @@
 #include <drm.h>
 #include <drm/drm_fourcc.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <xf86drm.h>
 
 #include <algorithm>
@@ -77,6 +78,15 @@ int writeIntToKernelFile(const char* path, const int value) {
     return 0;
 }
 
+static void closeImportJobFds(exynos_win_config_data& config) {
+    for (auto& fd : config.fd_idma) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
 FramebufferManager::~FramebufferManager()
 {
     {
@@ -85,6 +95,18 @@ FramebufferManager::~FramebufferManager()
     }
     mFlipDone.signal();
     mRmFBThread.join();
+
+    {
+        Mutex::Autolock lock(mImportMutex);
+        mImportFBThreadRunning = false;
+    }
+    mImportRequested.signal();
+    if (mImportFBThread.joinable()) {
+        mImportFBThread.join();
+    }
+    for (auto& job : mImportJobs) {
+        closeImportJobFds(job);
+    }
 }
 
 void FramebufferManager::init(int drmFd)
@@ -93,6 +115,9 @@ void FramebufferManager::init(int drmFd)
     mRmFBThreadRunning = true;
     mRmFBThread = std::thread(&FramebufferManager::removeFBsThreadRoutine, this);
     pthread_setname_np(mRmFBThread.native_handle(), "RemoveFBsThread");
+    mImportFBThreadRunning = true;
+    mImportFBThread = std::thread(&FramebufferManager::importFBsThreadRoutine, this);
+    pthread_setname_np(mImportFBThread.native_handle(), "ImportFBsThread");
 }
 
 uint32_t FramebufferManager::getBufHandleFromFd(int fd)
@@ -136,6 +161,11 @@ bool FramebufferManager::validateLayerInfo(uint32_t state, uint32_t drmFormat,
     return true;
 }
 
+FramebufferManager::Framebuffer::~Framebuffer() {
+    drmModeRmFB(drmFd, fbId);
+    ExynosDisplayDrmInterface::sPlaneStateShadow.invalidateFb(fbId);
+}
+
 void FramebufferManager::checkShrink() {
     Mutex::Autolock lock(mMutex);
 
@@ -146,9 +176,27 @@ void FramebufferManager::checkShrink() {
 void FramebufferManager::cleanup(const ExynosLayer *layer) {
     ATRACE_CALL();
 
+    {
+        // drop pending imports of the layer and wait for the one in flight
+        Mutex::Autolock lock(mImportMutex);
+        for (auto it = mImportJobs.begin(); it != mImportJobs.end();) {
+            if (it->layer == layer) {
+                closeImportJobFds(*it);
+                it = mImportJobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        while (mImportingLayer == layer) {
+            mImportDone.wait(mImportMutex);
+        }
+    }
+
     Mutex::Autolock lock(mMutex);
+    mLayerImportStates.erase(layer);
     auto clean = [&](std::map<const ExynosLayer *, FBList> &layerBuffs) {
         if (auto it = layerBuffs.find(layer); it != layerBuffs.end()) {
+            unindexLayerBuffersLocked(layer, it->second);
             mCleanBuffers.splice(mCleanBuffers.end(), std::move(it->second));
             layerBuffs.erase(it);
         }
@@ -174,8 +222,123 @@ void FramebufferManager::removeFBsThreadRoutine()
     }
 }
 
+void FramebufferManager::importFBsThreadRoutine() {
+    while (true) {
+        exynos_win_config_data config;
+        {
+            Mutex::Autolock lock(mImportMutex);
+            if (mImportingLayer != nullptr) {
+                mImportingLayer = nullptr;
+                mImportDone.broadcast();
+            }
+            while (mImportFBThreadRunning && mImportJobs.empty()) {
+                mImportRequested.wait(mImportMutex);
+            }
+            if (!mImportFBThreadRunning) {
+                break;
+            }
+            config = mImportJobs.front();
+            mImportJobs.pop_front();
+            mImportingLayer = config.layer;
+        }
+        ATRACE_NAME("pre-import framebuffer");
+        uint32_t fbId = 0;
+        getBufferInternal(config, fbId, true);
+        closeImportJobFds(config);
+    }
+}
+
+void FramebufferManager::preImportBuffer(const ExynosLayer* layer, buffer_handle_t buffer) {
+    if (layer == nullptr || buffer == nullptr) {
+        return;
+    }
+
+    VendorGraphicBufferMeta gmeta(buffer);
+    if (getDrmMode(gmeta.producer_usage) != NO_DRM) {
+        return;
+    }
+
+    const BufferShape shape{.bufferId = gmeta.unique_id,
+                            .format = gmeta.format,
+                            .stride = gmeta.stride,
+                            .vstride = gmeta.vstride,
+                            .compressionInfo = getCompressionInfo(buffer)};
+    exynos_win_config_data config;
+    {
+        Mutex::Autolock lock(mMutex);
+        auto& state = mLayerImportStates[layer];
+        const BufferShape lastSetBuffer = state.lastSetBuffer;
+        state.lastSetBuffer = shape;
+
+        if (!state.hasTemplate || state.importTemplate.buffer_id != lastSetBuffer.bufferId ||
+            shape.bufferId == lastSetBuffer.bufferId || !shape.isSameShape(lastSetBuffer)) {
+            return;
+        }
+
+        config = state.importTemplate;
+        const Framebuffer::BufferDesc desc{shape.bufferId,
+                                           halFormatToDrmFormat(config.format,
+                                                                config.compressionInfo.type),
+                                           false};
+        if (mCachedBufferIndex.count(CachedBufferKey{layer, desc})) {
+            return;
+        }
+    }
+
+    config.buffer_id = shape.bufferId;
+    config.fd_idma[0] = (gmeta.fd >= 0) ? dup(gmeta.fd) : -1;
+    config.fd_idma[1] = (gmeta.fd1 >= 0) ? dup(gmeta.fd1) : -1;
+    config.fd_idma[2] = (gmeta.fd2 >= 0) ? dup(gmeta.fd2) : -1;
+
+    {
+        Mutex::Autolock lock(mImportMutex);
+        if (!mImportFBThreadRunning) {
+            closeImportJobFds(config);
+            return;
+        }
+        if (mImportJobs.size() >= MAX_PENDING_IMPORT_JOBS) {
+            closeImportJobFds(mImportJobs.front());
+            mImportJobs.pop_front();
+        }
+        mImportJobs.push_back(config);
+    }
+    mImportRequested.signal();
+}
+
+void FramebufferManager::updateImportTemplate(const exynos_win_config_data& config) {
+    if (config.layer == nullptr || config.protection) {
+        return;
+    }
+
+    Mutex::Autolock lock(mMutex);
+    auto it = mLayerImportStates.find(config.layer);
+    if (it == mLayerImportStates.end()) {
+        return;
+    }
+
+    // only a layer buffer committed directly to DPP can be a template, the fbId of an
+    // MPP output buffer has nothing to do with the buffers set to the layer
+    auto& state = it->second;
+    state.hasTemplate = (config.state == config.WIN_STATE_BUFFER) &&
+            (config.buffer_id == state.lastSetBuffer.bufferId);
+    if (state.hasTemplate) {
+        state.importTemplate = config;
+        state.importTemplate.acq_fence = -1;
+        state.importTemplate.rel_fence = -1;
+    }
+}
+
 int32_t FramebufferManager::getBuffer(const exynos_win_config_data &config, uint32_t &fbId) {
     ATRACE_CALL();
+    int32_t ret = getBufferInternal(config, fbId, false);
+    if (ret == NO_ERROR) {
+        updateImportTemplate(config);
+    }
+    return ret;
+}
+
+int32_t FramebufferManager::getBufferInternal(const exynos_win_config_data& config,
+                                              uint32_t& fbId, const bool isPreImport) {
     int ret = NO_ERROR;
     int drmFormat = DRM_FORMAT_UNDEFINED;
     uint32_t bpp = 0;
@@ -189,6 +352,12 @@ int32_t FramebufferManager::getBuffer(const exynos_win_config_data &config, uint
 
     if (config.protection) modifiers[0] |= DRM_FORMAT_MOD_PROTECTION;
 
+    // GEM handles are shared by every import of a dma-buf on mDrmFd and are not
+    // refcounted, so a GEM_CLOSE of one import would invalidate the handle of another.
+    // Importing one buffer at a time also makes a present wait for the pre-import of
+    // the same buffer and find its fbId in the cache.
+    Mutex::Autolock importLock(mBufferImportMutex);
+
     if (config.state == config.WIN_STATE_BUFFER || config.state == config.WIN_STATE_RCD) {
         bufWidth = config.src.f_w;
         bufHeight = config.src.f_h;
@@ -216,10 +385,10 @@ int32_t FramebufferManager::getBuffer(const exynos_win_config_data &config, uint
             return -EINVAL;
         }
 
-        fbId = findCachedFbId(config.layer, isSecureBuffer,
-                              [bufferDesc = Framebuffer::BufferDesc{config.buffer_id, drmFormat,
-                                                                    config.protection}](
-                                      auto& buffer) { return buffer->bufferDesc == bufferDesc; });
+        fbId = findCachedBufferFbId(config.layer,
+                                    Framebuffer::BufferDesc{config.buffer_id, drmFormat,
+                                                            config.protection},
+                                    isPreImport);
         if (fbId != 0) {
             return NO_ERROR;
         }
@@ -305,12 +474,16 @@ int32_t FramebufferManager::getBuffer(const exynos_win_config_data &config, uint
                                                 : mCachedSecureLayerBuffers[config.layer];
         auto maxCachedBufferSize = (!isSecureBuffer) ? MAX_CACHED_BUFFERS_PER_LAYER
                                                      : MAX_CACHED_SECURE_BUFFERS_PER_LAYER;
-        markInuseLayerLocked(config.layer, isSecureBuffer);
+        if (!isPreImport) {
+            markInuseLayerLocked(config.layer, isSecureBuffer);
+        } else {
+            mPreImports++;
+        }
 
-        if (cachedBuffers.size() > maxCachedBufferSize) {
-            ALOGW("FBManager: cached buffers size %zu exceeds limitation(%zu) while adding fbId %d",
-                  cachedBuffers.size(), maxCachedBufferSize, fbId);
-            mCleanBuffers.splice(mCleanBuffers.end(), cachedBuffers);
+        // evict the least recently used fbIds of this layer only
+        while (cachedBuffers.size() >= maxCachedBufferSize) {
+            retireLayerBufferLocked(config.layer, cachedBuffers, std::prev(cachedBuffers.end()));
+            mCacheEvictions++;
         }
 
         if (config.state == config.WIN_STATE_COLOR) {
@@ -318,10 +491,14 @@ int32_t FramebufferManager::getBuffer(const exynos_win_config_data &config, uint
                     new Framebuffer(mDrmFd, fbId,
                                     Framebuffer::SolidColorDesc{bufWidth, bufHeight}));
         } else {
-            cachedBuffers.emplace_front(
-                    new Framebuffer(mDrmFd, fbId,
-                                    Framebuffer::BufferDesc{config.buffer_id, drmFormat,
-                                                            config.protection}));
+            const Framebuffer::BufferDesc desc{config.buffer_id, drmFormat, config.protection};
+            const CachedBufferKey key{config.layer, desc};
+            if (auto it = mCachedBufferIndex.find(key); it != mCachedBufferIndex.end()) {
+                // the index keeps a single fbId per buffer
+                retireLayerBufferLocked(config.layer, cachedBuffers, it->second);
+            }
+            cachedBuffers.emplace_front(new Framebuffer(mDrmFd, fbId, desc));
+            mCachedBufferIndex[key] = cachedBuffers.begin();
         }
     } else {
         ALOGW("FBManager: possible leakage fbId %d was created", fbId);
@@ -350,11 +527,69 @@ void FramebufferManager::flip(const bool hasSecureBuffer) {
 void FramebufferManager::releaseAll()
 {
     Mutex::Autolock lock(mMutex);
+    mCachedBufferIndex.clear();
     mCachedLayerBuffers.clear();
     mCachedSecureLayerBuffers.clear();
     mCleanBuffers.clear();
 }
 
+void FramebufferManager::dump(String8& result) {
+    Mutex::Autolock lock(mMutex);
+    size_t cachedBuffers = 0;
+    for (const auto& [layer, bufferList] : mCachedLayerBuffers) cachedBuffers += bufferList.size();
+    size_t cachedSecureBuffers = 0;
+    for (const auto& [layer, bufferList] : mCachedSecureLayerBuffers)
+        cachedSecureBuffers += bufferList.size();
+
+    result.appendFormat("FramebufferManager: layers(%zu), buffers(%zu), secure layers(%zu), "
+                        "secure buffers(%zu), pending clean(%zu)\n",
+                        mCachedLayerBuffers.size(), cachedBuffers, mCachedSecureLayerBuffers.size(),
+                        cachedSecureBuffers, mCleanBuffers.size());
+    result.appendFormat("\tfbId cache hit(%" PRIu64 "), miss(%" PRIu64 "), eviction(%" PRIu64
+                        "), pre-import(%" PRIu64 ")\n",
+                        mCacheHits, mCacheMisses, mCacheEvictions, mPreImports);
+}
+
+uint32_t FramebufferManager::findCachedBufferFbId(const ExynosLayer* layer,
+                                                  const Framebuffer::BufferDesc& desc,
+                                                  const bool isPreImport) {
+    Mutex::Autolock lock(mMutex);
+    const auto it = mCachedBufferIndex.find(CachedBufferKey{layer, desc});
+    if (isPreImport) {
+        return (it != mCachedBufferIndex.end()) ? (*it->second)->fbId : 0;
+    }
+
+    markInuseLayerLocked(layer, desc.isSecure);
+    if (it == mCachedBufferIndex.end()) {
+        mCacheMisses++;
+        return 0;
+    }
+
+    // move the hit entry to the front of its layer list to keep LRU order
+    auto& cachedBuffers =
+            (!desc.isSecure) ? mCachedLayerBuffers[layer] : mCachedSecureLayerBuffers[layer];
+    cachedBuffers.splice(cachedBuffers.begin(), cachedBuffers, it->second);
+    mCacheHits++;
+    return (*it->second)->fbId;
+}
+
+void FramebufferManager::unindexLayerBuffersLocked(const ExynosLayer* layer,
+                                                   const FBList& buffers) {
+    for (const auto& buffer : buffers) {
+        if (!buffer->isSolidColor) {
+            mCachedBufferIndex.erase(CachedBufferKey{layer, buffer->bufferDesc});
+        }
+    }
+}
+
+void FramebufferManager::retireLayerBufferLocked(const ExynosLayer* layer, FBList& buffers,
+                                                 FBList::iterator it) {
+    if (!(*it)->isSolidColor) {
+        mCachedBufferIndex.erase(CachedBufferKey{layer, (*it)->bufferDesc});
+    }
+    mCleanBuffers.splice(mCleanBuffers.end(), buffers, it);
+}
+
 void FramebufferManager::freeBufHandle(uint32_t handle) {
     if (handle == 0) {
         return;
@@ -390,6 +625,7 @@ void FramebufferManager::destroyUnusedLayersLocked() {
 
         for (auto layer = cachedLayerBuffers.begin(); layer != cachedLayerBuffers.end();) {
             if (cachedLayersInuse.find(layer->first) == cachedLayersInuse.end()) {
+                unindexLayerBuffersLocked(layer->first, layer->second);
                 mCleanBuffers.splice(mCleanBuffers.end(), std::move(layer->second));
                 layer = cachedLayerBuffers.erase(layer);
             } else {
@@ -417,6 +653,7 @@ void FramebufferManager::destroyUnusedLayersLocked() {
 void FramebufferManager::destroyAllSecureBuffersLocked() {
     for (auto& [layer, bufferList] : mCachedSecureLayerBuffers) {
         if (bufferList.size()) {
+            unindexLayerBuffersLocked(layer, bufferList);
             mCleanBuffers.splice(mCleanBuffers.end(), bufferList, bufferList.begin(),
                                  bufferList.end());
         }
@@ -438,10 +675,11 @@ void FramebufferManager::destroyAllSecureBuffers() {
 
 int32_t FramebufferManager::uncacheLayerBuffers(const ExynosLayer* layer,
                                                 const std::vector<buffer_handle_t>& buffers) {
-    std::set<Framebuffer::BufferDesc> removedBufferDescs;
+    std::vector<Framebuffer::BufferDesc> removedBufferDescs;
+    removedBufferDescs.reserve(buffers.size());
     for (auto buffer : buffers) {
         VendorGraphicBufferMeta gmeta(buffer);
-        removedBufferDescs.insert(
+        removedBufferDescs.push_back(
                 Framebuffer::BufferDesc{.bufferId = gmeta.unique_id,
                                         .drmFormat =
                                                 halFormatToDrmFormat(gmeta.format,
@@ -452,22 +690,19 @@ int32_t FramebufferManager::uncacheLayerBuffers(const ExynosLayer* layer,
     bool needCleanup = false;
     {
         Mutex::Autolock lock(mMutex);
-        auto destroyCachedBuffersLocked =
-                [&](std::map<const ExynosLayer*, FBList>& cachedLayerBuffers) REQUIRES(mMutex) {
-                    if (auto layerIter = cachedLayerBuffers.find(layer);
-                        layerIter != cachedLayerBuffers.end()) {
-                        auto& fbList = layerIter->second;
-                        for (auto it = fbList.begin(); it != fbList.end();) {
-                            auto bufferIter = it++;
-                            if (removedBufferDescs.count((*bufferIter)->bufferDesc)) {
-                                mCleanBuffers.splice(mCleanBuffers.end(), fbList, bufferIter);
-                                needCleanup = true;
-                            }
-                        }
-                    }
-                };
-        destroyCachedBuffersLocked(mCachedLayerBuffers);
-        destroyCachedBuffersLocked(mCachedSecureLayerBuffers);
+        for (const auto& desc : removedBufferDescs) {
+            const auto indexIter = mCachedBufferIndex.find(CachedBufferKey{layer, desc});
+            if (indexIter == mCachedBufferIndex.end()) {
+                continue;
+            }
+            auto& cachedLayerBuffers =
+                    (!desc.isSecure) ? mCachedLayerBuffers : mCachedSecureLayerBuffers;
+            if (auto layerIter = cachedLayerBuffers.find(layer);
+                layerIter != cachedLayerBuffers.end()) {
+                retireLayerBufferLocked(layer, layerIter->second, indexIter->second);
+                needCleanup = true;
+            }
+        }
     }
     if (needCleanup) {
         mFlipDone.signal();
@@ -484,6 +719,24 @@ void ExynosDisplayDrmInterface::destroyLayer(ExynosLayer *layer) {
     mFBManager.cleanup(layer);
 }
 
+void ExynosDisplayDrmInterface::preImportLayerBuffer(const ExynosLayer* layer,
+                                                     buffer_handle_t buffer) {
+    mFBManager.preImportBuffer(layer, buffer);
+}
+
+void ExynosDisplayDrmInterface::dump(String8& result) {
+    mFBManager.dump(result);
+
+    const uint64_t commits = mAtomicCommitStats.commits;
+    const uint64_t properties = mAtomicCommitStats.properties;
+    const uint64_t skippedProperties = mAtomicCommitStats.skippedProperties;
+    result.appendFormat("Atomic commits(%" PRIu64 "), properties per commit(%.1f), "
+                        "skipped per commit(%.1f), skip committed plane props(%d)\n",
+                        commits, commits ? static_cast<double>(properties) / commits : 0,
+                        commits ? static_cast<double>(skippedProperties) / commits : 0,
+                        sPlaneStateShadow.isEnabled());
+}
+
 int32_t ExynosDisplayDrmInterface::getDisplayIdleTimerSupport(bool &outSupport) {
     if (isVrrSupported()) {
         outSupport = false;
@@ -728,6 +981,8 @@ int32_t ExynosDisplayDrmInterface::initDrmDevice(DrmDevice *drmDevice)
     }
 
     mFBManager.init(mDrmDevice->fd());
+    sPlaneStateShadow.init(mDrmDevice);
+    buildPropertyInfos();
 
     int drmDisplayId = getDrmDisplayId(mExynosDisplay->mType, mExynosDisplay->mIndex);
     if (drmDisplayId < 0) {
@@ -795,6 +1050,16 @@ int32_t ExynosDisplayDrmInterface::initDrmDevice(DrmDevice *drmDevice)
 
     getLowPowerDrmModeModeInfo();
 
+    /*
+     * The partial_region blob carries a single rect unless the DPU and the
+     * panel are configured to update several regions in a frame.
+     */
+    mMaxPartialRegions = 1;
+    if (mDrmCrtc->partial_region_property().id()) {
+        int32_t maxRegions = property_get_int32("vendor.display.max_partial_regions", 1);
+        mMaxPartialRegions = std::clamp(maxRegions, 1, 8);
+    }
+
     mDrmVSyncWorker.Init(mDrmDevice, drmDisplayId, mDisplayTraceName);
     mDrmVSyncWorker.RegisterCallback(std::shared_ptr<VsyncCallback>(this));
 
@@ -965,6 +1230,9 @@ int32_t ExynosDisplayDrmInterface::setPowerMode(int32_t mode)
 {
     int ret = 0;
     uint64_t dpms_value = 0;
+
+    /* planes can be reset by the kernel across power mode changes */
+    sPlaneStateShadow.invalidate();
     if (mode == HWC_POWER_MODE_OFF) {
         dpms_value = DRM_MODE_DPMS_OFF;
     } else {
@@ -1864,38 +2132,43 @@ int32_t ExynosDisplayDrmInterface::setupPartialRegion(DrmModeAtomicReq &drmReq)
 
     int ret = NO_ERROR;
 
-    struct decon_frame &update_region = mExynosDisplay->mDpuData.win_update_region;
-    struct drm_clip_rect partial_rect = {
-        static_cast<unsigned short>(update_region.x),
-        static_cast<unsigned short>(update_region.y),
-        static_cast<unsigned short>(update_region.x + update_region.w),
-        static_cast<unsigned short>(update_region.y + update_region.h),
+    std::vector<drm_clip_rect> partial_rects;
+    auto addPartialRect = [&partial_rects](const struct decon_frame &region) {
+        partial_rects.push_back({
+            static_cast<unsigned short>(region.x),
+            static_cast<unsigned short>(region.y),
+            static_cast<unsigned short>(region.x + region.w),
+            static_cast<unsigned short>(region.y + region.h),
+        });
     };
+
+    const std::vector<decon_frame> &update_regions = mExynosDisplay->mDpuData.win_update_regions;
+    if ((update_regions.size() > 1) && (update_regions.size() <= mMaxPartialRegions)) {
+        for (auto &region : update_regions) addPartialRect(region);
+    } else {
+        addPartialRect(mExynosDisplay->mDpuData.win_update_region);
+    }
+
     if ((mPartialRegionState.blob_id == 0) ||
-         mPartialRegionState.isUpdated(partial_rect))
+         mPartialRegionState.isUpdated(partial_rects))
     {
         uint32_t blob_id = 0;
-        ret = mDrmDevice->CreatePropertyBlob(&partial_rect,
-                sizeof(partial_rect),&blob_id);
+        ret = mDrmDevice->CreatePropertyBlob(partial_rects.data(),
+                sizeof(drm_clip_rect) * partial_rects.size(), &blob_id);
         if (ret || (blob_id == 0)) {
             HWC_LOGE(mExynosDisplay, "Failed to create partial region "
                     "blob id=%d, ret=%d", blob_id, ret);
             return ret;
         }
 
-        HDEBUGLOGD(eDebugWindowUpdate,
-                "%s: partial region updated [%d, %d, %d, %d] -> [%d, %d, %d, %d] blob(%d)",
-                mExynosDisplay->mDisplayName.c_str(),
-                mPartialRegionState.partial_rect.x1,
-                mPartialRegionState.partial_rect.y1,
-                mPartialRegionState.partial_rect.x2,
-                mPartialRegionState.partial_rect.y2,
-                partial_rect.x1,
-                partial_rect.y1,
-                partial_rect.x2,
-                partial_rect.y2,
-                blob_id);
-        mPartialRegionState.partial_rect = partial_rect;
+        for (auto &rect : partial_rects) {
+            HDEBUGLOGD(eDebugWindowUpdate,
+                    "%s: partial region updated [%d, %d, %d, %d] (%zu regions) blob(%d)",
+                    mExynosDisplay->mDisplayName.c_str(),
+                    rect.x1, rect.y1, rect.x2, rect.y2,
+                    partial_rects.size(), blob_id);
+        }
+        mPartialRegionState.partial_rects = std::move(partial_rects);
 
         if (mPartialRegionState.blob_id)
             drmReq.addOldBlob(mPartialRegionState.blob_id);
@@ -2416,6 +2689,99 @@ int32_t ExynosDisplayDrmInterface::setForcePanic()
     return 0;
 }
 
+DrmPlaneStateShadow ExynosDisplayDrmInterface::sPlaneStateShadow;
+
+void ExynosDisplayDrmInterface::buildPropertyInfos() {
+    mPropertyInfos.clear();
+    auto addProperties = [&](uint32_t objectId, const std::vector<DrmProperty*>& properties,
+                             const String8& objectName) {
+        for (auto property : properties) {
+            mPropertyInfos[drmPropertyKey(objectId, property->id())] = {property, objectName};
+        }
+    };
+
+    for (auto& crtc : mDrmDevice->crtcs()) {
+        addProperties(crtc->id(), crtc->properties(), String8("Crtc"));
+    }
+    for (auto& connector : mDrmDevice->connectors()) {
+        addProperties(connector->id(), connector->properties(), String8("Connector"));
+    }
+    uint32_t channelId = 0;
+    for (auto& plane : mDrmDevice->planes()) {
+        addProperties(plane->id(), plane->properties(), String8::format("Plane[%d]", channelId));
+        channelId++;
+    }
+}
+
+void DrmPlaneStateShadow::init(DrmDevice* drmDevice) {
+    Mutex::Autolock lock(mMutex);
+    if (!mPlaneIds.empty()) {
+        return;
+    }
+
+    mEnabled = property_get_bool("vendor.display.skip_committed_plane_props", true);
+    for (auto& plane : drmDevice->planes()) {
+        mPlaneIds.insert(plane->id());
+        if (plane->in_fence_fd_property().id()) {
+            mVolatilePropertyIds.insert(plane->in_fence_fd_property().id());
+        }
+        if (plane->fb_property().id()) {
+            mFbPropertyIds[plane->id()] = plane->fb_property().id();
+        }
+    }
+}
+
+bool DrmPlaneStateShadow::isCommitted(const uint32_t objectId, const DrmProperty& property,
+                                      const uint64_t value) {
+    Mutex::Autolock lock(mMutex);
+    if (!mEnabled || !mPlaneIds.count(objectId) || mVolatilePropertyIds.count(property.id())) {
+        return false;
+    }
+
+    const auto it = mCommittedValues.find(drmPropertyKey(objectId, property.id()));
+    return (it != mCommittedValues.end()) && (it->second == value);
+}
+
+void DrmPlaneStateShadow::update(const drmModeAtomicReqPtr pset) {
+    Mutex::Autolock lock(mMutex);
+    if (!mEnabled) {
+        return;
+    }
+
+    for (int i = 0; i < drmModeAtomicGetCursor(pset); i++) {
+        const auto& item = pset->items[i];
+        if (mPlaneIds.count(item.object_id) && !mVolatilePropertyIds.count(item.property_id)) {
+            mCommittedValues[drmPropertyKey(item.object_id, item.property_id)] = item.value;
+        }
+    }
+}
+
+void DrmPlaneStateShadow::invalidate() {
+    Mutex::Autolock lock(mMutex);
+    mCommittedValues.clear();
+}
+
+void DrmPlaneStateShadow::invalidateFb(const uint32_t fbId) {
+    Mutex::Autolock lock(mMutex);
+    if (!mEnabled) {
+        return;
+    }
+
+    for (const auto& [planeId, fbPropertyId] : mFbPropertyIds) {
+        const auto it = mCommittedValues.find(drmPropertyKey(planeId, fbPropertyId));
+        if ((it == mCommittedValues.end()) || (it->second != fbId)) {
+            continue;
+        }
+        for (auto value = mCommittedValues.begin(); value != mCommittedValues.end();) {
+            if ((value->first >> 32) == planeId) {
+                value = mCommittedValues.erase(value);
+            } else {
+                ++value;
+            }
+        }
+    }
+}
+
 ExynosDisplayDrmInterface::DrmModeAtomicReq::DrmModeAtomicReq(ExynosDisplayDrmInterface *displayInterface)
     : mDrmDisplayInterface(displayInterface)
 {
@@ -2452,6 +2818,13 @@ int32_t ExynosDisplayDrmInterface::DrmModeAtomicReq::atomicAddProperty(
     }
 
     if (property.id() && property.validateChange(value)) {
+        if (sPlaneStateShadow.isEnabled() &&
+            mAddedProperties.insert(drmPropertyKey(id, property.id())).second &&
+            sPlaneStateShadow.isCommitted(id, property, value)) {
+            mSkippedProperties++;
+            return NO_ERROR;
+        }
+
         int ret = drmModeAtomicAddProperty(mPset, id,
                 property.id(), value);
         if (ret < 0) {
@@ -2475,55 +2848,15 @@ String8& ExynosDisplayDrmInterface::DrmModeAtomicReq::dumpAtomicCommitInfo(
     if (debugPrint)
         ALOGD("%s atomic config ++++++++++++", mDrmDisplayInterface->mExynosDisplay->mDisplayName.c_str());
 
+    const auto& propertyInfos = mDrmDisplayInterface->mPropertyInfos;
     for (int i = 0; i < drmModeAtomicGetCursor(mPset); i++) {
         const DrmProperty *property = NULL;
         String8 objectName;
-        /* Check crtc properties */
-        if (mPset->items[i].object_id == mDrmDisplayInterface->mDrmCrtc->id()) {
-            for (auto property_ptr : mDrmDisplayInterface->mDrmCrtc->properties()) {
-                if (mPset->items[i].property_id == property_ptr->id()){
-                    property = property_ptr;
-                    objectName.appendFormat("Crtc");
-                    break;
-                }
-            }
-            if (property == NULL) {
-                HWC_LOGE(mDrmDisplayInterface->mExynosDisplay,
-                        "%s:: object id is crtc but there is no matched property",
-                        __func__);
-            }
-        } else if (mPset->items[i].object_id == mDrmDisplayInterface->mDrmConnector->id()) {
-            for (auto property_ptr : mDrmDisplayInterface->mDrmConnector->properties()) {
-                if (mPset->items[i].property_id == property_ptr->id()){
-                    property = property_ptr;
-                    objectName.appendFormat("Connector");
-                    break;
-                }
-            }
-            if (property == NULL) {
-                HWC_LOGE(mDrmDisplayInterface->mExynosDisplay,
-                        "%s:: object id is connector but there is no matched property",
-                        __func__);
-            }
-        } else {
-            uint32_t channelId = 0;
-            for (auto &plane : mDrmDisplayInterface->mDrmDevice->planes()) {
-                if (mPset->items[i].object_id == plane->id()) {
-                    for (auto property_ptr : plane->properties()) {
-                        if (mPset->items[i].property_id == property_ptr->id()){
-                            property = property_ptr;
-                            objectName.appendFormat("Plane[%d]", channelId);
-                            break;
-                        }
-                    }
-                    if (property == NULL) {
-                        HWC_LOGE(mDrmDisplayInterface->mExynosDisplay,
-                                "%s:: object id is plane but there is no matched property",
-                                __func__);
-                    }
-                }
-                channelId++;
-            }
+        if (const auto it = propertyInfos.find(
+                    drmPropertyKey(mPset->items[i].object_id, mPset->items[i].property_id));
+            it != propertyInfos.end()) {
+            property = it->second.property;
+            objectName = it->second.objectName;
         }
         if (property == NULL) {
             HWC_LOGE(mDrmDisplayInterface->mExynosDisplay,
@@ -2558,6 +2891,7 @@ int ExynosDisplayDrmInterface::DrmModeAtomicReq::commit(uint32_t flags, bool log
         dumpAtomicCommitInfo(result, true);
     if ((ret == -EPERM) && mDrmDisplayInterface->mDrmDevice->event_listener()->IsDrmInTUI()) {
         ALOGV("skip atomic commit error handling as kernel is in TUI");
+        sPlaneStateShadow.invalidate();
         ret = NO_ERROR;
     } else if (ret < 0) {
         if (ret == -EINVAL) {
@@ -2565,6 +2899,13 @@ int ExynosDisplayDrmInterface::DrmModeAtomicReq::commit(uint32_t flags, bool log
         }
         HWC_LOGE(mDrmDisplayInterface->mExynosDisplay, "commit error: %d", ret);
         setError(ret);
+        sPlaneStateShadow.invalidate();
+    } else if (!(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
+        sPlaneStateShadow.update(mPset);
+        auto& stats = mDrmDisplayInterface->mAtomicCommitStats;
+        stats.commits.fetch_add(1, std::memory_order_relaxed);
+        stats.properties.fetch_add(drmModeAtomicGetCursor(mPset), std::memory_order_relaxed);
+        stats.skippedProperties.fetch_add(mSkippedProperties, std::memory_order_relaxed);
     }
 
     if (ret == 0 && mAckCallback) {
@@ -24,6 +24,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "ExynosDisplay.h"
 #include "ExynosDisplayInterface.h"
@@ -85,6 +86,12 @@ class FramebufferManager {
         // layer. Those fbIds will be cleaned up once the layer was destroyed.
         int32_t getBuffer(const exynos_win_config_data &config, uint32_t &fbId);
 
+        // Queue a background import of a buffer that was just set to the layer, so that
+        // getBuffer() finds its fbId already cached at present time. The import is only
+        // attempted when the buffer has the same shape as the layer buffer that was last
+        // committed directly to DPP, whose config is reused for the new buffer.
+        void preImportBuffer(const ExynosLayer* layer, buffer_handle_t buffer);
+
         void checkShrink();
 
         void cleanup(const ExynosLayer *layer);
@@ -102,6 +109,8 @@ class FramebufferManager {
         // off
         void releaseAll();
 
+        void dump(String8& result);
+
     private:
         // this struct should contain elements that can be used to identify framebuffer more easily
         struct Framebuffer {
@@ -132,12 +141,13 @@ class FramebufferManager {
             };
 
             explicit Framebuffer(int fd, uint32_t fb, BufferDesc desc)
-                  : drmFd(fd), fbId(fb), bufferDesc(desc){};
+                  : drmFd(fd), fbId(fb), isSolidColor(false), bufferDesc(desc){};
             explicit Framebuffer(int fd, uint32_t fb, SolidColorDesc desc)
-                  : drmFd(fd), fbId(fb), colorDesc(desc){};
-            ~Framebuffer() { drmModeRmFB(drmFd, fbId); };
+                  : drmFd(fd), fbId(fb), isSolidColor(true), colorDesc(desc){};
+            ~Framebuffer();
             int drmFd;
             uint32_t fbId;
+            const bool isSolidColor;
             union {
                 BufferDesc bufferDesc;
                 SolidColorDesc colorDesc;
@@ -145,9 +155,31 @@ class FramebufferManager {
         };
         using FBList = std::list<std::unique_ptr<Framebuffer>>;
 
+        // Key of mCachedBufferIndex. Solid color framebuffers are few per layer and
+        // are not indexed, they are still found by walking the layer's FBList.
+        struct CachedBufferKey {
+            const ExynosLayer* layer;
+            Framebuffer::BufferDesc desc;
+            bool operator==(const CachedBufferKey& rhs) const {
+                return layer == rhs.layer && desc == rhs.desc;
+            }
+        };
+        struct CachedBufferKeyHash {
+            size_t operator()(const CachedBufferKey& key) const {
+                size_t hash = std::hash<const ExynosLayer*>{}(key.layer);
+                hash = hash * 31 + std::hash<uint64_t>{}(key.desc.bufferId);
+                hash = hash * 31 + static_cast<size_t>(key.desc.drmFormat);
+                return hash * 2 + key.desc.isSecure;
+            }
+        };
+
         template <class UnaryPredicate>
         uint32_t findCachedFbId(const ExynosLayer* layer, const bool isSecureBuffer,
                                 UnaryPredicate predicate);
+        uint32_t findCachedBufferFbId(const ExynosLayer* layer,
+                                      const Framebuffer::BufferDesc& desc, const bool isPreImport);
+        int32_t getBufferInternal(const exynos_win_config_data& config, uint32_t& fbId,
+                                  const bool isPreImport);
         int addFB2WithModifiers(uint32_t state, uint32_t width, uint32_t height, uint32_t drmFormat,
                                 const DrmArray<uint32_t> &handles,
                                 const DrmArray<uint32_t> &pitches,
@@ -160,11 +192,17 @@ class FramebufferManager {
         uint32_t getBufHandleFromFd(int fd);
         void freeBufHandle(uint32_t handle);
         void removeFBsThreadRoutine();
+        void importFBsThreadRoutine();
+        void updateImportTemplate(const exynos_win_config_data& config);
 
         void markInuseLayerLocked(const ExynosLayer* layer, const bool isSecureBuffer)
                 REQUIRES(mMutex);
         void destroyUnusedLayersLocked() REQUIRES(mMutex);
         void destroyAllSecureBuffersLocked() REQUIRES(mMutex);
+        void unindexLayerBuffersLocked(const ExynosLayer* layer, const FBList& buffers)
+                REQUIRES(mMutex);
+        void retireLayerBufferLocked(const ExynosLayer* layer, FBList& buffers,
+                                     FBList::iterator it) REQUIRES(mMutex);
 
         int mDrmFd = -1;
 
@@ -178,6 +216,50 @@ class FramebufferManager {
         // be destroyed in mRmFBThread thread.
         FBList mCleanBuffers;
 
+        // Shape of a layer buffer, pre-import is only done between buffers of the same shape
+        struct BufferShape {
+            uint64_t bufferId = 0;
+            int format = 0;
+            int stride = 0;
+            int vstride = 0;
+            CompressionInfo compressionInfo;
+            bool isSameShape(const BufferShape& rhs) const {
+                return format == rhs.format && stride == rhs.stride && vstride == rhs.vstride &&
+                        compressionInfo.type == rhs.compressionInfo.type &&
+                        compressionInfo.modifier == rhs.compressionInfo.modifier;
+            }
+        };
+        // importTemplate is the config of the last layer buffer committed directly to DPP,
+        // lastSetBuffer is the shape of the last buffer set to the layer.
+        struct LayerImportState {
+            bool hasTemplate = false;
+            exynos_win_config_data importTemplate;
+            BufferShape lastSetBuffer;
+        };
+        std::unordered_map<const ExynosLayer*, LayerImportState> mLayerImportStates;
+        // The fds of an import job are duplicated as the buffer handle can be freed
+        // before the job is handled.
+        std::list<exynos_win_config_data> mImportJobs;
+        const ExynosLayer* mImportingLayer = nullptr;
+        std::thread mImportFBThread;
+        bool mImportFBThreadRunning = false;
+        Condition mImportRequested;
+        Condition mImportDone;
+        Mutex mImportMutex;
+        // Serializes the GEM handle import, AddFB2 and GEM_CLOSE of getBufferInternal
+        Mutex mBufferImportMutex;
+        uint64_t mPreImports = 0;
+
+        // mCachedBufferIndex maps (layer, BufferDesc) to its entry in the layer's
+        // FBList so that a cached fbId is found in constant time. Each FBList is
+        // kept in LRU order (most recently used at the front), so the back entry
+        // is the one evicted once the per-layer limit is reached.
+        std::unordered_map<CachedBufferKey, FBList::iterator, CachedBufferKeyHash>
+                mCachedBufferIndex;
+        uint64_t mCacheHits = 0;
+        uint64_t mCacheMisses = 0;
+        uint64_t mCacheEvictions = 0;
+
         // mCacheShrinkPending is set when we want to clean up unused layers
         // in mCachedLayerBuffers. When the flag is set, mCachedLayersInuse will
         // keep in-use layers in this frame update. Those unused layers will be
@@ -198,6 +280,7 @@ class FramebufferManager {
         static constexpr size_t MAX_CACHED_SECURE_LAYERS = 1;
         static constexpr size_t MAX_CACHED_BUFFERS_PER_LAYER = 32;
         static constexpr size_t MAX_CACHED_SECURE_BUFFERS_PER_LAYER = 3;
+        static constexpr size_t MAX_PENDING_IMPORT_JOBS = 4;
 };
 
 template <class UnaryPredicate>
@@ -211,6 +294,37 @@ uint32_t FramebufferManager::findCachedFbId(const ExynosLayer* layer, const bool
     return (it != cachedBuffers.end()) ? (*it)->fbId : 0;
 }
 
+inline uint64_t drmPropertyKey(const uint32_t objectId, const uint32_t propertyId) {
+    return (static_cast<uint64_t>(objectId) << 32) | propertyId;
+}
+
+// DrmPlaneStateShadow keeps the last committed value of each plane property so that
+// unchanged plane properties can be left out of atomic requests. It is shared by all
+// displays because a plane can move between CRTCs. IN_FENCE_FD is always added as an
+// fd number can be reused for a different fence.
+class DrmPlaneStateShadow {
+    public:
+        void init(DrmDevice* drmDevice);
+        bool isEnabled() const { return mEnabled; }
+        // returns true if the value was already committed and can be skipped
+        bool isCommitted(const uint32_t objectId, const DrmProperty& property,
+                         const uint64_t value);
+        void update(const drmModeAtomicReqPtr pset);
+        // should be called whenever the kernel plane state can differ from the shadow
+        void invalidate();
+        // the kernel disables the planes showing @fbId when it is removed
+        void invalidateFb(const uint32_t fbId);
+
+    private:
+        bool mEnabled = false;
+        Mutex mMutex;
+        std::unordered_set<uint32_t> mPlaneIds;
+        std::unordered_set<uint32_t> mVolatilePropertyIds;
+        // plane id to its FB_ID property id
+        std::unordered_map<uint32_t, uint32_t> mFbPropertyIds;
+        std::unordered_map<uint64_t, uint64_t> mCommittedValues;
+};
+
 class ExynosDisplayDrmInterface :
     public ExynosDisplayInterface,
     public VsyncCallback
@@ -271,6 +385,11 @@ class ExynosDisplayDrmInterface :
                 drmModeAtomicReqPtr mPset;
                 drmModeAtomicReqPtr mSavedPset;
                 int mError = 0;
+                /* Number of properties left out as they were already committed */
+                uint32_t mSkippedProperties = 0;
+                /* Properties added to this request, a property that is set again must not be
+                 * skipped even if the new value is the committed one */
+                std::unordered_set<uint64_t> mAddedProperties;
                 ExynosDisplayDrmInterface *mDrmDisplayInterface = NULL;
                 /* Destroy old blobs after commit */
                 std::vector<uint32_t> mOldBlobs;
@@ -337,6 +456,7 @@ class ExynosDisplayDrmInterface :
         virtual int32_t initDrmDevice(DrmDevice *drmDevice);
         virtual int getDrmDisplayId(uint32_t type, uint32_t index);
         virtual uint32_t getMaxWindowNum() { return mMaxWindowNum; };
+        virtual uint32_t getMaxPartialRegions() { return mMaxPartialRegions; };
         virtual int32_t getReadbackBufferAttributes(int32_t* /*android_pixel_format_t*/ outFormat,
                 int32_t* /*android_dataspace_t*/ outDataspace);
         virtual int32_t getDisplayIdentificationData(uint8_t* outPort,
@@ -363,6 +483,9 @@ class ExynosDisplayDrmInterface :
                 uint32_t &solidColor)
         { return NO_ERROR;};
         virtual void destroyLayer(ExynosLayer *layer) override;
+        virtual void preImportLayerBuffer(const ExynosLayer* layer,
+                                          buffer_handle_t buffer) override;
+        virtual void dump(String8& result) override;
 
         /* For HWC 3.0 APIs */
         virtual int32_t getDisplayIdleTimerSupport(bool &outSupport);
@@ -536,13 +659,18 @@ class ExynosDisplayDrmInterface :
 
     protected:
         struct PartialRegionState {
-            struct drm_clip_rect partial_rect = {0, 0, 0, 0};
+            std::vector<drm_clip_rect> partial_rects;
             uint32_t blob_id = 0;
-            bool isUpdated(drm_clip_rect rect) {
-                return ((partial_rect.x1 != rect.x1) ||
-                        (partial_rect.y1 != rect.y1) ||
-                        (partial_rect.x2 != rect.x2) ||
-                        (partial_rect.y2 != rect.y2));
+            bool isUpdated(const std::vector<drm_clip_rect> &rects) {
+                if (partial_rects.size() != rects.size()) return true;
+                for (size_t i = 0; i < rects.size(); i++) {
+                    if ((partial_rects[i].x1 != rects[i].x1) ||
+                        (partial_rects[i].y1 != rects[i].y1) ||
+                        (partial_rects[i].x2 != rects[i].x2) ||
+                        (partial_rects[i].y2 != rects[i].y2))
+                        return true;
+                }
+                return false;
             };
         };
 
@@ -614,12 +742,33 @@ class ExynosDisplayDrmInterface :
         nsecs_t mLastDumpDrmAtomicMessageTime;
         bool mIsResolutionSwitchInProgress = false;
 
+        // FramebufferManager invalidates the planes of the removed framebuffers
+        friend class FramebufferManager;
+        static DrmPlaneStateShadow sPlaneStateShadow;
+
+        // (object id, property id) of all CRTCs, connectors and planes to the property and
+        // its object name, used to dump atomic requests
+        struct DrmPropertyInfo {
+            const DrmProperty* property;
+            String8 objectName;
+        };
+        std::unordered_map<uint64_t, DrmPropertyInfo> mPropertyInfos;
+        void buildPropertyInfos();
+        // updated by the commit thread and read by dump
+        struct AtomicCommitStats {
+            std::atomic<uint64_t> commits{0};
+            std::atomic<uint64_t> properties{0};
+            std::atomic<uint64_t> skippedProperties{0};
+        } mAtomicCommitStats;
+
     private:
         int32_t getDisplayFakeEdid(uint8_t &outPort, uint32_t &outDataSize, uint8_t *outData);
 
         String8 mDisplayTraceName;
         DrmMode mDozeDrmMode;
         uint32_t mMaxWindowNum = 0;
+        /* Number of rects that the partial_region blob can carry */
+        uint32_t mMaxPartialRegions = 1;
         int32_t mFrameCounter = 0;
         int32_t mPanelFullResolutionHSize = 0;
         int32_t mPanelFullResolutionVSize = 0;
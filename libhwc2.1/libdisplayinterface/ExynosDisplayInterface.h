@@ -64,6 +64,7 @@ class ExynosDisplayInterface {
         virtual int32_t setForcePanic() {return NO_ERROR;};
         virtual int getDisplayFd() {return -1;};
         virtual uint32_t getMaxWindowNum() {return 0;};
+        virtual uint32_t getMaxPartialRegions() {return 1;};
         virtual int32_t setColorTransform(const float* __unused matrix,
                 int32_t __unused hint) {return HWC2_ERROR_UNSUPPORTED;}
         virtual int32_t getRenderIntents(int32_t __unused mode, uint32_t* __unused outNumIntents,
@@ -110,6 +111,11 @@ class ExynosDisplayInterface {
             return NO_ERROR;
         }
 
+        virtual void preImportLayerBuffer(const ExynosLayer* __unused layer,
+                                          buffer_handle_t __unused buffer) {}
+
+        virtual void dump(String8& __unused result) {}
+
     public:
         uint32_t mType = INTERFACE_TYPE_NONE;
 };
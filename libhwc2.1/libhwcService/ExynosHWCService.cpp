@@ -564,8 +564,9 @@ int32_t ExynosHWCService::dumpBuffers(uint32_t displayId, int32_t count) {
     if (display == nullptr) return -EINVAL;
 
     ALOGD("ExynosHWCService::%s() displayID(%u) count(%u)", __func__, displayId, count);
+    // presentDisplay restarts the numbering when it sees the new session
     display->mBufferDumpCount = count;
-    display->mBufferDumpNum = 0;
+    display->mBufferDumpSession++;
     return NO_ERROR;
 }
 
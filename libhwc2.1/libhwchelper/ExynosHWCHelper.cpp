@@ -24,6 +24,7 @@
 #include <sys/mman.h>
 #include <utils/CallStack.h>
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 
 #include <iomanip>
 
@@ -132,12 +133,34 @@ unsigned int isNarrowRgb(int format, android_dataspace data_space)
     }
 }
 
+/*
+ * exynos_format_desc[] indices grouped by HAL format, in table order, so that
+ * format queries on the validate path do not scan the whole table.
+ */
+static const std::unordered_map<int, std::vector<uint32_t>> &getHalFormatIndex() {
+    static const auto *sIndex = [] {
+        auto *index = new std::unordered_map<int, std::vector<uint32_t>>();
+        for (uint32_t i = 0; i < FORMAT_MAX_CNT; i++) {
+            (*index)[exynos_format_desc[i].halFormat].push_back(i);
+        }
+        return index;
+    }();
+    return *sIndex;
+}
+
+static const format_description_t *findFirstFormatDesc(int halFormat) {
+    const auto &index = getHalFormatIndex();
+    auto it = index.find(halFormat);
+    return (it != index.end()) ? &exynos_format_desc[it->second.front()] : nullptr;
+}
+
 const format_description_t* halFormatToExynosFormat(int inHalFormat, uint32_t inCompressType) {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++) {
-        const int descHalFormat = exynos_format_desc[i].halFormat;
+    const auto &index = getHalFormatIndex();
+    auto it = index.find(inHalFormat);
+    if (it == index.end()) return nullptr;
 
-        if ((inHalFormat == descHalFormat) &&
-            exynos_format_desc[i].isCompressionSupported(inCompressType)) {
+    for (uint32_t i : it->second) {
+        if (exynos_format_desc[i].isCompressionSupported(inCompressType)) {
             return &exynos_format_desc[i];
         }
     }
@@ -146,10 +169,8 @@ const format_description_t* halFormatToExynosFormat(int inHalFormat, uint32_t in
 
 uint8_t formatToBpp(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format)
-            return exynos_format_desc[i].bpp;
-    }
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc != nullptr) return desc->bpp;
 
     ALOGW("unrecognized pixel format %u", format);
     return 0;
@@ -167,15 +188,9 @@ uint8_t DpuFormatToBpp(decon_pixel_format format)
 
 bool isFormatRgb(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if (exynos_format_desc[i].type & RGB)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->type & RGB;
 }
 
 bool isFormatYUV(int format)
@@ -187,106 +202,56 @@ bool isFormatYUV(int format)
 
 bool isFormatSBWC(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if (exynos_format_desc[i].type & COMP_TYPE_SBWC)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->type & COMP_TYPE_SBWC;
 }
 
 bool isFormatYUV420(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if (exynos_format_desc[i].type & YUV420)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->type & YUV420;
 }
 
 bool isFormatYUV8_2(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if ((exynos_format_desc[i].type & YUV420) &&
-                (exynos_format_desc[i].type & BIT8_2))
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return (desc->type & YUV420) && (desc->type & BIT8_2);
 }
 
 bool isFormat10BitYUV420(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if ((exynos_format_desc[i].type & YUV420) &&
-                (exynos_format_desc[i].type & BIT10))
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return (desc->type & YUV420) && (desc->type & BIT10);
 }
 
 bool isFormatYUV422(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if (exynos_format_desc[i].type & YUV422)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->type & YUV422;
 }
 
 bool isFormatP010(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++){
-        if (exynos_format_desc[i].halFormat == format) {
-            if (exynos_format_desc[i].type & P010)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->type & P010;
 }
 
 bool isFormat10Bit(int format) {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++) {
-        if (exynos_format_desc[i].halFormat == format) {
-            if ((exynos_format_desc[i].type & BIT_MASK) == BIT10)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return (desc->type & BIT_MASK) == BIT10;
 }
 
 bool isFormat8Bit(int format) {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++) {
-        if (exynos_format_desc[i].halFormat == format) {
-            if ((exynos_format_desc[i].type & BIT_MASK) == BIT8)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return (desc->type & BIT_MASK) == BIT8;
 }
 
 bool isFormatYCrCb(int format)
@@ -296,26 +261,17 @@ bool isFormatYCrCb(int format)
 
 bool isFormatLossy(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++) {
-        if (exynos_format_desc[i].halFormat == format) {
-            uint32_t sbwcType = exynos_format_desc[i].type & FORMAT_SBWC_MASK;
-            if (sbwcType && sbwcType != SBWC_LOSSLESS)
-                return true;
-            else
-                return false;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    uint32_t sbwcType = desc->type & FORMAT_SBWC_MASK;
+    return sbwcType && sbwcType != SBWC_LOSSLESS;
 }
 
 bool formatHasAlphaChannel(int format)
 {
-    for (unsigned int i = 0; i < FORMAT_MAX_CNT; i++) {
-        if (exynos_format_desc[i].halFormat == format) {
-            return exynos_format_desc[i].hasAlpha;
-        }
-    }
-    return false;
+    const format_description_t *desc = findFirstFormatDesc(format);
+    if (desc == nullptr) return false;
+    return desc->hasAlpha;
 }
 
 bool isAFBCCompressed(const buffer_handle_t handle) {
@@ -680,6 +636,67 @@ void adjustRect(hwc_rect_t &rect, int32_t width, int32_t height)
         rect.bottom = height;
 }
 
+static inline uint64_t damageRegionCost(const hwc_rect &rect, uint64_t regionOverhead)
+{
+    return (uint64_t)WIDTH(rect) * HEIGHT(rect) + regionOverhead;
+}
+
+uint64_t reduceDamageRegion(std::vector<hwc_rect> &rects, uint32_t maxRegions,
+                            uint64_t regionOverhead)
+{
+    if (maxRegions == 0) maxRegions = 1;
+
+    rects.erase(std::remove_if(rects.begin(), rects.end(),
+                               [](const hwc_rect &r) {
+                                   return r.right <= r.left || r.bottom <= r.top;
+                               }),
+                rects.end());
+    if (rects.empty()) return 0;
+
+    std::sort(rects.begin(), rects.end(),
+              [](const hwc_rect &a, const hwc_rect &b) { return a.top < b.top; });
+
+    /* Rectangles sharing rows are fetched together */
+    std::vector<hwc_rect> bands;
+    bands.push_back(rects[0]);
+    for (size_t i = 1; i < rects.size(); i++) {
+        if (rects[i].top < bands.back().bottom)
+            bands.back() = expand(bands.back(), rects[i]);
+        else
+            bands.push_back(rects[i]);
+    }
+
+    /*
+     * Merging two neighbouring bands never overlaps the others because the
+     * bands are sorted and do not share rows.
+     */
+    while (bands.size() > 1) {
+        size_t best = 0;
+        int64_t bestDelta = INT64_MAX;
+        for (size_t i = 0; i + 1 < bands.size(); i++) {
+            int64_t delta = (int64_t)damageRegionCost(expand(bands[i], bands[i + 1]),
+                                                      regionOverhead) -
+                    (int64_t)damageRegionCost(bands[i], regionOverhead) -
+                    (int64_t)damageRegionCost(bands[i + 1], regionOverhead);
+            if (delta < bestDelta) {
+                bestDelta = delta;
+                best = i;
+            }
+        }
+
+        if ((bestDelta > 0) && (bands.size() <= maxRegions)) break;
+
+        bands[best] = expand(bands[best], bands[best + 1]);
+        bands.erase(bands.begin() + best + 1);
+    }
+
+    uint64_t cost = 0;
+    for (auto &band : bands) cost += damageRegionCost(band, regionOverhead);
+
+    rects = std::move(bands);
+    return cost;
+}
+
 uint32_t getBufferNumOfFormat(int format, uint32_t compressType) {
     auto exynosFormat = halFormatToExynosFormat(format, compressType);
     return (exynosFormat != nullptr) ? exynosFormat->bufferNum : 0;
@@ -903,6 +920,27 @@ int hwc_dup(int fd, ExynosDisplay* display, HwcFdebugFenceType type, HwcFdebugIp
     return dup_fd;
 }
 
+int hwc_fence_merge(int fence1, int fence2, ExynosDisplay* display, HwcFdebugFenceType type,
+                    HwcFdebugIpType ip, bool pendingAllowed) {
+    if (fence1 < 0) return fence2;
+    if (fence2 < 0) return fence1;
+
+    int merged = sync_merge("hwc_merged", fence1, fence2);
+    if (merged < 0) {
+        ALOGE("%s : failed to merge %d and %d, ret(%d, %s)", __func__, fence1, fence2, errno,
+              strerror(errno));
+        fence_close(fence2, display, type, ip);
+        return fence1;
+    }
+
+    setFenceInfo(merged, display, type, ip, HwcFenceDirection::FROM, pendingAllowed);
+    fence_close(fence1, display, type, ip);
+    fence_close(fence2, display, type, ip);
+    FT_LOGD("merged %d from %d and %d", merged, fence1, fence2);
+
+    return merged;
+}
+
 int hwc_print_stack() {
     /* CallStack stack; */
     /* stack.update(); */
@@ -928,32 +966,69 @@ void setFenceInfo(uint32_t fd, const ExynosDisplay *display, HwcFdebugFenceType
                                           dupFrom);
 }
 
+static uint64_t packFenceTrace(HwcFenceDirection direction, HwcFdebugFenceType type,
+                               HwcFdebugIpType ip) {
+    const uint64_t timeMs = ns2ms(systemTime(SYSTEM_TIME_MONOTONIC));
+    return (timeMs << 24) | ((static_cast<uint64_t>(ip) & 0xff) << 16) |
+            ((static_cast<uint64_t>(type) & 0xff) << 8) |
+            (static_cast<uint64_t>(direction) & 0xff);
+}
+
+static HwcFenceTrace unpackFenceTrace(uint64_t packed) {
+    // convert the monotonic time to wall clock time for printing
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    const int64_t agoUs =
+            (ns2ms(systemTime(SYSTEM_TIME_MONOTONIC)) - static_cast<int64_t>(packed >> 24)) * 1000;
+    const int64_t timeUs = (now.tv_sec * 1000000LL + now.tv_usec) - agoUs;
+
+    HwcFenceTrace trace = {.direction = static_cast<HwcFenceDirection>(packed & 0xff),
+                           .type = static_cast<HwcFdebugFenceType>((packed >> 8) & 0xff),
+                           .ip = static_cast<HwcFdebugIpType>((packed >> 16) & 0xff),
+                           .time = {static_cast<time_t>(timeUs / 1000000),
+                                    static_cast<suseconds_t>(timeUs % 1000000)}};
+    return trace;
+}
+
 void FenceTracker::updateFenceInfo(uint32_t fd, const ExynosDisplay *display,
                                    HwcFdebugFenceType type, HwcFdebugIpType ip,
                                    HwcFenceDirection direction, bool pendingAllowed,
                                    int32_t dupFrom) {
-    std::scoped_lock lock(mFenceMutex);
-    HwcFenceInfo &info = mFenceInfos[fd];
-    info.displayId = display->mDisplayId;
+    if (fd < mFenceSlots.size()) {
+        updateSlot(mFenceSlots[fd], fd, display, type, ip, direction, pendingAllowed, dupFrom);
+        return;
+    }
+
+    std::scoped_lock lock(mOverflowMutex);
+    FenceSlot &slot = mOverflowSlots[fd];
+    updateSlot(slot, fd, display, type, ip, direction, pendingAllowed, dupFrom);
+    if (slot.usage.load(std::memory_order_relaxed) == 0) mOverflowSlots.erase(fd);
+}
+
+void FenceTracker::updateSlot(FenceSlot &slot, uint32_t fd, const ExynosDisplay *display,
+                              HwcFdebugFenceType type, HwcFdebugIpType ip,
+                              HwcFenceDirection direction, bool pendingAllowed,
+                              int32_t dupFrom) {
+    slot.displayId.store(display->mDisplayId, std::memory_order_relaxed);
 
-    if (info.leaking) {
+    if (slot.leaking.load(std::memory_order_relaxed)) {
         return;
     }
 
+    int32_t delta = 0;
     switch (direction) {
         case HwcFenceDirection::FROM:
-            info.usage++;
+            delta = 1;
             break;
         case HwcFenceDirection::TO:
-            info.usage--;
+            delta = -1;
             break;
         case HwcFenceDirection::DUP:
-            info.usage++;
-            info.dupFrom = dupFrom;
+            delta = 1;
+            slot.dupFrom.store(dupFrom, std::memory_order_relaxed);
             break;
         case HwcFenceDirection::CLOSE:
-            info.usage--;
-            if (info.usage < 0) info.usage = 0;
+            delta = -1;
             break;
         case HwcFenceDirection::UPDATE:
             break;
@@ -962,38 +1037,74 @@ void FenceTracker::updateFenceInfo(uint32_t fd, const ExynosDisplay *display,
             break;
     }
 
-    if (info.usage == 0) {
-        mFenceInfos.erase(fd);
+    int32_t prevUsage = slot.usage.load(std::memory_order_relaxed);
+    int32_t usage;
+    do {
+        usage = prevUsage + delta;
+        if ((direction == HwcFenceDirection::CLOSE) && (usage < 0)) usage = 0;
+    } while (!slot.usage.compare_exchange_weak(prevUsage, usage, std::memory_order_acq_rel));
+
+    if (usage == 0) {
+        if (prevUsage != 0) {
+            mActiveFences.fetch_sub(1, std::memory_order_relaxed);
+        }
+        slot.dupFrom.store(-1, std::memory_order_relaxed);
+        slot.pendingAllowed.store(false, std::memory_order_relaxed);
+        slot.traceCount.store(0, std::memory_order_release);
         return;
-    } else if (info.usage < 0) {
-        ALOGE("%s : Invalid negative usage (%d) for Fence FD:%d", __func__, info.usage, fd);
-        printLastFenceInfoLocked(fd);
     }
 
-    HwcFenceTrace trace = {.direction = direction, .type = type, .ip = ip, .time = {0, 0}};
-
-    gettimeofday(&trace.time, NULL);
+    if (prevUsage == 0) {
+        mActiveFences.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (usage < 0) {
+        ALOGE("%s : Invalid negative usage (%d) for Fence FD:%d", __func__, usage, fd);
+        printLastFenceInfo(fd, slot);
+    }
 
-    info.traces.push_back(trace);
+    const uint32_t traceIndex = slot.traceCount.fetch_add(1, std::memory_order_acq_rel);
+    slot.traces[traceIndex % kFenceTraceDepth].store(packFenceTrace(direction, type, ip),
+                                                      std::memory_order_release);
 
     FT_LOGW("FD : %d, direction : %d, type : %d, ip : %d", fd, direction, type, ip);
 
     // Fence's usage count shuld be zero at end of frame(present done).
     // This flag means usage count of the fence can be pended over frame.
-    info.pendingAllowed = pendingAllowed;
+    slot.pendingAllowed.store(pendingAllowed, std::memory_order_relaxed);
+}
+
+std::vector<HwcFenceTrace> FenceTracker::getTraces(const FenceSlot &slot) const {
+    std::vector<HwcFenceTrace> traces;
+    const uint32_t count = slot.traceCount.load(std::memory_order_acquire);
+    const uint32_t first = (count > kFenceTraceDepth) ? (count - kFenceTraceDepth) : 0;
+    traces.reserve(count - first);
+    for (uint32_t i = first; i < count; i++) {
+        traces.push_back(unpackFenceTrace(
+                slot.traces[i % kFenceTraceDepth].load(std::memory_order_acquire)));
+    }
+    return traces;
+}
+
+void FenceTracker::forEachSlotLocked(const std::function<bool(uint32_t, FenceSlot &)> &fn) {
+    for (uint32_t fd = 0; fd < mFenceSlots.size(); fd++) {
+        if (!fn(fd, mFenceSlots[fd])) return;
+    }
+
+    std::scoped_lock lock(mOverflowMutex);
+    for (auto &[fd, slot] : mOverflowSlots) {
+        if (!fn(fd, slot)) return;
+    }
 }
 
-void FenceTracker::printLastFenceInfoLocked(uint32_t fd) {
+void FenceTracker::printLastFenceInfo(uint32_t fd, const FenceSlot &slot) const {
     if (!fence_valid(fd)) return;
 
-    auto it = mFenceInfos.find(fd);
-    if (it == mFenceInfos.end()) return;
-    HwcFenceInfo &info = it->second;
-    FT_LOGD("---- Fence FD : %d, Display(%d) ----", fd, info.displayId);
-    FT_LOGD("usage: %d, dupFrom: %d, pendingAllowed: %d, leaking: %d", info.usage, info.dupFrom,
-            info.pendingAllowed, info.leaking);
+    if (slot.usage.load(std::memory_order_relaxed) == 0) return;
+    FT_LOGD("---- Fence FD : %d, Display(%d) ----", fd, slot.displayId.load());
+    FT_LOGD("usage: %d, dupFrom: %d, pendingAllowed: %d, leaking: %d", slot.usage.load(),
+            slot.dupFrom.load(), slot.pendingAllowed.load(), slot.leaking.load());
 
-    for (const auto &trace : info.traces) {
+    for (const auto &trace : getTraces(slot)) {
         FT_LOGD("> dir: %d, type: %d, ip: %d, time:%s", trace.direction, trace.type, trace.ip,
                 getLocalTimeStr(trace.time).c_str());
     }
@@ -1001,48 +1112,49 @@ void FenceTracker::printLastFenceInfoLocked(uint32_t fd) {
 
 void FenceTracker::dumpFenceInfoLocked(int32_t count) {
     FT_LOGD("Dump fence (up to %d fences) ++", count);
-    for (const auto &[fd, info] : mFenceInfos) {
-        if (info.pendingAllowed) continue;
-        if (count-- <= 0) break;
-        printLastFenceInfoLocked(fd);
-    }
+    forEachSlotLocked([&](uint32_t fd, FenceSlot &slot) {
+        if (slot.usage.load(std::memory_order_relaxed) == 0) return true;
+        if (slot.pendingAllowed.load(std::memory_order_relaxed)) return true;
+        if (count-- <= 0) return false;
+        printLastFenceInfo(fd, slot);
+        return true;
+    });
     FT_LOGD("Dump fence --");
 }
 
 void FenceTracker::printLeakFdsLocked() {
-    auto reportLeakFdsLocked = [&fenceInfos = mFenceInfos](int sign) REQUIRES(mFenceMutex) {
+    for (int sign : {+1, -1}) {
         String8 errString;
         errString.appendFormat("Leak Fds (%d) :\n", sign);
 
         int cnt = 0;
-        for (const auto &[fd, info] : fenceInfos) {
-            if (!info.leaking) continue;
-            if (info.usage * sign > 0) {
+        forEachSlotLocked([&](uint32_t fd, FenceSlot &slot) {
+            if (!slot.leaking.load(std::memory_order_relaxed)) return true;
+            if (slot.usage.load(std::memory_order_relaxed) * sign > 0) {
                 errString.appendFormat("%d,", fd);
                 if ((++cnt % 10) == 0) {
                     errString.append("\n");
                 }
             }
-        }
+            return true;
+        });
 
         FT_LOGW("%s", errString.c_str());
-    };
-
-    reportLeakFdsLocked(+1);
-    reportLeakFdsLocked(-1);
+    }
 }
 
 void FenceTracker::dumpNCheckLeakLocked() {
     FT_LOGD("Dump leaking fence ++");
-    for (auto &[fd, info] : mFenceInfos) {
-        if (!info.pendingAllowed) {
+    forEachSlotLocked([&](uint32_t fd, FenceSlot &slot) {
+        if (slot.usage.load(std::memory_order_relaxed) == 0) return true;
+        if (!slot.pendingAllowed.load(std::memory_order_relaxed)) {
             // leak is occurred in this frame first
-            if (!info.leaking) {
-                info.leaking = true;
-                printLastFenceInfoLocked(fd);
+            if (!slot.leaking.exchange(true, std::memory_order_relaxed)) {
+                printLastFenceInfo(fd, slot);
             }
         }
-    }
+        return true;
+    });
 
     int priv = exynosHWCControl.fenceTracer;
     exynosHWCControl.fenceTracer = 3;
@@ -1053,7 +1165,7 @@ void FenceTracker::dumpNCheckLeakLocked() {
 }
 
 bool FenceTracker::fenceWarnLocked(uint32_t threshold) {
-    uint32_t cnt = mFenceInfos.size();
+    uint32_t cnt = mActiveFences.load(std::memory_order_relaxed);
 
     if (cnt > threshold) {
         ALOGE("Fence leak! -- the number of fences(%d) exceeds threshold(%d)", cnt, threshold);
@@ -1069,13 +1181,17 @@ bool FenceTracker::fenceWarnLocked(uint32_t threshold) {
 bool FenceTracker::validateFencePerFrameLocked(const ExynosDisplay *display) {
     bool ret = true;
 
-    for (const auto &[fd, info] : mFenceInfos) {
-        if (info.displayId != display->mDisplayId) continue;
-        if ((!info.pendingAllowed) && (!info.leaking)) {
+    if (mActiveFences.load(std::memory_order_relaxed) == 0) return ret;
+
+    forEachSlotLocked([&](uint32_t, FenceSlot &slot) {
+        if (slot.usage.load(std::memory_order_relaxed) == 0) return true;
+        if (slot.displayId.load(std::memory_order_relaxed) != display->mDisplayId) return true;
+        if ((!slot.pendingAllowed.load(std::memory_order_relaxed)) &&
+            (!slot.leaking.load(std::memory_order_relaxed))) {
             ret = false;
-            break;
         }
-    }
+        return ret;
+    });
 
     if (!ret) {
         int priv = exynosHWCControl.fenceTracer;
@@ -1125,16 +1241,20 @@ int32_t FenceTracker::saveFenceTraceLocked(ExynosDisplay *display) {
     gettimeofday(&tv, NULL);
     saveString.appendFormat("\n====== Fences at time:%s ======\n", getLocalTimeStr(tv).c_str());
 
-    for (const auto &[fd, info] : mFenceInfos) {
-        saveString.appendFormat("---- Fence FD : %d, Display(%d) ----\n", fd, info.displayId);
+    forEachSlotLocked([&](uint32_t fd, FenceSlot &slot) {
+        if (slot.usage.load(std::memory_order_relaxed) == 0) return true;
+        saveString.appendFormat("---- Fence FD : %d, Display(%d) ----\n", fd,
+                                slot.displayId.load());
         saveString.appendFormat("usage: %d, dupFrom: %d, pendingAllowed: %d, leaking: %d\n",
-                                info.usage, info.dupFrom, info.pendingAllowed, info.leaking);
+                                slot.usage.load(), slot.dupFrom.load(), slot.pendingAllowed.load(),
+                                slot.leaking.load());
 
-        for (const auto &trace : info.traces) {
+        for (const auto &trace : getTraces(slot)) {
             saveString.appendFormat("> dir: %d, type: %d, ip: %d, time:%s\n", trace.direction,
                                     trace.type, trace.ip, getLocalTimeStr(trace.time).c_str());
         }
-    }
+        return true;
+    });
 
     fileWriter.write(saveString);
     fileWriter.flush();
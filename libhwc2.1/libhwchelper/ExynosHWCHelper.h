@@ -21,7 +21,11 @@
 #include <hardware/hwcomposer2.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <list>
 #include <optional>
 #include <sstream>
@@ -488,6 +492,12 @@ bool fence_valid(int fence);
 int hwcFdClose(int fd);
 int hwc_dup(int fd, ExynosDisplay *display, HwcFdebugFenceType type, HwcFdebugIpType ip,
             bool pendingAllowed = false);
+/*
+ * Returns a fence signaled when both @fence1 and @fence2 are signaled. Both fences
+ * are tracked as @type and @ip and are closed. The returned fence is tracked alike.
+ */
+int hwc_fence_merge(int fence1, int fence2, ExynosDisplay *display, HwcFdebugFenceType type,
+                    HwcFdebugIpType ip, bool pendingAllowed = false);
 int hwc_print_stack();
 
 inline hwc_rect expand(const hwc_rect &r1, const hwc_rect &r2)
@@ -500,6 +510,18 @@ inline hwc_rect expand(const hwc_rect &r1, const hwc_rect &r2)
     return i;
 }
 
+/*
+ * Reduces @rects to at most @maxRegions rectangles that do not share any row so
+ * that they can be transferred to the panel one after another in the scanout
+ * order. Adjacent rectangles are merged into their bounding box as long as the
+ * merge does not increase the transfer cost or there are too many rectangles.
+ * The cost of a rectangle is its area plus @regionOverhead pixels spent on the
+ * setup of each transfer. Empty rectangles are dropped.
+ * Returns the total cost of the remaining rectangles.
+ */
+uint64_t reduceDamageRegion(std::vector<hwc_rect> &rects, uint32_t maxRegions,
+                            uint64_t regionOverhead);
+
 template <typename T>
 inline T pixel_align_down(const T x, const uint32_t a) {
     static_assert(std::numeric_limits<T>::is_integer,
@@ -532,15 +554,6 @@ struct HwcFenceTrace {
     struct timeval time = {0, 0};
 };
 
-struct HwcFenceInfo {
-    uint32_t displayId = HWC_DISPLAY_PRIMARY;
-    int32_t usage = 0;
-    int32_t dupFrom = -1;
-    bool pendingAllowed = false;
-    bool leaking = false;
-    std::list<HwcFenceTrace> traces = {};
-};
-
 class funcReturnCallback {
 public:
     funcReturnCallback(const std::function<void(void)> cb) : mCb(cb) {}
@@ -565,7 +578,29 @@ public:
     bool validateFences(ExynosDisplay *display);
 
 private:
-    void printLastFenceInfoLocked(uint32_t fd) REQUIRES(mFenceMutex);
+    static constexpr uint32_t kFenceTraceDepth = 8;
+
+    // Fence info of one fd. Slots of mFenceSlots are updated without lock from any thread,
+    // the last kFenceTraceDepth traces are kept in a ring packed as
+    // (monotonic time in ms << 24 | ip << 16 | type << 8 | direction).
+    struct FenceSlot {
+        std::atomic<int32_t> usage{0};
+        std::atomic<uint32_t> displayId{HWC_DISPLAY_PRIMARY};
+        std::atomic<int32_t> dupFrom{-1};
+        std::atomic<bool> pendingAllowed{false};
+        std::atomic<bool> leaking{false};
+        std::atomic<uint32_t> traceCount{0};
+        std::array<std::atomic<uint64_t>, kFenceTraceDepth> traces{};
+    };
+
+    void updateSlot(FenceSlot &slot, uint32_t fd, const ExynosDisplay *display,
+                    HwcFdebugFenceType type, HwcFdebugIpType ip, HwcFenceDirection direction,
+                    bool pendingAllowed, int32_t dupFrom);
+    // Calls @fn for each slot of mFenceSlots and mOverflowSlots until @fn returns false
+    void forEachSlotLocked(const std::function<bool(uint32_t, FenceSlot &)> &fn)
+            REQUIRES(mFenceMutex);
+    std::vector<HwcFenceTrace> getTraces(const FenceSlot &slot) const;
+    void printLastFenceInfo(uint32_t fd, const FenceSlot &slot) const;
     void dumpFenceInfoLocked(int32_t count) REQUIRES(mFenceMutex);
     void printLeakFdsLocked() REQUIRES(mFenceMutex);
     void dumpNCheckLeakLocked() REQUIRES(mFenceMutex);
@@ -573,8 +608,15 @@ private:
     bool validateFencePerFrameLocked(const ExynosDisplay *display) REQUIRES(mFenceMutex);
     int32_t saveFenceTraceLocked(ExynosDisplay *display) REQUIRES(mFenceMutex);
 
-    std::map<int, HwcFenceInfo> mFenceInfos GUARDED_BY(mFenceMutex);
+    std::array<FenceSlot, MAX_FD_NUM> mFenceSlots;
+    // number of fds with non-zero usage
+    std::atomic<uint32_t> mActiveFences{0};
+    // serializes validation and dump, updateFenceInfo() does not take it
     mutable std::mutex mFenceMutex;
+    // slots of fds out of mFenceSlots range, an entry is erased when its usage drops to
+    // zero. mOverflowMutex is taken after mFenceMutex.
+    std::mutex mOverflowMutex;
+    std::unordered_map<uint32_t, FenceSlot> mOverflowSlots GUARDED_BY(mOverflowMutex);
 };
 
 android_dataspace colorModeToDataspace(android_color_mode_t mode);
@@ -673,6 +715,34 @@ struct RollingAverage {
     }
 };
 
+// Keeps the last bufferSize samples of a duration and reports percentiles over them.
+template <size_t bufferSize>
+struct LatencySampler {
+    std::array<int64_t, bufferSize> buffer{0};
+    size_t elems = 0;
+    size_t buffer_index = 0;
+    int64_t max = 0;
+    void insert(int64_t newTime) {
+        buffer[buffer_index] = newTime;
+        buffer_index = (buffer_index + 1) % bufferSize;
+        elems = std::min(elems + 1, bufferSize);
+        max = std::max(max, newTime);
+    }
+    // percentiles must be sorted ascending, results are written in the same order
+    template <size_t N>
+    std::array<int64_t, N> getPercentiles(const std::array<uint32_t, N>& percentiles) const {
+        std::array<int64_t, N> result{0};
+        if (elems == 0) return result;
+        std::array<int64_t, bufferSize> sorted = buffer;
+        std::sort(sorted.begin(), sorted.begin() + elems);
+        for (size_t i = 0; i < N; i++) {
+            size_t rank = (elems * std::min(percentiles[i], 100u) + 99) / 100;
+            result[i] = sorted[rank ? rank - 1 : 0];
+        }
+        return result;
+    }
+};
+
 // Waits for a given property value, or returns std::nullopt if unavailable
 std::optional<std::string> waitForPropertyValue(const std::string &property, int64_t timeoutMs);
 
@@ -234,6 +234,8 @@ ExynosMPP::ExynosMPP(ExynosResourceManager* resourceManager,
         mAcrylicHandle->setDefaultColor(0, 0, 0, 0);
     }
 
+    setupPPCTable();
+
     mAssignedSources.clear();
     resetUsedCapacity();
 
@@ -476,29 +478,12 @@ bool ExynosMPP::isSrcFormatSupported(struct exynos_image &src)
 
     if (mResourceManager == NULL) return false;
 
-    for (uint32_t i = 0 ; i < mResourceManager->mFormatRestrictionCnt; i++) {
-        if ((mResourceManager->mFormatRestrictions[i].hwType == mPhysicalType) &&
-                ((mResourceManager->mFormatRestrictions[i].nodeType == NODE_NONE) ||
-                 (mResourceManager->mFormatRestrictions[i].nodeType == NODE_SRC)) &&
-                (mResourceManager->mFormatRestrictions[i].format == src.format))
-            return true;
-    }
-
-    return false;
+    return mSrcFormats.count(src.format) != 0;
 }
 
 bool ExynosMPP::isDstFormatSupported(struct exynos_image &dst)
 {
-
-    for (uint32_t i = 0 ; i < mResourceManager->mFormatRestrictionCnt; i++) {
-        if ((mResourceManager->mFormatRestrictions[i].hwType == mPhysicalType) &&
-                ((mResourceManager->mFormatRestrictions[i].nodeType == NODE_NONE) ||
-                 (mResourceManager->mFormatRestrictions[i].nodeType == NODE_DST)) &&
-                (mResourceManager->mFormatRestrictions[i].format == dst.format))
-            return true;
-    }
-
-    return false;
+    return mDstFormats.count(dst.format) != 0;
 }
 
 uint32_t ExynosMPP::getMaxUpscale(const struct exynos_image &src,
@@ -1869,11 +1854,12 @@ int32_t ExynosMPP::setDstAcquireFence(int acquireFence)
         return -EINVAL;
     }
 
+    /* A fence left by holdDstBuffer() is kept */
     if (mDstImgs[dstBufIndex].acrylicAcquireFenceFd >= 0) {
-        MPP_LOGD(eDebugFence,"mDstImgs[%d].acrylicAcquireFenceFd: %d is closed", dstBufIndex,
+        MPP_LOGD(eDebugFence,"mDstImgs[%d].acrylicAcquireFenceFd: %d is merged", dstBufIndex,
                 mDstImgs[dstBufIndex].acrylicAcquireFenceFd);
-        fence_close(mDstImgs[dstBufIndex].acrylicAcquireFenceFd, mAssignedDisplay,
-                FENCE_TYPE_DST_ACQUIRE, FENCE_IP_ALL);
+        acquireFence = hwc_fence_merge(mDstImgs[dstBufIndex].acrylicAcquireFenceFd, acquireFence,
+                mAssignedDisplay, FENCE_TYPE_DST_ACQUIRE, FENCE_IP_ALL, true);
     }
     if (mPhysicalType == MPP_MSC)
         mDstImgs[dstBufIndex].acrylicAcquireFenceFd =
@@ -1890,6 +1876,18 @@ int32_t ExynosMPP::setDstAcquireFence(int acquireFence)
     return NO_ERROR;
 }
 
+void ExynosMPP::holdDstBuffer(int fence)
+{
+    if (mCurrentDstBuf < 0 || mCurrentDstBuf >= NUM_MPP_DST_BUFS(mLogicalType)) {
+        fence_close(fence, mAssignedDisplay, FENCE_TYPE_DST_ACQUIRE, FENCE_IP_ALL);
+        return;
+    }
+
+    mDstImgs[mCurrentDstBuf].acrylicAcquireFenceFd =
+        hwc_fence_merge(mDstImgs[mCurrentDstBuf].acrylicAcquireFenceFd, fence,
+                mAssignedDisplay, FENCE_TYPE_DST_ACQUIRE, FENCE_IP_ALL, true);
+}
+
 int32_t ExynosMPP::resetDstReleaseFence()
 {
     MPP_LOGD(eDebugFence, "");
@@ -1992,6 +1990,17 @@ int32_t ExynosMPP::setupRestriction() {
 
     MPP_LOGD(eDebugMPP, "mPhysicalType(%d)", mPhysicalType);
 
+    mSrcFormats.clear();
+    mDstFormats.clear();
+    for (uint32_t i = 0; i < mResourceManager->mFormatRestrictionCnt; i++) {
+        const restriction_key_t &key = mResourceManager->mFormatRestrictions[i];
+        if (key.hwType != mPhysicalType) continue;
+        if ((key.nodeType == NODE_NONE) || (key.nodeType == NODE_SRC))
+            mSrcFormats.insert(key.format);
+        if ((key.nodeType == NODE_NONE) || (key.nodeType == NODE_DST))
+            mDstFormats.insert(key.format);
+    }
+
     for (uint32_t i = 0; i < RESTRICTION_MAX; i++) {
         const restriction_size_element *restriction_size_table = mResourceManager->mSizeRestrictions[i];
         for (uint32_t j = 0; j < mResourceManager->mSizeRestrictionCnt[i]; j++) {
@@ -2403,6 +2412,19 @@ bool ExynosMPP::isCapacityExceptionCondition(float totalUsedCapacity, float requ
     }
 }
 
+void ExynosMPP::setupPPCTable()
+{
+    for (uint32_t formatIndex = 0; formatIndex < PPC_FORMAT_FORMAT_MAX; formatIndex++) {
+        for (uint32_t rotIndex = 0; rotIndex < PPC_ROT_MAX; rotIndex++) {
+            auto it = ppc_table_map.find(PPC_IDX(mPhysicalType, formatIndex, rotIndex));
+            mHasPPC[formatIndex][rotIndex] = (it != ppc_table_map.end());
+            if (!mHasPPC[formatIndex][rotIndex]) continue;
+            for (uint32_t scaleIndex = 0; scaleIndex < PPC_SCALE_MAX; scaleIndex++)
+                mPPCTable[formatIndex][rotIndex][scaleIndex] = it->second.ppcList[scaleIndex];
+        }
+    }
+}
+
 void ExynosMPP::getPPCIndex(const struct exynos_image &src,
         const struct exynos_image &dst,
         uint32_t &formatIndex, uint32_t &rotIndex, uint32_t &scaleIndex,
@@ -2413,22 +2435,22 @@ void ExynosMPP::getPPCIndex(const struct exynos_image &src,
     scaleIndex = 0;
 
     /* Compare SBWC, AFBC and 10bitYUV420 first! because can be overlapped with other format */
-    if (isFormatSBWC(criteria.format) && hasPPC(mPhysicalType, PPC_FORMAT_SBWC, PPC_ROT_NO))
+    if (isFormatSBWC(criteria.format) && hasPPCEntry(PPC_FORMAT_SBWC, PPC_ROT_NO))
         formatIndex = PPC_FORMAT_SBWC;
     else if (src.compressionInfo.type == COMP_TYPE_AFBC) {
-        if ((isFormatRgb(criteria.format)) && hasPPC(mPhysicalType, PPC_FORMAT_AFBC_RGB, PPC_ROT_NO))
+        if ((isFormatRgb(criteria.format)) && hasPPCEntry(PPC_FORMAT_AFBC_RGB, PPC_ROT_NO))
             formatIndex = PPC_FORMAT_AFBC_RGB;
-        else if ((isFormatYUV(criteria.format)) && hasPPC(mPhysicalType, PPC_FORMAT_AFBC_YUV, PPC_ROT_NO))
+        else if ((isFormatYUV(criteria.format)) && hasPPCEntry(PPC_FORMAT_AFBC_YUV, PPC_ROT_NO))
             formatIndex = PPC_FORMAT_AFBC_YUV;
         else {
             formatIndex = PPC_FORMAT_RGB32;
             MPP_LOGW("%s:: AFBC PPC is not existed. Use default PPC", __func__);
         }
-    } else if (isFormatP010(criteria.format) && hasPPC(mPhysicalType, PPC_FORMAT_P010, PPC_ROT_NO))
+    } else if (isFormatP010(criteria.format) && hasPPCEntry(PPC_FORMAT_P010, PPC_ROT_NO))
         formatIndex = PPC_FORMAT_P010;
-    else if (isFormatYUV420(criteria.format) && hasPPC(mPhysicalType, PPC_FORMAT_YUV420, PPC_ROT_NO))
+    else if (isFormatYUV420(criteria.format) && hasPPCEntry(PPC_FORMAT_YUV420, PPC_ROT_NO))
         formatIndex = PPC_FORMAT_YUV420;
-    else if (isFormatYUV422(criteria.format) && hasPPC(mPhysicalType, PPC_FORMAT_YUV422, PPC_ROT_NO))
+    else if (isFormatYUV422(criteria.format) && hasPPCEntry(PPC_FORMAT_YUV422, PPC_ROT_NO))
         formatIndex = PPC_FORMAT_YUV422;
     else
         formatIndex = PPC_FORMAT_RGB32;
@@ -2485,8 +2507,8 @@ float ExynosMPP::getPPC(const struct exynos_image &src,
     }
 
     if (mPhysicalType == MPP_G2D || mPhysicalType == MPP_MSC) {
-        if (hasPPC(mPhysicalType, formatIndex, rotIndex)) {
-            PPC = ppc_table_map.at(PPC_IDX(mPhysicalType, formatIndex, rotIndex)).ppcList[scaleIndex];
+        if (hasPPCEntry(formatIndex, rotIndex) && (scaleIndex < PPC_SCALE_MAX)) {
+            PPC = mPPCTable[formatIndex][rotIndex][scaleIndex];
         }
     }
 
@@ -2960,4 +2982,6 @@ void ExynosMPP::updatePreassignedDisplay(uint32_t fromDisplayBit, uint32_t toDis
 
     if (mPreAssignDisplayInfo == fromDisplayBit)
         mPreAssignDisplayInfo = toDisplayBit;
+
+    ExynosResourceManager::bumpMPPStateGeneration();
 }
@@ -30,7 +30,7 @@
 #include <utils/Vector.h>
 #include <map>
 #include <hardware/exynos/acryl.h>
-#include <map>
+#include <unordered_set>
 #include "ExynosHWCModule.h"
 #include "ExynosHWCHelper.h"
 #include "ExynosMPPType.h"
@@ -559,6 +559,9 @@ public:
     bool mNeedCompressedTarget;
     struct restriction_size mSrcSizeRestrictions[RESTRICTION_MAX];
     struct restriction_size mDstSizeRestrictions[RESTRICTION_MAX];
+    /* HAL formats allowed by mFormatRestrictions for this MPP, built by setupRestriction() */
+    std::unordered_set<uint32_t> mSrcFormats;
+    std::unordered_set<uint32_t> mDstFormats;
 
     // Force Dst buffer reallocation
     dst_alloc_buf_size_t mDstAllocatedSize;
@@ -590,6 +593,8 @@ public:
     int32_t resetSrcReleaseFence();
     int32_t getDstImageInfo(exynos_image *img);
     int32_t setDstAcquireFence(int releaseFence);
+    /* Keeps the current dst buffer from being written until @fence is signaled */
+    void holdDstBuffer(int fence);
     int32_t resetDstReleaseFence();
     int32_t requestHWStateChange(uint32_t state);
     int32_t setHWStateFence(int32_t fence);
@@ -731,6 +736,18 @@ protected:
             const struct exynos_image *assignCheckDst = NULL);
     float getPPC() { return mPPC; };
 
+    /*
+     * Dense copy of the ppc_table_map entries of mPhysicalType, filled once by
+     * setupPPCTable() so that getPPC() does not search the map per candidate
+     */
+    bool mHasPPC[PPC_FORMAT_FORMAT_MAX][PPC_ROT_MAX] = {};
+    float mPPCTable[PPC_FORMAT_FORMAT_MAX][PPC_ROT_MAX][PPC_SCALE_MAX] = {};
+    void setupPPCTable();
+    bool hasPPCEntry(uint32_t formatIndex, uint32_t rotIndex) const {
+        return (formatIndex < PPC_FORMAT_FORMAT_MAX) && (rotIndex < PPC_ROT_MAX) &&
+                mHasPPC[formatIndex][rotIndex];
+    }
+
     /* format and rotation index are defined by indexImage */
     void getPPCIndex(const struct exynos_image &indexImage,
             const struct exynos_image &refImage,
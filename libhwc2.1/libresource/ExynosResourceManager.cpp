@@ -44,6 +44,69 @@ using namespace SOC_VERSION;
 
 ExynosMPPVector ExynosResourceManager::mOtfMPPs;
 ExynosMPPVector ExynosResourceManager::mM2mMPPs;
+std::atomic<uint32_t> ExynosResourceManager::sMPPStateGeneration = 0;
+
+void SupportedMPPCacheKey::ImageKey::set(const exynos_image &img) {
+    fullWidth = img.fullWidth;
+    fullHeight = img.fullHeight;
+    x = img.x;
+    y = img.y;
+    w = img.w;
+    h = img.h;
+    format = img.format;
+    usageFlags = img.usageFlags;
+    layerFlags = img.layerFlags;
+    dataSpace = img.dataSpace;
+    blending = img.blending;
+    transform = img.transform;
+    compressionType = img.compressionInfo.type;
+    compressionModifier = img.compressionInfo.modifier;
+    planeAlpha = img.planeAlpha;
+    needColorTransform = img.needColorTransform;
+    needPreblending = img.needPreblending;
+}
+
+bool SupportedMPPCacheKey::ImageKey::operator==(const ImageKey &rhs) const {
+    return fullWidth == rhs.fullWidth && fullHeight == rhs.fullHeight && x == rhs.x &&
+            y == rhs.y && w == rhs.w && h == rhs.h && format == rhs.format &&
+            usageFlags == rhs.usageFlags && layerFlags == rhs.layerFlags &&
+            dataSpace == rhs.dataSpace && blending == rhs.blending &&
+            transform == rhs.transform && compressionType == rhs.compressionType &&
+            compressionModifier == rhs.compressionModifier && planeAlpha == rhs.planeAlpha &&
+            needColorTransform == rhs.needColorTransform &&
+            needPreblending == rhs.needPreblending;
+}
+
+bool SupportedMPPCacheKey::operator==(const SupportedMPPCacheKey &rhs) const {
+    return displayId == rhs.displayId && displayYres == rhs.displayYres &&
+            btsRefreshRate == rhs.btsRefreshRate &&
+            mppStateGeneration == rhs.mppStateGeneration && hasHdrLayer == rhs.hasHdrLayer &&
+            hasDrmLayer == rhs.hasDrmLayer && src == rhs.src && dst == rhs.dst;
+}
+
+size_t SupportedMPPCacheKey::hash() const {
+    size_t seed = 0;
+    auto combine = [&seed](uint64_t value) {
+        seed ^= std::hash<uint64_t>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine((uint64_t)displayId << 32 | displayYres);
+    combine((uint64_t)btsRefreshRate << 32 | mppStateGeneration);
+    combine((uint64_t)hasHdrLayer << 1 | hasDrmLayer);
+    for (const ImageKey *img : {&src, &dst}) {
+        combine((uint64_t)img->fullWidth << 32 | img->fullHeight);
+        combine((uint64_t)img->x << 32 | img->y);
+        combine((uint64_t)img->w << 32 | img->h);
+        combine((uint64_t)img->format << 32 | img->layerFlags);
+        combine(img->usageFlags);
+        combine((uint64_t)img->dataSpace << 32 | img->blending);
+        combine((uint64_t)img->transform << 32 | img->compressionType);
+        combine(img->compressionModifier);
+        combine(std::hash<float>{}(img->planeAlpha));
+        combine((uint64_t)img->needColorTransform << 1 | img->needPreblending);
+    }
+    return seed;
+}
+
 extern struct exynos_hwc_control exynosHWCControl;
 
 ExynosMPPVector::ExynosMPPVector() {
@@ -188,6 +251,7 @@ void ExynosResourceManager::reloadResourceForHWFC()
         if (exynosMPP->mLogicalType == MPP_LOGICAL_G2D_COMBO &&
                 (exynosMPP->mPreAssignDisplayInfo & HWC_DISPLAY_VIRTUAL_BIT)) {
             exynosMPP->reloadResourceForHWFC();
+            sMPPStateGeneration++;
             break;
         }
     }
@@ -1836,7 +1900,6 @@ int32_t ExynosResourceManager::assignWindow(ExynosDisplay *display)
  */
 int32_t ExynosResourceManager::updateSupportedMPPFlag(ExynosDisplay * display)
 {
-    int64_t ret = 0;
     HDEBUGLOGD(eDebugResourceAssigning, "%s++++++++++", __func__);
     for (uint32_t i = 0; i < display->mLayers.size(); i++) {
         ExynosLayer *layer = display->mLayers[i];
@@ -1858,67 +1921,128 @@ int32_t ExynosResourceManager::updateSupportedMPPFlag(ExynosDisplay * display)
         HDEBUGLOGD(eDebugResourceAssigning, "\tdst_img");
         dumpExynosImage(eDebugResourceAssigning, dst_img);
 
-        /* Initialize flags */
-        layer->mSupportedMPPFlag = 0;
-        layer->mCheckMPPFlag.clear();
+        if (!canUseSupportedMPPCache(src_img)) {
+            checkSupportedMPP(display, layer, src_img, dst_img, dst_img_yuv);
+        } else {
+            SupportedMPPCacheKey key;
+            makeSupportedMPPCacheKey(display, src_img, dst_img, key);
+            auto it = mSupportedMPPCache.find(key);
+            if (it != mSupportedMPPCache.end()) {
+                mSupportedMPPCacheHit++;
+                it->second.lastUsed = ++mSupportedMPPCacheTick;
+                layer->mSupportedMPPFlag = it->second.supportedMPPFlag;
+                layer->mCheckMPPFlag = it->second.checkMPPFlag;
+                HDEBUGLOGD(eDebugResourceAssigning, "\tsupported MPP cache hit");
+            } else {
+                mSupportedMPPCacheMiss++;
+                checkSupportedMPP(display, layer, src_img, dst_img, dst_img_yuv);
+                updateSupportedMPPCache(key, layer);
+            }
+        }
+        HDEBUGLOGD(eDebugResourceAssigning, "[%d] layer mSupportedMPPFlag(0x%8x)", i,
+                   layer->mSupportedMPPFlag);
+    }
+    HDEBUGLOGD(eDebugResourceAssigning, "%s-------------", __func__);
+
+    return NO_ERROR;
+}
 
-        /* Check OtfMPPs */
-        for (uint32_t j = 0; j < mOtfMPPs.size(); j++) {
-            if ((ret = mOtfMPPs[j]->isSupported(*display, src_img, dst_img)) == NO_ERROR) {
+void ExynosResourceManager::checkSupportedMPP(ExynosDisplay *display, ExynosLayer *layer,
+                                              exynos_image &src_img, exynos_image &dst_img,
+                                              exynos_image &dst_img_yuv)
+{
+    int64_t ret = 0;
+
+    /* Initialize flags */
+    layer->mSupportedMPPFlag = 0;
+    layer->mCheckMPPFlag.clear();
+
+    /* Check OtfMPPs */
+    for (uint32_t j = 0; j < mOtfMPPs.size(); j++) {
+        if ((ret = mOtfMPPs[j]->isSupported(*display, src_img, dst_img)) == NO_ERROR) {
+            layer->mSupportedMPPFlag |= mOtfMPPs[j]->mLogicalType;
+            HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported", mOtfMPPs[j]->mName.c_str());
+        } else {
+            if (((-ret) == eMPPUnsupportedFormat) &&
+                ((ret = mOtfMPPs[j]->isSupported(*display, src_img, dst_img_yuv)) == NO_ERROR)) {
                 layer->mSupportedMPPFlag |= mOtfMPPs[j]->mLogicalType;
-                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported", mOtfMPPs[j]->mName.c_str());
-            } else {
-                if (((-ret) == eMPPUnsupportedFormat) &&
-                    ((ret = mOtfMPPs[j]->isSupported(*display, src_img, dst_img_yuv)) == NO_ERROR)) {
-                    layer->mSupportedMPPFlag |= mOtfMPPs[j]->mLogicalType;
-                    HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported with yuv dst",
-                               mOtfMPPs[j]->mName.c_str());
-                }
+                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported with yuv dst",
+                           mOtfMPPs[j]->mName.c_str());
             }
-            if (ret < 0) {
-                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: unsupported flag(0x%" PRIx64 ")",
-                           mOtfMPPs[j]->mName.c_str(), -ret);
-                uint64_t checkFlag = 0x0;
-                if (layer->mCheckMPPFlag.find(mOtfMPPs[j]->mLogicalType) !=
-                        layer->mCheckMPPFlag.end()) {
-                    checkFlag = layer->mCheckMPPFlag.at(mOtfMPPs[j]->mLogicalType);
-                }
-                checkFlag |= (-ret);
-                layer->mCheckMPPFlag[mOtfMPPs[j]->mLogicalType] = checkFlag;
+        }
+        if (ret < 0) {
+            HDEBUGLOGD(eDebugResourceAssigning, "\t%s: unsupported flag(0x%" PRIx64 ")",
+                       mOtfMPPs[j]->mName.c_str(), -ret);
+            uint64_t checkFlag = 0x0;
+            if (layer->mCheckMPPFlag.find(mOtfMPPs[j]->mLogicalType) !=
+                    layer->mCheckMPPFlag.end()) {
+                checkFlag = layer->mCheckMPPFlag.at(mOtfMPPs[j]->mLogicalType);
             }
+            checkFlag |= (-ret);
+            layer->mCheckMPPFlag[mOtfMPPs[j]->mLogicalType] = checkFlag;
         }
+    }
 
-        /* Check M2mMPPs */
-        for (uint32_t j = 0; j < mM2mMPPs.size(); j++) {
-            if ((ret = mM2mMPPs[j]->isSupported(*display, src_img, dst_img)) == NO_ERROR) {
+    /* Check M2mMPPs */
+    for (uint32_t j = 0; j < mM2mMPPs.size(); j++) {
+        if ((ret = mM2mMPPs[j]->isSupported(*display, src_img, dst_img)) == NO_ERROR) {
+            layer->mSupportedMPPFlag |= mM2mMPPs[j]->mLogicalType;
+            HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported", mM2mMPPs[j]->mName.c_str());
+        } else {
+            if (((-ret) == eMPPUnsupportedFormat) &&
+                ((ret = mM2mMPPs[j]->isSupported(*display, src_img, dst_img_yuv)) == NO_ERROR)) {
                 layer->mSupportedMPPFlag |= mM2mMPPs[j]->mLogicalType;
-                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported", mM2mMPPs[j]->mName.c_str());
-            } else {
-                if (((-ret) == eMPPUnsupportedFormat) &&
-                    ((ret = mM2mMPPs[j]->isSupported(*display, src_img, dst_img_yuv)) == NO_ERROR)) {
-                    layer->mSupportedMPPFlag |= mM2mMPPs[j]->mLogicalType;
-                    HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported with yuv dst",
-                               mM2mMPPs[j]->mName.c_str());
-                }
+                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: supported with yuv dst",
+                           mM2mMPPs[j]->mName.c_str());
             }
-            if (ret < 0) {
-                HDEBUGLOGD(eDebugResourceAssigning, "\t%s: unsupported flag(0x%" PRIx64 ")",
-                           mM2mMPPs[j]->mName.c_str(), -ret);
-                uint64_t checkFlag = 0x0;
-                if (layer->mCheckMPPFlag.find(mM2mMPPs[j]->mLogicalType) !=
-                        layer->mCheckMPPFlag.end()) {
-                    checkFlag = layer->mCheckMPPFlag.at(mM2mMPPs[j]->mLogicalType);
-                }
-                checkFlag |= (-ret);
-                layer->mCheckMPPFlag[mM2mMPPs[j]->mLogicalType] = checkFlag;
+        }
+        if (ret < 0) {
+            HDEBUGLOGD(eDebugResourceAssigning, "\t%s: unsupported flag(0x%" PRIx64 ")",
+                       mM2mMPPs[j]->mName.c_str(), -ret);
+            uint64_t checkFlag = 0x0;
+            if (layer->mCheckMPPFlag.find(mM2mMPPs[j]->mLogicalType) !=
+                    layer->mCheckMPPFlag.end()) {
+                checkFlag = layer->mCheckMPPFlag.at(mM2mMPPs[j]->mLogicalType);
             }
+            checkFlag |= (-ret);
+            layer->mCheckMPPFlag[mM2mMPPs[j]->mLogicalType] = checkFlag;
         }
-        HDEBUGLOGD(eDebugResourceAssigning, "[%d] layer mSupportedMPPFlag(0x%8x)", i,
-                   layer->mSupportedMPPFlag);
     }
-    HDEBUGLOGD(eDebugResourceAssigning, "%s-------------", __func__);
+}
 
-    return NO_ERROR;
+bool ExynosResourceManager::canUseSupportedMPPCache(const exynos_image &src_img) const
+{
+    /* Dynamic metadata can change without a geometry change */
+    return !src_img.hasMetaParcel;
+}
+
+void ExynosResourceManager::makeSupportedMPPCacheKey(ExynosDisplay *display,
+                                                     const exynos_image &src_img,
+                                                     const exynos_image &dst_img,
+                                                     SupportedMPPCacheKey &key) const
+{
+    key.displayId = display->mDisplayId;
+    key.displayYres = display->mYres;
+    key.btsRefreshRate = display->getBtsRefreshRate();
+    key.mppStateGeneration = sMPPStateGeneration.load();
+    key.hasHdrLayer = hasHdrLayer;
+    key.hasDrmLayer = hasDrmLayer;
+    key.src.set(src_img);
+    key.dst.set(dst_img);
+}
+
+void ExynosResourceManager::updateSupportedMPPCache(const SupportedMPPCacheKey &key,
+                                                    ExynosLayer *layer)
+{
+    if (mSupportedMPPCache.size() >= kSupportedMPPCacheSize) {
+        auto oldest = std::min_element(mSupportedMPPCache.begin(), mSupportedMPPCache.end(),
+                                       [](const auto &lhs, const auto &rhs) {
+                                           return lhs.second.lastUsed < rhs.second.lastUsed;
+                                       });
+        mSupportedMPPCache.erase(oldest);
+    }
+    mSupportedMPPCache[key] = {layer->mSupportedMPPFlag, layer->mCheckMPPFlag,
+                               ++mSupportedMPPCacheTick};
 }
 
 int32_t ExynosResourceManager::resetResources()
@@ -2008,6 +2132,7 @@ void ExynosResourceManager::updatePreAssignDisplayList(const ExynosDisplay* main
     for (auto& mpp : mM2mMPPs) {
         updatePreAssignDisplay(mpp, mainDisp, minorDisp);
     }
+    sMPPStateGeneration++;
 }
 
 int32_t ExynosResourceManager::preAssignResources()
@@ -2365,6 +2490,7 @@ void ExynosResourceManager::enableMPP(uint32_t physicalType, uint32_t physicalIn
             (mOtfMPPs[i]->mPhysicalIndex == physicalIndex) &&
             (mOtfMPPs[i]->mLogicalIndex == logicalIndex)) {
             mOtfMPPs[i]->mEnable = !!(enable);
+            sMPPStateGeneration++;
             return;
         }
     }
@@ -2374,6 +2500,7 @@ void ExynosResourceManager::enableMPP(uint32_t physicalType, uint32_t physicalIn
             (mM2mMPPs[i]->mPhysicalIndex == physicalIndex) &&
             (mM2mMPPs[i]->mLogicalIndex == logicalIndex)) {
             mM2mMPPs[i]->mEnable = !!(enable);
+            sMPPStateGeneration++;
             return;
         }
     }
@@ -2408,6 +2535,7 @@ void ExynosResourceManager::setScaleDownRatio(uint32_t physicalType,
     for (uint32_t i = RESTRICTION_RGB; i < RESTRICTION_MAX; i++) {
         findMpp->mDstSizeRestrictions[i].maxDownScale = scaleDownRatio;
     }
+    sMPPStateGeneration++;
 }
 
 int32_t ExynosResourceManager::prepareResources(const int32_t willOnDispId) {
@@ -2657,6 +2785,7 @@ void ExynosResourceManager::updateRestrictions() {
         mM2mMPPs[i]->updateAttr();
         mM2mMPPs[i]->setupRestriction();
     }
+    sMPPStateGeneration++;
 }
 
 uint32_t ExynosResourceManager::getFeatureTableSize() const
@@ -2711,6 +2840,9 @@ void ExynosResourceManager::dump(String8 &result) const {
     result.appendFormat("[YUV Restrictions]\n");
     dump(RESTRICTION_YUV, result);
 
+    result.appendFormat("[Supported MPP cache] entries: %zu, hit: %" PRIu64 ", miss: %" PRIu64 "\n",
+                        mSupportedMPPCache.size(), mSupportedMPPCacheHit, mSupportedMPPCacheMiss);
+
     result.appendFormat("[MPP Dump]\n");
     for (auto mpp : mOtfMPPs) {
         mpp->dump(result);
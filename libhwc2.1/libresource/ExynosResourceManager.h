@@ -21,6 +21,7 @@
 #ifndef _EXYNOSRESOURCEMANAGER_H
 #define _EXYNOSRESOURCEMANAGER_H
 
+#include <atomic>
 #include <unordered_map>
 #include "ExynosDevice.h"
 #include "ExynosDisplay.h"
@@ -79,6 +80,47 @@ class ExynosMPPVector : public android::SortedVector< ExynosMPP* > {
         virtual int do_compare(const void* lhs, const void* rhs) const;
 };
 
+/*
+ * Everything ExynosMPP::isSupported() depends on for one layer, used as the key of
+ * the supported MPP cache in ExynosResourceManager.
+ */
+struct SupportedMPPCacheKey {
+    struct ImageKey {
+        uint32_t fullWidth;
+        uint32_t fullHeight;
+        uint32_t x;
+        uint32_t y;
+        uint32_t w;
+        uint32_t h;
+        uint32_t format;
+        uint64_t usageFlags;
+        uint32_t layerFlags;
+        android_dataspace dataSpace;
+        uint32_t blending;
+        uint32_t transform;
+        uint32_t compressionType;
+        uint64_t compressionModifier;
+        float planeAlpha;
+        bool needColorTransform;
+        bool needPreblending;
+
+        void set(const exynos_image &img);
+        bool operator==(const ImageKey &rhs) const;
+    };
+
+    uint32_t displayId;
+    uint32_t displayYres;
+    uint32_t btsRefreshRate;
+    uint32_t mppStateGeneration;
+    bool hasHdrLayer;
+    bool hasDrmLayer;
+    ImageKey src;
+    ImageKey dst;
+
+    bool operator==(const SupportedMPPCacheKey &rhs) const;
+    size_t hash() const;
+};
+
 class ExynosResourceManager {
     private:
     class DstBufMgrThread: public Thread {
@@ -172,6 +214,8 @@ class ExynosResourceManager {
         void makeFormatRestrictions(restriction_key_t table);
 
         void updateRestrictions();
+        /* Invalidates the supported MPP cache after an MPP state change */
+        static void bumpMPPStateGeneration() { sMPPStateGeneration++; }
 
         mpp_phycal_type_t getPhysicalType(int ch) const;
         ExynosMPP* getOtfMPPWithChannel(int ch);
@@ -195,6 +239,35 @@ class ExynosResourceManager {
 
         sp<DstBufMgrThread> mDstBufMgrThread;
 
+        /*
+         * Results of the isSupported() scan over all MPPs in updateSupportedMPPFlag(),
+         * so that a layer geometry seen recently does not need to be checked again.
+         * Capacity, window and BTS checks are still done for every validate.
+         */
+        struct SupportedMPPCacheEntry {
+            uint32_t supportedMPPFlag;
+            std::unordered_map<uint32_t, uint64_t> checkMPPFlag;
+            uint64_t lastUsed;
+        };
+        struct SupportedMPPCacheKeyHash {
+            size_t operator()(const SupportedMPPCacheKey &key) const { return key.hash(); }
+        };
+        static constexpr size_t kSupportedMPPCacheSize = 64;
+        std::unordered_map<SupportedMPPCacheKey, SupportedMPPCacheEntry, SupportedMPPCacheKeyHash>
+                mSupportedMPPCache;
+        uint64_t mSupportedMPPCacheTick = 0;
+        uint64_t mSupportedMPPCacheHit = 0;
+        uint64_t mSupportedMPPCacheMiss = 0;
+        /* Bumped whenever MPP restrictions or enable state change */
+        static std::atomic<uint32_t> sMPPStateGeneration;
+
+        bool canUseSupportedMPPCache(const exynos_image &src_img) const;
+        void makeSupportedMPPCacheKey(ExynosDisplay *display, const exynos_image &src_img,
+                                      const exynos_image &dst_img, SupportedMPPCacheKey &key) const;
+        void updateSupportedMPPCache(const SupportedMPPCacheKey &key, ExynosLayer *layer);
+        void checkSupportedMPP(ExynosDisplay *display, ExynosLayer *layer, exynos_image &src_img,
+                               exynos_image &dst_img, exynos_image &dst_img_yuv);
+
     protected:
         virtual void setFrameRateForPerformance(ExynosMPP &mpp, AcrylicPerformanceRequestFrame *frame);
         void getCandidateScalingM2mMPPOutImages(const ExynosDisplay *display,
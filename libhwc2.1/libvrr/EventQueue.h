@@ -16,12 +16,156 @@
 
 #pragma once
 
-#include <queue>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "interface/Event.h"
 
 namespace android::hardware::graphics::composer {
 
+// Min-heap of VrrControllerEvent ordered by mWhenNs (and by posting order for equal times),
+// indexed by event type so that events of a type can be counted in O(1) and removed in
+// O(log n) each, without draining and rebuilding the whole heap.
+class EventHeap {
+public:
+    bool empty() const { return mHeap.empty(); }
+
+    size_t size() const { return mHeap.size(); }
+
+    const VrrControllerEvent& top() const { return mHeap.front().event; }
+
+    void emplace(const VrrControllerEvent& event) {
+        const uint64_t seq = mNextSeq++;
+        mHeap.push_back({event, seq});
+        mPositions[seq] = mHeap.size() - 1;
+        mSeqsByType[event.mEventType].insert(seq);
+        siftUp(mHeap.size() - 1);
+    }
+
+    void pop() { removeAt(0); }
+
+    void clear() {
+        mHeap.clear();
+        mPositions.clear();
+        mSeqsByType.clear();
+    }
+
+    size_t count(VrrControllerEventType type) const {
+        const auto it = mSeqsByType.find(type);
+        return (it != mSeqsByType.end()) ? it->second.size() : 0;
+    }
+
+    // Removes all events of exactly |type|.
+    size_t erase(VrrControllerEventType type) {
+        const auto it = mSeqsByType.find(type);
+        if (it == mSeqsByType.end()) {
+            return 0;
+        }
+        const std::vector<uint64_t> seqs(it->second.begin(), it->second.end());
+        for (const auto seq : seqs) {
+            removeAt(mPositions.at(seq));
+        }
+        return seqs.size();
+    }
+
+    // Removes all events whose type satisfies |pred|, |pred| is evaluated once per type.
+    template <typename Predicate>
+    size_t eraseTypesIf(Predicate pred) {
+        std::vector<VrrControllerEventType> types;
+        for (const auto& [type, seqs] : mSeqsByType) {
+            if (pred(type)) {
+                types.push_back(type);
+            }
+        }
+        size_t res = 0;
+        for (const auto type : types) {
+            res += erase(type);
+        }
+        return res;
+    }
+
+    // Returns the events in the order they will be popped.
+    std::vector<VrrControllerEvent> sortedEvents() const {
+        std::vector<Node> nodes(mHeap);
+        std::sort(nodes.begin(), nodes.end(),
+                  [](const Node& a, const Node& b) { return isEarlier(a, b); });
+        std::vector<VrrControllerEvent> events;
+        events.reserve(nodes.size());
+        for (auto& node : nodes) {
+            events.emplace_back(std::move(node.event));
+        }
+        return events;
+    }
+
+private:
+    struct Node {
+        VrrControllerEvent event;
+        uint64_t seq;
+    };
+
+    static bool isEarlier(const Node& a, const Node& b) {
+        return (a.event.mWhenNs != b.event.mWhenNs) ? (a.event.mWhenNs < b.event.mWhenNs)
+                                                    : (a.seq < b.seq);
+    }
+
+    void swapNodes(size_t i, size_t j) {
+        std::swap(mHeap[i], mHeap[j]);
+        mPositions[mHeap[i].seq] = i;
+        mPositions[mHeap[j].seq] = j;
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0) {
+            const size_t parent = (i - 1) / 2;
+            if (!isEarlier(mHeap[i], mHeap[parent])) break;
+            swapNodes(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(size_t i) {
+        const size_t n = mHeap.size();
+        while (true) {
+            size_t earliest = i;
+            const size_t left = 2 * i + 1;
+            const size_t right = left + 1;
+            if (left < n && isEarlier(mHeap[left], mHeap[earliest])) earliest = left;
+            if (right < n && isEarlier(mHeap[right], mHeap[earliest])) earliest = right;
+            if (earliest == i) break;
+            swapNodes(i, earliest);
+            i = earliest;
+        }
+    }
+
+    void removeAt(size_t i) {
+        const Node& node = mHeap[i];
+        auto typeIt = mSeqsByType.find(node.event.mEventType);
+        typeIt->second.erase(node.seq);
+        if (typeIt->second.empty()) {
+            mSeqsByType.erase(typeIt);
+        }
+        mPositions.erase(node.seq);
+
+        const size_t last = mHeap.size() - 1;
+        if (i != last) {
+            mHeap[i] = std::move(mHeap[last]);
+            mPositions[mHeap[i].seq] = i;
+        }
+        mHeap.pop_back();
+        if (i < mHeap.size()) {
+            siftDown(i);
+            siftUp(i);
+        }
+    }
+
+    std::vector<Node> mHeap;
+    std::unordered_map<uint64_t, size_t> mPositions;
+    std::unordered_map<VrrControllerEventType, std::unordered_set<uint64_t>> mSeqsByType;
+    uint64_t mNextSeq = 0;
+};
+
 struct EventQueue {
 public:
     EventQueue() = default;
@@ -42,36 +186,15 @@ public:
         mPriorityQueue.emplace(event);
     }
 
-    void dropEvent() { mPriorityQueue = std::priority_queue<VrrControllerEvent>(); }
+    void dropEvent() { mPriorityQueue.clear(); }
 
-    void dropEvent(VrrControllerEventType event_type) {
-        std::priority_queue<VrrControllerEvent> q;
-        while (!mPriorityQueue.empty()) {
-            const auto& it = mPriorityQueue.top();
-            if (it.mEventType != event_type) {
-                q.push(it);
-            }
-            mPriorityQueue.pop();
-        }
-        mPriorityQueue = std::move(q);
-    }
+    void dropEvent(VrrControllerEventType event_type) { mPriorityQueue.erase(event_type); }
 
     size_t getNumberOfEvents(VrrControllerEventType eventType) {
-        size_t res = 0;
-        std::priority_queue<VrrControllerEvent> q;
-        while (!mPriorityQueue.empty()) {
-            const auto& it = mPriorityQueue.top();
-            if (it.mEventType == eventType) {
-                ++res;
-            }
-            q.push(it);
-            mPriorityQueue.pop();
-        }
-        mPriorityQueue = std::move(q);
-        return res;
+        return mPriorityQueue.count(eventType);
     }
 
-    std::priority_queue<VrrControllerEvent> mPriorityQueue;
+    EventHeap mPriorityQueue;
 };
 
 } // namespace android::hardware::graphics::composer
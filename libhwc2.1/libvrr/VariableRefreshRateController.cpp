@@ -233,7 +233,7 @@ void VariableRefreshRateController::reset() {
     ATRACE_CALL();
 
     const std::lock_guard<std::mutex> lock(mMutex);
-    mEventQueue.mPriorityQueue = std::priority_queue<VrrControllerEvent>();
+    mEventQueue.mPriorityQueue.clear();
     mRecord.clear();
     dropEventLocked();
     if (mLastPresentFence.has_value()) {
@@ -761,20 +761,14 @@ void VariableRefreshRateController::cancelPresentTimeoutHandlingLocked() {
 }
 
 void VariableRefreshRateController::dropEventLocked() {
-    mEventQueue.mPriorityQueue = std::priority_queue<VrrControllerEvent>();
+    mEventQueue.mPriorityQueue.clear();
 }
 
 void VariableRefreshRateController::dropEventLocked(VrrControllerEventType eventType) {
-    std::priority_queue<VrrControllerEvent> q;
     auto target = static_cast<int>(eventType);
-    while (!mEventQueue.mPriorityQueue.empty()) {
-        const auto& it = mEventQueue.mPriorityQueue.top();
-        if ((static_cast<int>(it.mEventType) & target) != target) {
-            q.push(it);
-        }
-        mEventQueue.mPriorityQueue.pop();
-    }
-    mEventQueue.mPriorityQueue = std::move(q);
+    mEventQueue.mPriorityQueue.eraseTypesIf([target](VrrControllerEventType type) {
+        return (static_cast<int>(type) & target) == target;
+    });
 }
 
 std::string VariableRefreshRateController::dumpEventQueueLocked() {
@@ -783,16 +777,11 @@ std::string VariableRefreshRateController::dumpEventQueueLocked() {
         return content;
     }
 
-    std::priority_queue<VrrControllerEvent> q;
-    while (!mEventQueue.mPriorityQueue.empty()) {
-        const auto& it = mEventQueue.mPriorityQueue.top();
+    for (const auto& event : mEventQueue.mPriorityQueue.sortedEvents()) {
         content += "VrrController: event = ";
-        content += it.toString();
+        content += event.toString();
         content += "\n";
-        q.push(it);
-        mEventQueue.mPriorityQueue.pop();
     }
-    mEventQueue.mPriorityQueue = std::move(q);
     return content;
 }
 
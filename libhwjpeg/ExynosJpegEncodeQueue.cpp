@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ExynosJpegEncodeQueue.h>
+#include <log/log.h>
+
+ExynosJpegEncodeQueue::ExynosJpegEncodeQueue(Callback callback, unsigned int depth)
+      : mCallback(std::move(callback)) {
+    if (depth == 0) depth = 1;
+
+    for (unsigned int i = 0; i < depth; i++) {
+        std::unique_ptr<ExynosJpegEncoderForCamera> encoder(new ExynosJpegEncoderForCamera());
+        if (encoder->create() < 0) {
+            ALOGE("Failed to create the encoder of slot %u", i);
+            mAvailable = false;
+            return;
+        }
+        mEncoders.push_back(std::move(encoder));
+    }
+
+    for (auto& encoder : mEncoders)
+        mWorkers.emplace_back(&ExynosJpegEncodeQueue::workerLoop, this, encoder.get());
+
+    ALOGD("Created JPEG encode queue with %u slots", depth);
+}
+
+ExynosJpegEncodeQueue::~ExynosJpegEncodeQueue() {
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExiting = true;
+    }
+    mRequestCond.notify_all();
+
+    for (auto& worker : mWorkers) worker.join();
+}
+
+bool ExynosJpegEncodeQueue::submit(const Request& request) {
+    if (!mAvailable) {
+        ALOGE("JPEG encode queue is not available");
+        return false;
+    }
+
+    if (!request.outBuf || request.outSize <= 0) {
+        ALOGE("Invalid stream buffer %p (%d bytes)", request.outBuf, request.outSize);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRequests.push_back({request, mNextSequence++});
+    }
+    mRequestCond.notify_one();
+
+    return true;
+}
+
+void ExynosJpegEncodeQueue::flush() {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCompletionCond.wait(lock, [this] { return mNextCompletion == mNextSequence; });
+}
+
+int ExynosJpegEncodeQueue::encodeOne(ExynosJpegEncoderForCamera& encoder, const Request& request,
+                                     int* size) {
+    if (encoder.setColorFormat(request.colorFormat) < 0 ||
+        encoder.setJpegFormat(request.jpegFormat) < 0 ||
+        encoder.setSize(request.width, request.height) < 0 ||
+        encoder.setQuality(request.quality) < 0) {
+        ALOGE("Failed to configure %dx%d image of format %#x", request.width, request.height,
+              request.colorFormat);
+        return -1;
+    }
+
+    if (encoder.setThumbnailSize(request.thumbWidth, request.thumbHeight) < 0) return -1;
+
+    if (request.thumbWidth > 0 && encoder.setThumbnailQuality(request.thumbQuality) < 0)
+        return -1;
+
+    int insize[3] = {request.inSize[0], request.inSize[1], request.inSize[2]};
+    int ret;
+    if (request.bufType == JPEG_BUF_TYPE_USER_PTR) {
+        char* inbuf[3] = {request.inBuf[0], request.inBuf[1], request.inBuf[2]};
+        ret = encoder.setInBuf(inbuf, insize);
+    } else {
+        int infd[3] = {request.inFd[0], request.inFd[1], request.inFd[2]};
+        ret = encoder.setInBuf(infd, insize);
+    }
+
+    if (ret < 0) {
+        ALOGE("Failed to configure the image buffers");
+        return -1;
+    }
+
+    char* outbuf = request.outBuf;
+    *size = request.outSize;
+
+    return encoder.encode(size, request.exif, request.outFd, &outbuf, request.debug);
+}
+
+void ExynosJpegEncodeQueue::workerLoop(ExynosJpegEncoderForCamera* encoder) {
+    std::unique_lock<std::mutex> lock(mLock);
+
+    while (true) {
+        mRequestCond.wait(lock, [this] { return mExiting || !mRequests.empty(); });
+        if (mRequests.empty()) break; // exiting
+
+        Entry entry = std::move(mRequests.front());
+        mRequests.pop_front();
+
+        lock.unlock();
+
+        int size = 0;
+        int status = encodeOne(*encoder, entry.request, &size);
+        if (status < 0) {
+            ALOGE("Failed to compress request #%llu",
+                  static_cast<unsigned long long>(entry.sequence));
+            size = 0;
+        }
+
+        lock.lock();
+
+        // Completions are reported in the order of submission
+        mCompletionCond.wait(lock, [this, &entry] { return mNextCompletion == entry.sequence; });
+
+        lock.unlock();
+        if (mCallback) mCallback(entry.request, status, size);
+        lock.lock();
+
+        mNextCompletion++;
+        mCompletionCond.notify_all();
+    }
+}
@@ -136,40 +136,47 @@ int ExynosJpegEncoder::setOutBuf(char *pcBuf, int iSize) {
     return 0;
 }
 
-int ExynosJpegEncoder::setJpegFormat(int iV4l2JpegFormat) {
-    if (m_jpegFormat == iV4l2JpegFormat) return 0;
-
-    unsigned int hfactor, vfactor;
+bool ExynosJpegEncoder::GetChromaSampFactor(int iV4l2JpegFormat, unsigned int *hfactor,
+                                            unsigned int *vfactor) {
     switch (iV4l2JpegFormat) {
         case V4L2_PIX_FMT_JPEG_444:
-            hfactor = 1;
-            vfactor = 1;
+            *hfactor = 1;
+            *vfactor = 1;
             break;
         case V4L2_PIX_FMT_JPEG_422:
-            hfactor = 2;
-            vfactor = 1;
+            *hfactor = 2;
+            *vfactor = 1;
             break;
         case V4L2_PIX_FMT_JPEG_420:
-            hfactor = 2;
-            vfactor = 2;
+            *hfactor = 2;
+            *vfactor = 2;
             break;
         case V4L2_PIX_FMT_JPEG_GRAY:
-            hfactor = 0;
-            vfactor = 0;
+            *hfactor = 0;
+            *vfactor = 0;
             break;
         case V4L2_PIX_FMT_JPEG_422V:
-            hfactor = 1;
-            vfactor = 2;
+            *hfactor = 1;
+            *vfactor = 2;
             break;
         case V4L2_PIX_FMT_JPEG_411:
-            hfactor = 4;
-            vfactor = 1;
+            *hfactor = 4;
+            *vfactor = 1;
             break;
         default:
             ALOGE("Unknown JPEG format `%08Xh", iV4l2JpegFormat);
-            return -1;
+            return false;
     }
 
+    return true;
+}
+
+int ExynosJpegEncoder::setJpegFormat(int iV4l2JpegFormat) {
+    if (m_jpegFormat == iV4l2JpegFormat) return 0;
+
+    unsigned int hfactor, vfactor;
+    if (!GetChromaSampFactor(iV4l2JpegFormat, &hfactor, &vfactor)) return -1;
+
     if (!m_hwjpeg.SetChromaSampFactor(hfactor, vfactor)) return -1;
 
     m_jpegFormat = iV4l2JpegFormat;
@@ -198,9 +205,16 @@ bool ExynosJpegEncoder::__EnsureFormatIsApplied() {
 }
 
 int ExynosJpegEncoder::setQuality(const unsigned char q_table[]) {
-    return m_hwjpeg.SetQuality(q_table) ? 0 : -1;
+    if (!m_hwjpeg.SetQuality(q_table)) return -1;
+
+    // The next setQuality(iQuality) should replace the tables
+    m_nQFactor = 0;
+    return 0;
 }
 
 int ExynosJpegEncoder::setPadding(const unsigned char *padding, unsigned int num_planes) {
-    return m_hwjpeg.SetPadding(padding, num_planes) ? 0 : -1;
+    if (!m_hwjpeg.SetPadding(padding, num_planes)) return -1;
+
+    for (unsigned int i = 0; i < 3; i++) m_Padding[i] = (i < num_planes) ? padding[i] : 0;
+    return 0;
 }
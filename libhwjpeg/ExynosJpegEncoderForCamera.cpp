@@ -16,12 +16,15 @@
  */
 
 #include <ExynosJpegEncoderForCamera.h>
+#include <cutils/properties.h>
 #include <hardware/exynos/ion.h>
 #include <linux/videodev2.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <system/graphics.h>
 
+#include <atomic>
+
 #include "AppMarkerWriter.h"
 #include "ThumbnailScaler.h"
 #include "hwjpeg-internal.h"
@@ -29,6 +32,9 @@
 // Data length written by H/W without the scan data.
 #define NECESSARY_JPEG_LENGTH (0x24B + 2 * JPEG_MARKER_SIZE)
 
+// Number of the blocking compressions of the main images on HWJPEG in this process
+static std::atomic<int> sHWJpegCompressions(0);
+
 static size_t GetImageLength(unsigned int width, unsigned int height, int v4l2Format) {
     size_t size = width * height;
 
@@ -81,7 +87,25 @@ ExynosJpegEncoderForCamera::ExynosJpegEncoderForCamera(bool bBTBComp)
         return;
     }
 
-    m_phwjpeg4thumb = new CHWJpegV4L2Compressor();
+    // The thumbnail is compressed by CPU if HWJPEG is not available for it
+    // or if it is configured to leave HWJPEG to the main image.
+    char value[PROPERTY_VALUE_MAX];
+    property_get("vendor.hwjpeg.thumbnail_compressor", value, "");
+    if (strcmp(value, "sw")) {
+        m_phwjpeg4thumb = new CHWJpegV4L2Compressor();
+        if (m_phwjpeg4thumb && !m_phwjpeg4thumb->Okay()) {
+            ALOGW("HWJPEG is not available for thumbnail. Falling back to software compressor");
+            delete m_phwjpeg4thumb;
+            m_phwjpeg4thumb = NULL;
+        }
+    }
+
+    if (!m_phwjpeg4thumb) m_phwjpeg4thumb = new CHWJpegSWCompressor();
+
+    // The main image is compressed by CPU instead of waiting for HWJPEG that is
+    // compressing the image of another encoder in this process.
+    m_bMainOverflowToCPU = property_get_bool("vendor.hwjpeg.main_overflow_to_cpu", false);
+
     if (!m_phwjpeg4thumb) {
         ALOGE("Failed to create thumbnail compressor!");
         return;
@@ -422,7 +446,21 @@ int ExynosJpegEncoderForCamera::encode(int* size, exif_attribute_t* exifInfo, in
         return -1;
     }
 
-    ssize_t mainlen = GetCompressor().Compress(&thumblen, block_mode);
+    ssize_t mainlen = -1;
+    bool cpu = IsMainOverflowAllowed(block_mode, thumbenc) && (sHWJpegCompressions > 0);
+    if (cpu) {
+        mainlen = CompressMainImageOnCPU(buffsize);
+        if (mainlen < 0) {
+            ALOGW("Failed to compress the main image by CPU. Waiting for HWJPEG");
+            cpu = false;
+        }
+    }
+
+    if (!cpu) {
+        sHWJpegCompressions++;
+        mainlen = GetCompressor().Compress(&thumblen, block_mode);
+        sHWJpegCompressions--;
+    }
     if (mainlen < 0) {
         ALOGE("Error occured while JPEG compression: %zd", mainlen);
         return -1;
@@ -436,11 +474,54 @@ int ExynosJpegEncoderForCamera::encode(int* size, exif_attribute_t* exifInfo, in
     *size = static_cast<int>(FinishCompression(mainlen, thumblen));
     if (*size < 0) return -1;
 
-    ALOGD("....compression delay(usec.): HW %u, Total %lu)", GetHWDelay(), stopwatch.GetElapsed());
+    if (cpu)
+        ALOGD("....compression delay(usec.): CPU, Total %lu)", stopwatch.GetElapsed());
+    else
+        ALOGD("....compression delay(usec.): HW %u, Total %lu)", GetHWDelay(),
+              stopwatch.GetElapsed());
 
     return 0;
 }
 
+ssize_t ExynosJpegEncoderForCamera::CompressMainImageOnCPU(size_t buffsize) {
+    int width = 0;
+    int height = 0;
+    unsigned int hfactor, vfactor;
+    getSize(&width, &height);
+    if ((getQuality() == 0) || !GetChromaSampFactor(getJpegFormat(), &hfactor, &vfactor))
+        return -1;
+
+    if (!m_pswjpeg4main) m_pswjpeg4main.reset(new CHWJpegSWCompressor());
+    CHWJpegSWCompressor& swjpeg = *m_pswjpeg4main;
+
+    if (!swjpeg.SetImageFormat(getColorFormat(), width, height) ||
+        !swjpeg.SetChromaSampFactor(hfactor, vfactor) || !swjpeg.SetQuality(getQuality()) ||
+        !swjpeg.SetPadding(getPadding(), 3))
+        return -1;
+
+    // The image buffers are the ones configured to HWJPEG by setInBuf()
+    CHWJpegCompressor& hwjpeg = GetCompressor();
+    size_t len[3];
+    unsigned int num_buffers = 3;
+    if (!hwjpeg.GetImageBufferSizes(len, &num_buffers)) return -1;
+
+    if (checkInBufType() == JPEG_BUF_TYPE_DMA_BUF) {
+        int buffers[3];
+        if (!hwjpeg.GetImageBuffers(buffers, len, num_buffers) ||
+            !swjpeg.SetImageBuffer(buffers, len, num_buffers))
+            return -1;
+    } else {
+        char* buffers[3];
+        if (!hwjpeg.GetImageBuffers(buffers, len, num_buffers) ||
+            !swjpeg.SetImageBuffer(buffers, len, num_buffers))
+            return -1;
+    }
+
+    if (!swjpeg.SetJpegBuffer(m_pAppWriter->GetMainStreamBase(), buffsize)) return -1;
+
+    return swjpeg.Compress();
+}
+
 ssize_t ExynosJpegEncoderForCamera::FinishCompression(size_t mainlen, size_t thumblen) {
     bool btb = false;
     size_t max_streamsize = m_nStreamSize;
@@ -568,13 +649,28 @@ bool ExynosJpegEncoderForCamera::GenerateThumbnailImage() {
         return false;
     }
 
-    if (!mThumbnailScaler->SetSrcImage(main_width, main_height, v4l2Format)) {
+    if (RunThumbnailScaler(*mThumbnailScaler, main_width, main_height)) return true;
+
+    if (mThumbnailScaler->isSoftware()) return false;
+
+    ALOGW("Retrying thumbnail conversion with the software scaler");
+
+    if (!mFallbackThumbnailScaler)
+        mFallbackThumbnailScaler.reset(ThumbnailScaler::createSoftwareInstance());
+
+    return RunThumbnailScaler(*mFallbackThumbnailScaler, main_width, main_height);
+}
+
+bool ExynosJpegEncoderForCamera::RunThumbnailScaler(ThumbnailScaler& scaler, int main_width,
+                                                    int main_height) {
+    int v4l2Format = getColorFormat();
+
+    if (!scaler.SetSrcImage(main_width, main_height, v4l2Format)) {
         ALOGE("Failed to configure the main image to the thumbnail scaler");
         return false;
     }
 
-    if (!mThumbnailScaler->SetDstImage(m_nThumbWidth, m_nThumbHeight,
-                                       GetThumbnailFormat(v4l2Format))) {
+    if (!scaler.SetDstImage(m_nThumbWidth, m_nThumbHeight, GetThumbnailFormat(v4l2Format))) {
         ALOGE("Failed to configure the target image to the thumbnail scaler");
         return false;
     }
@@ -590,8 +686,7 @@ bool ExynosJpegEncoderForCamera::GenerateThumbnailImage() {
             return false;
         }
 
-        okay = mThumbnailScaler->RunStream(bufs, len_srcbufs, m_fdIONThumbImgBuffer,
-                                           m_szIONThumbImgBuffer);
+        okay = scaler.RunStream(bufs, len_srcbufs, m_fdIONThumbImgBuffer, m_szIONThumbImgBuffer);
     } else { // mainbuftype == JPEG_BUF_TYPE_DMA_BUF
         int bufs[ThumbnailScaler::SCALER_MAX_PLANES];
         int len_srcbufs[ThumbnailScaler::SCALER_MAX_PLANES];
@@ -600,8 +695,7 @@ bool ExynosJpegEncoderForCamera::GenerateThumbnailImage() {
             ALOGE("Failed to retrieve the main image buffers");
             return false;
         }
-        okay = mThumbnailScaler->RunStream(bufs, len_srcbufs, m_fdIONThumbImgBuffer,
-                                           m_szIONThumbImgBuffer);
+        okay = scaler.RunStream(bufs, len_srcbufs, m_fdIONThumbImgBuffer, m_szIONThumbImgBuffer);
     }
 
     if (!okay) {
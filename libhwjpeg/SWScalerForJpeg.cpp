@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SWScalerForJpeg.h"
+
+#include <linux/dma-buf.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "hwjpeg-internal.h"
+
+static bool isYUV420(unsigned int format) {
+    return format == V4L2_PIX_FMT_NV12 || format == V4L2_PIX_FMT_NV21 ||
+            format == V4L2_PIX_FMT_NV12M || format == V4L2_PIX_FMT_NV21M;
+}
+
+static bool isCrCb(unsigned int format) {
+    return format == V4L2_PIX_FMT_NV21 || format == V4L2_PIX_FMT_NV21M;
+}
+
+static void syncDmabuf(int fd, uint64_t flags) {
+    dma_buf_sync sync{flags};
+
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) ALOGERR("failed to sync dmabuf fd %d", fd);
+}
+
+bool SWScalerForJpeg::Image::set(unsigned int w, unsigned int h, unsigned int f) {
+    if (isYUV420(f)) {
+        if ((w | h) & 1) {
+            ALOGE("Odd size %ux%u of YUV420 is not supported", w, h);
+            return false;
+        }
+    } else if (f == V4L2_PIX_FMT_YUYV) {
+        if (w & 1) {
+            ALOGE("Odd width %u of YUV422 is not supported", w);
+            return false;
+        }
+    } else {
+        ALOGE("Format h'%x is not supported by the software thumbnail scaler", f);
+        return false;
+    }
+
+    if (w == 0 || h == 0) {
+        ALOGE("Invalid image size %ux%u", w, h);
+        return false;
+    }
+
+    width = w;
+    height = h;
+    format = f;
+
+    return true;
+}
+
+unsigned int SWScalerForJpeg::Image::numPlanes() const {
+    return (format == V4L2_PIX_FMT_NV12M || format == V4L2_PIX_FMT_NV21M) ? 2 : 1;
+}
+
+size_t SWScalerForJpeg::Image::planeSize(unsigned int plane) const {
+    size_t luma = width * height;
+
+    if (format == V4L2_PIX_FMT_YUYV) return (plane == 0) ? luma * 2 : 0;
+
+    if (numPlanes() == 1) return (plane == 0) ? luma + luma / 2 : 0;
+
+    return (plane == 0) ? luma : (plane == 1) ? luma / 2 : 0;
+}
+
+// Each target pixel is the rounded average of the source pixels it covers. The rows covered by
+// a target row are summed first over the whole row which is a plain widening add for NEON/SSE.
+void SWScalerForJpeg::averagePlane(const uint8_t *src, unsigned int srcWidth,
+                                   unsigned int srcHeight, uint8_t *dst, unsigned int dstWidth,
+                                   unsigned int dstHeight, unsigned int pixelBytes,
+                                   unsigned int channelOffset, unsigned int channels,
+                                   unsigned int channelStep) {
+    const size_t srcPitch = srcWidth * pixelBytes;
+    const size_t dstPitch = dstWidth * pixelBytes;
+
+    mRowSum.resize(srcPitch);
+
+    for (unsigned int y = 0; y < dstHeight; y++) {
+        unsigned int top = y * srcHeight / dstHeight;
+        unsigned int bottom = std::max(top + 1, (y + 1) * srcHeight / dstHeight);
+        uint32_t *sum = mRowSum.data();
+
+        std::fill(mRowSum.begin(), mRowSum.end(), 0);
+
+        for (unsigned int row = top; row < bottom; row++) {
+            const uint8_t *line = src + row * srcPitch;
+            for (size_t i = 0; i < srcPitch; i++) sum[i] += line[i];
+        }
+
+        uint8_t *out = dst + y * dstPitch + channelOffset;
+
+        for (unsigned int x = 0; x < dstWidth; x++, out += pixelBytes) {
+            unsigned int left = x * srcWidth / dstWidth;
+            unsigned int right = std::max(left + 1, (x + 1) * srcWidth / dstWidth);
+            uint32_t area = (right - left) * (bottom - top);
+            const uint32_t *in = sum + left * pixelBytes + channelOffset;
+
+            for (unsigned int c = 0; c < channels; c++) {
+                uint32_t total = 0;
+                for (unsigned int i = 0; i < right - left; i++)
+                    total += in[i * pixelBytes + c * channelStep];
+                out[c * channelStep] = static_cast<uint8_t>((total + area / 2) / area);
+            }
+        }
+    }
+}
+
+bool SWScalerForJpeg::scale(char *src[SCALER_MAX_PLANES], size_t srcLen[SCALER_MAX_PLANES],
+                            int dstBuf, size_t dstLen) {
+    if (isYUV420(mSrcImage.format) != isYUV420(mDstImage.format) ||
+        isCrCb(mSrcImage.format) != isCrCb(mDstImage.format)) {
+        ALOGE("Unable to convert format h'%x to h'%x", mSrcImage.format, mDstImage.format);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < mSrcImage.numPlanes(); i++) {
+        if (srcLen[i] < mSrcImage.planeSize(i)) {
+            ALOGE("Too small source plane %u: %zu < %zu", i, srcLen[i], mSrcImage.planeSize(i));
+            return false;
+        }
+    }
+
+    size_t dstSize = mDstImage.planeSize(0) + mDstImage.planeSize(1);
+    if (dstLen < dstSize) {
+        ALOGE("Too small target buffer: %zu < %zu", dstLen, dstSize);
+        return false;
+    }
+
+    char *dst = reinterpret_cast<char *>(
+            mmap(NULL, dstSize, PROT_READ | PROT_WRITE, MAP_SHARED, dstBuf, 0));
+    if (dst == MAP_FAILED) {
+        ALOGERR("Failed to map the target buffer fd %d", dstBuf);
+        return false;
+    }
+
+    syncDmabuf(dstBuf, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+
+    const uint8_t *sy = reinterpret_cast<const uint8_t *>(src[0]);
+    uint8_t *dy = reinterpret_cast<uint8_t *>(dst);
+
+    if (mSrcImage.format == V4L2_PIX_FMT_YUYV) {
+        averagePlane(sy, mSrcImage.width, mSrcImage.height, dy, mDstImage.width,
+                     mDstImage.height, 2, 0, 1, 0);
+        averagePlane(sy, mSrcImage.width / 2, mSrcImage.height, dy, mDstImage.width / 2,
+                     mDstImage.height, 4, 1, 2, 2);
+    } else {
+        const uint8_t *sc = (mSrcImage.numPlanes() == 2)
+                ? reinterpret_cast<const uint8_t *>(src[1])
+                : sy + mSrcImage.width * mSrcImage.height;
+
+        averagePlane(sy, mSrcImage.width, mSrcImage.height, dy, mDstImage.width,
+                     mDstImage.height, 1, 0, 1, 0);
+        averagePlane(sc, mSrcImage.width / 2, mSrcImage.height / 2,
+                     dy + mDstImage.width * mDstImage.height, mDstImage.width / 2,
+                     mDstImage.height / 2, 2, 0, 2, 1);
+    }
+
+    syncDmabuf(dstBuf, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+    munmap(dst, dstSize);
+
+    return true;
+}
+
+bool SWScalerForJpeg::RunStream(int srcBuf[SCALER_MAX_PLANES], int srcLen[SCALER_MAX_PLANES],
+                                int dstBuf, size_t dstLen) {
+    char *src[SCALER_MAX_PLANES]{};
+    size_t len[SCALER_MAX_PLANES]{};
+    unsigned int mapped;
+    bool okay = false;
+
+    for (mapped = 0; mapped < mSrcImage.numPlanes(); mapped++) {
+        len[mapped] = static_cast<size_t>(srcLen[mapped]);
+        src[mapped] = reinterpret_cast<char *>(
+                mmap(NULL, len[mapped], PROT_READ, MAP_SHARED, srcBuf[mapped], 0));
+        if (src[mapped] == MAP_FAILED) {
+            ALOGERR("Failed to map the source buffer fd %d", srcBuf[mapped]);
+            break;
+        }
+
+        syncDmabuf(srcBuf[mapped], DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+    }
+
+    if (mapped == mSrcImage.numPlanes()) okay = scale(src, len, dstBuf, dstLen);
+
+    while (mapped-- > 0) {
+        syncDmabuf(srcBuf[mapped], DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+        munmap(src[mapped], len[mapped]);
+    }
+
+    return okay;
+}
+
+bool SWScalerForJpeg::RunStream(char *srcBuf[SCALER_MAX_PLANES], int srcLen[SCALER_MAX_PLANES],
+                                int dstBuf, size_t dstLen) {
+    size_t len[SCALER_MAX_PLANES]{};
+
+    for (unsigned int i = 0; i < mSrcImage.numPlanes(); i++)
+        len[i] = static_cast<size_t>(srcLen[i]);
+
+    return scale(srcBuf, len, dstBuf, dstLen);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __HARDWARE_EXYNOS_SWSCALERFORJPEG_H__
+#define __HARDWARE_EXYNOS_SWSCALERFORJPEG_H__
+
+#include <linux/videodev2.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ThumbnailScaler.h"
+
+/*
+ * SWScalerForJpeg - thumbnail scaler on the CPU
+ *
+ * The thumbnail is downscaled by area averaging from NV12, NV21, NV12M,
+ * NV21M or YUYV main images. The source and the target should have the same
+ * chroma subsampling. It does not need any device and it is always available.
+ */
+class SWScalerForJpeg : public ThumbnailScaler {
+public:
+    SWScalerForJpeg() {}
+    ~SWScalerForJpeg() {}
+
+    bool SetSrcImage(unsigned int width, unsigned int height, unsigned int v4l2_format) {
+        return mSrcImage.set(width, height, v4l2_format);
+    }
+
+    bool SetDstImage(unsigned int width, unsigned int height, unsigned int v4l2_format) {
+        return mDstImage.set(width, height, v4l2_format);
+    }
+
+    bool RunStream(int srcBuf[SCALER_MAX_PLANES], int srcLen[SCALER_MAX_PLANES], int dstBuf,
+                   size_t dstLen);
+    bool RunStream(char *srcBuf[SCALER_MAX_PLANES], int srcLen[SCALER_MAX_PLANES], int dstBuf,
+                   size_t dstLen);
+
+    bool available() { return true; }
+    bool isSoftware() { return true; }
+
+private:
+    struct Image {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int format = V4L2_PIX_FMT_YUYV;
+
+        bool set(unsigned int width, unsigned int height, unsigned int format);
+        size_t planeSize(unsigned int plane) const;
+        unsigned int numPlanes() const;
+    };
+
+    bool scale(char *src[SCALER_MAX_PLANES], size_t srcLen[SCALER_MAX_PLANES], int dstBuf,
+               size_t dstLen);
+    void averagePlane(const uint8_t *src, unsigned int srcWidth, unsigned int srcHeight,
+                      uint8_t *dst, unsigned int dstWidth, unsigned int dstHeight,
+                      unsigned int pixelBytes, unsigned int channelOffset, unsigned int channels,
+                      unsigned int channelStep);
+
+    Image mSrcImage;
+    Image mDstImage;
+    std::vector<uint32_t> mRowSum;
+};
+
+#endif //__HARDWARE_EXYNOS_SWSCALERFORJPEG_H__
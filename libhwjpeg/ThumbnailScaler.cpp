@@ -16,11 +16,32 @@
 
 #include "ThumbnailScaler.h"
 
+#include <cutils/properties.h>
 #include <log/log.h>
 
+#include <cstring>
+
 #include "LibScalerForJpeg.h"
+#include "SWScalerForJpeg.h"
 
 ThumbnailScaler *ThumbnailScaler::createInstance() {
+    char value[PROPERTY_VALUE_MAX];
+
+    property_get("vendor.hwjpeg.thumbnail_scaler", value, "");
+    if (!strcmp(value, "sw")) return createSoftwareInstance();
+
+    LibScalerForJpeg *scaler = new LibScalerForJpeg();
+    if (!scaler->available()) {
+        delete scaler;
+        ALOGW("V4L2 Scaler is not available for thumbnail");
+        return createSoftwareInstance();
+    }
+
     ALOGD("Created thumbnail scaler: legacy V4L2 Scaler");
-    return new LibScalerForJpeg();
+    return scaler;
+}
+
+ThumbnailScaler *ThumbnailScaler::createSoftwareInstance() {
+    ALOGD("Created thumbnail scaler: software");
+    return new SWScalerForJpeg();
 }
@@ -17,9 +17,13 @@ public:
     virtual bool RunStream(char *srcBuf[SCALER_MAX_PLANES], int srcLen[SCALER_MAX_PLANES],
                            int dstBuf, size_t dstLen) = 0;
 
+    // The software scaler is selected if vendor.hwjpeg.thumbnail_scaler is "sw" or if the
+    // scaler device is not available.
     static ThumbnailScaler *createInstance();
+    static ThumbnailScaler *createSoftwareInstance();
 
     virtual bool available() { return false; }
+    virtual bool isSoftware() { return false; }
 };
 
 #endif //__HARDWARE_EXYNOS_THUMBNAIL_SCALER_H__
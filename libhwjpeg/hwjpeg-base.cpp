@@ -25,7 +25,11 @@
 
 #include "hwjpeg-internal.h"
 
-CHWJpegBase::CHWJpegBase(const char *path) : m_iFD(-1), m_uiDeviceCaps(0), m_uiAuxFlags(0) {
+CHWJpegBase::CHWJpegBase(const char *path)
+      : m_iFD(-1), m_bNoDevice(path == NULL), m_uiDeviceCaps(0), m_uiAuxFlags(0) {
+    // No device is required if @path is NULL
+    if (!path) return;
+
     m_iFD = open(path, O_RDWR);
     if (m_iFD < 0) ALOGERR("Failed to open '%s'", path);
 }
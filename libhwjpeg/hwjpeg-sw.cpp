@@ -0,0 +1,955 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <exynos-hwjpeg.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "hwjpeg-internal.h"
+
+// Index in the natural order of the k-th coefficient in the zig-zag order
+static const unsigned char sZigzag[64] = {
+        0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Quantization tables in the natural order in Annex K.1 of ITU-T T.81
+static const unsigned char sStdQTable[2][64] = {
+        {
+                16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+                14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+                18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+                49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+        },
+        {
+                17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+                24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+                99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+        },
+};
+
+// Huffman tables in Annex K.3 of ITU-T T.81: the number of codes of each length and the values
+static const unsigned char sDCBits[2][16] = {
+        {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+        {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+};
+
+static const unsigned char sDCValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const unsigned char sACBits[2][16] = {
+        {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d},
+        {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77},
+};
+
+static const unsigned char sACValues[2][162] = {
+        {
+                0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51,
+                0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1,
+                0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18,
+                0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+                0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57,
+                0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+                0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92,
+                0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+                0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+                0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+                0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2,
+                0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+        },
+        {
+                0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07,
+                0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09,
+                0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25,
+                0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38,
+                0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56,
+                0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+                0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+                0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+                0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+                0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6,
+                0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2,
+                0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+        },
+};
+
+// Scale factors of the rows and the columns of the AAN forward DCT
+static const float sAANScale[8] = {
+        1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f,
+};
+
+struct SWJpegHuffman {
+    uint16_t code[256];
+    unsigned char size[256];
+
+    void build(const unsigned char bits[16], const unsigned char values[]) {
+        uint16_t next = 0;
+        unsigned int k = 0;
+
+        for (unsigned int len = 1; len <= 16; len++) {
+            for (unsigned int i = 0; i < bits[len - 1]; i++, k++) {
+                code[values[k]] = next++;
+                size[values[k]] = static_cast<unsigned char>(len);
+            }
+            next <<= 1;
+        }
+    }
+};
+
+struct SWJpegTables {
+    unsigned char qtable[2][64]; // zig-zag order
+    float divisor[2][64];        // natural order, including the scale factors of AAN DCT
+    SWJpegHuffman dc[2];
+    SWJpegHuffman ac[2];
+};
+
+/*
+ * The location of the samples of an image. The Cb and the Cr samples of
+ * (x, y) in the chroma subsampled grid are cb[y * cpitch + x * cstep] and
+ * cr[y * cpitch + x * cstep], respectively.
+ */
+struct SWJpegSource {
+    unsigned int width;
+    unsigned int height;
+    const uint8_t *y;
+    size_t ypitch;
+    unsigned int ystep;
+    const uint8_t *cb;
+    const uint8_t *cr;
+    size_t cpitch;
+    unsigned int cstep;
+    unsigned int hsub; // horizontal chroma subsampling of the source
+    unsigned int vsub; // vertical chroma subsampling of the source
+};
+
+class SWJpegBitWriter {
+    std::vector<uint8_t> &mOut;
+    uint32_t mBits = 0;
+    unsigned int mCount = 0;
+
+public:
+    explicit SWJpegBitWriter(std::vector<uint8_t> &out) : mOut(out) {}
+
+    void put(uint32_t value, unsigned int size) {
+        mBits = (mBits << size) | (value & ((1U << size) - 1));
+        mCount += size;
+        while (mCount >= 8) {
+            mCount -= 8;
+            uint8_t byte = static_cast<uint8_t>(mBits >> mCount);
+            mOut.push_back(byte);
+            if (byte == 0xFF) mOut.push_back(0); // byte stuffing
+        }
+    }
+
+    // Pads the last byte with 1s at the end of the entropy coded segment
+    void flush() {
+        if (mCount > 0) put(0x7F, 8 - mCount);
+    }
+};
+
+static unsigned int BitLength(unsigned int value) {
+    return value ? 32 - __builtin_clz(value) : 0;
+}
+
+static void ForwardDCT(float *data) {
+    for (int pass = 0; pass < 2; pass++) {
+        // rows in the first pass and columns in the second pass
+        const int step = pass ? 8 : 1;
+        const int next = pass ? 1 : 8;
+
+        for (int i = 0; i < 8; i++) {
+            float *d = data + i * next;
+
+            float tmp0 = d[0 * step] + d[7 * step];
+            float tmp7 = d[0 * step] - d[7 * step];
+            float tmp1 = d[1 * step] + d[6 * step];
+            float tmp6 = d[1 * step] - d[6 * step];
+            float tmp2 = d[2 * step] + d[5 * step];
+            float tmp5 = d[2 * step] - d[5 * step];
+            float tmp3 = d[3 * step] + d[4 * step];
+            float tmp4 = d[3 * step] - d[4 * step];
+
+            float tmp10 = tmp0 + tmp3;
+            float tmp13 = tmp0 - tmp3;
+            float tmp11 = tmp1 + tmp2;
+            float tmp12 = tmp1 - tmp2;
+
+            d[0 * step] = tmp10 + tmp11;
+            d[4 * step] = tmp10 - tmp11;
+
+            float z1 = (tmp12 + tmp13) * 0.707106781f;
+            d[2 * step] = tmp13 + z1;
+            d[6 * step] = tmp13 - z1;
+
+            tmp10 = tmp4 + tmp5;
+            tmp11 = tmp5 + tmp6;
+            tmp12 = tmp6 + tmp7;
+
+            float z5 = (tmp10 - tmp12) * 0.382683433f;
+            float z2 = 0.541196100f * tmp10 + z5;
+            float z4 = 1.306562965f * tmp12 + z5;
+            float z3 = tmp11 * 0.707106781f;
+
+            float z11 = tmp7 + z3;
+            float z13 = tmp7 - z3;
+
+            d[5 * step] = z13 + z2;
+            d[3 * step] = z13 - z2;
+            d[1 * step] = z11 + z4;
+            d[7 * step] = z11 - z4;
+        }
+    }
+}
+
+static void EncodeValue(SWJpegBitWriter &writer, const SWJpegHuffman &huff, unsigned int symbol,
+                        int value, unsigned int nbits) {
+    writer.put(huff.code[symbol], huff.size[symbol]);
+    if (nbits) writer.put(static_cast<uint32_t>(value < 0 ? value - 1 : value), nbits);
+}
+
+static void EncodeBlock(SWJpegBitWriter &writer, float *block, const float *divisor,
+                        const SWJpegHuffman &dc, const SWJpegHuffman &ac, int &dcpred) {
+    int coef[64];
+
+    ForwardDCT(block);
+
+    for (int i = 0; i < 64; i++) {
+        float v = block[sZigzag[i]] / divisor[sZigzag[i]];
+        coef[i] = static_cast<int>(v < 0.0f ? v - 0.5f : v + 0.5f);
+    }
+
+    // The Huffman tables have codes of up to 11 bits for the DC differences and
+    // up to 10 bits for the AC coefficients. Small divisors at high quality factors
+    // give values just out of the ranges.
+    for (int i = 1; i < 64; i++)
+        coef[i] = std::max(-1023, std::min(coef[i], 1023));
+
+    // The predictor follows the clamped difference that the decoder sees
+    int diff = std::max(-2047, std::min(coef[0] - dcpred, 2047));
+    dcpred += diff;
+
+    unsigned int nbits = BitLength(static_cast<unsigned int>(std::abs(diff)));
+    EncodeValue(writer, dc, nbits, diff, nbits);
+
+    unsigned int run = 0;
+    for (int i = 1; i < 64; i++) {
+        if (coef[i] == 0) {
+            run++;
+            continue;
+        }
+
+        while (run > 15) {
+            writer.put(ac.code[0xF0], ac.size[0xF0]); // ZRL
+            run -= 16;
+        }
+
+        nbits = BitLength(static_cast<unsigned int>(std::abs(coef[i])));
+        EncodeValue(writer, ac, (run << 4) | nbits, coef[i], nbits);
+        run = 0;
+    }
+
+    if (run > 0) writer.put(ac.code[0x00], ac.size[0x00]); // EOB
+}
+
+/*
+ * Compresses the MCU rows from @first_row to @last_row into an entropy coded
+ * segment in @out. The components are Y, Cb and Cr with the sampling factors
+ * of @hfactor x @vfactor, 1x1 and 1x1, respectively.
+ */
+static void EncodeMCURows(const SWJpegSource &src, const SWJpegTables &tables,
+                          unsigned int hfactor, unsigned int vfactor, unsigned int first_row,
+                          unsigned int last_row, std::vector<uint8_t> &out) {
+    const unsigned int mcu_width = 8 * hfactor;
+    const unsigned int mcu_height = 8 * vfactor;
+    const unsigned int mcus_per_row = (src.width + mcu_width - 1) / mcu_width;
+    const unsigned int row_width = mcus_per_row * mcu_width;
+    // size of the chroma components in the stream
+    const unsigned int cwidth = (src.width + hfactor - 1) / hfactor;
+    const unsigned int cheight = (src.height + vfactor - 1) / vfactor;
+    // size of the chroma samples in the source
+    const unsigned int swidth = (src.width + src.hsub - 1) / src.hsub;
+    const unsigned int sheight = (src.height + src.vsub - 1) / src.vsub;
+
+    std::vector<float> luma(row_width * mcu_height);
+    std::vector<float> chroma[2];
+    chroma[0].resize(mcus_per_row * 64);
+    chroma[1].resize(mcus_per_row * 64);
+
+    SWJpegBitWriter writer(out);
+    int dcpred[3] = {0, 0, 0};
+    float block[64];
+
+    for (unsigned int row = first_row; row < last_row; row++) {
+        // Level shifted samples of the MCU row with the edges replicated
+        for (unsigned int y = 0; y < mcu_height; y++) {
+            unsigned int sy = std::min(row * mcu_height + y, src.height - 1);
+            const uint8_t *line = src.y + sy * src.ypitch;
+            float *dst = &luma[y * row_width];
+
+            for (unsigned int x = 0; x < row_width; x++)
+                dst[x] = static_cast<float>(line[std::min(x, src.width - 1) * src.ystep]) - 128.0f;
+        }
+
+        for (unsigned int y = 0; y < 8; y++) {
+            unsigned int cy = std::min(row * 8 + y, cheight - 1);
+            // the source chroma rows that cover the stream chroma row
+            unsigned int sy0 = std::min(cy * vfactor / src.vsub, sheight - 1);
+            unsigned int sy1 = std::min((cy * vfactor + vfactor - 1) / src.vsub, sheight - 1);
+
+            for (unsigned int x = 0; x < mcus_per_row * 8; x++) {
+                unsigned int cx = std::min(x, cwidth - 1);
+                unsigned int sx0 = std::min(cx * hfactor / src.hsub, swidth - 1);
+                unsigned int sx1 = std::min((cx * hfactor + hfactor - 1) / src.hsub, swidth - 1);
+                unsigned int sum[2] = {0, 0};
+
+                for (unsigned int sy = sy0; sy <= sy1; sy++) {
+                    for (unsigned int sx = sx0; sx <= sx1; sx++) {
+                        size_t offset = sy * src.cpitch + sx * src.cstep;
+                        sum[0] += src.cb[offset];
+                        sum[1] += src.cr[offset];
+                    }
+                }
+
+                float count = static_cast<float>((sy1 - sy0 + 1) * (sx1 - sx0 + 1));
+                chroma[0][y * mcus_per_row * 8 + x] = sum[0] / count - 128.0f;
+                chroma[1][y * mcus_per_row * 8 + x] = sum[1] / count - 128.0f;
+            }
+        }
+
+        for (unsigned int mcu = 0; mcu < mcus_per_row; mcu++) {
+            for (unsigned int by = 0; by < vfactor; by++) {
+                for (unsigned int bx = 0; bx < hfactor; bx++) {
+                    const float *base = &luma[by * 8 * row_width + mcu * mcu_width + bx * 8];
+                    for (unsigned int y = 0; y < 8; y++)
+                        std::copy(base + y * row_width, base + y * row_width + 8, block + y * 8);
+                    EncodeBlock(writer, block, tables.divisor[0], tables.dc[0], tables.ac[0],
+                                dcpred[0]);
+                }
+            }
+
+            for (unsigned int c = 0; c < 2; c++) {
+                const float *base = &chroma[c][mcu * 8];
+                for (unsigned int y = 0; y < 8; y++)
+                    std::copy(base + y * mcus_per_row * 8, base + y * mcus_per_row * 8 + 8,
+                              block + y * 8);
+                EncodeBlock(writer, block, tables.divisor[1], tables.dc[1], tables.ac[1],
+                            dcpred[c + 1]);
+            }
+        }
+    }
+
+    writer.flush();
+}
+
+static void BuildQuantTable(unsigned char qtable[64], const unsigned char base[64],
+                            unsigned int quality) {
+    quality = std::max(1U, std::min(quality, 100U));
+    unsigned int scale = (quality < 50) ? 5000 / quality : 200 - quality * 2;
+
+    for (int i = 0; i < 64; i++) {
+        unsigned int q = (base[sZigzag[i]] * scale + 50) / 100;
+        qtable[i] = static_cast<unsigned char>(std::max(1U, std::min(q, 255U)));
+    }
+}
+
+static void PrepareTables(SWJpegTables &tables, const unsigned char qtables[128]) {
+    for (int t = 0; t < 2; t++) {
+        std::copy(qtables + t * 64, qtables + t * 64 + 64, tables.qtable[t]);
+
+        for (int i = 0; i < 64; i++) {
+            unsigned int n = sZigzag[i];
+            tables.divisor[t][n] = tables.qtable[t][i] * sAANScale[n / 8] * sAANScale[n % 8] * 8.0f;
+        }
+
+        tables.dc[t].build(sDCBits[t], sDCValues);
+        tables.ac[t].build(sACBits[t], sACValues[t]);
+    }
+}
+
+static void PutMarker(std::vector<uint8_t> &out, uint8_t marker, size_t length) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    if (length > 0) {
+        out.push_back(static_cast<uint8_t>(length >> 8));
+        out.push_back(static_cast<uint8_t>(length));
+    }
+}
+
+static void WriteHeaders(std::vector<uint8_t> &out, const SWJpegTables &tables,
+                         unsigned int width, unsigned int height, unsigned int hfactor,
+                         unsigned int vfactor, unsigned int restart_interval) {
+    PutMarker(out, 0xD8, 0); // SOI
+
+    PutMarker(out, 0xDB, 2 + 2 * 65); // DQT
+    for (uint8_t t = 0; t < 2; t++) {
+        out.push_back(t);
+        out.insert(out.end(), tables.qtable[t], tables.qtable[t] + 64);
+    }
+
+    PutMarker(out, 0xC0, 17); // SOF0
+    out.push_back(8);
+    out.push_back(static_cast<uint8_t>(height >> 8));
+    out.push_back(static_cast<uint8_t>(height));
+    out.push_back(static_cast<uint8_t>(width >> 8));
+    out.push_back(static_cast<uint8_t>(width));
+    out.push_back(3);
+    for (uint8_t c = 1; c <= 3; c++) {
+        out.push_back(c);
+        out.push_back(static_cast<uint8_t>((c == 1) ? ((hfactor << 4) | vfactor) : 0x11));
+        out.push_back((c == 1) ? 0 : 1);
+    }
+
+    size_t dht_len = 2;
+    for (int t = 0; t < 2; t++) {
+        dht_len += 17 + sizeof(sDCValues) + 17 + sizeof(sACValues[t]);
+    }
+
+    PutMarker(out, 0xC4, dht_len); // DHT
+    for (uint8_t t = 0; t < 2; t++) {
+        out.push_back(t); // DC table t
+        out.insert(out.end(), sDCBits[t], sDCBits[t] + 16);
+        out.insert(out.end(), sDCValues, sDCValues + sizeof(sDCValues));
+        out.push_back(0x10 | t); // AC table t
+        out.insert(out.end(), sACBits[t], sACBits[t] + 16);
+        out.insert(out.end(), sACValues[t], sACValues[t] + sizeof(sACValues[t]));
+    }
+
+    if (restart_interval > 0) {
+        PutMarker(out, 0xDD, 4); // DRI
+        out.push_back(static_cast<uint8_t>(restart_interval >> 8));
+        out.push_back(static_cast<uint8_t>(restart_interval));
+    }
+
+    PutMarker(out, 0xDA, 12); // SOS
+    out.push_back(3);
+    for (uint8_t c = 1; c <= 3; c++) {
+        out.push_back(c);
+        out.push_back((c == 1) ? 0x00 : 0x11);
+    }
+    out.push_back(0);  // Ss
+    out.push_back(63); // Se
+    out.push_back(0);  // Ah/Al
+}
+
+static bool GetSourceLayout(unsigned int format, bool &multiplanar, unsigned int &hsub,
+                            unsigned int &vsub) {
+    multiplanar = false;
+    hsub = 2;
+
+    switch (format) {
+        case V4L2_PIX_FMT_NV12M:
+        case V4L2_PIX_FMT_NV21M:
+            multiplanar = true;
+            [[fallthrough]];
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_NV21:
+            vsub = 2;
+            return true;
+        case V4L2_PIX_FMT_NV16:
+        case V4L2_PIX_FMT_NV61:
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_YVYU:
+        case V4L2_PIX_FMT_UYVY:
+            vsub = 1;
+            return true;
+    }
+
+    return false;
+}
+
+static bool IsPacked(unsigned int format) {
+    return format == V4L2_PIX_FMT_YUYV || format == V4L2_PIX_FMT_YVYU ||
+            format == V4L2_PIX_FMT_UYVY;
+}
+
+CHWJpegSWCompressor::CHWJpegSWCompressor()
+      : CHWJpegCompressor(NULL),
+        m_uiFormat(V4L2_PIX_FMT_YUYV),
+        m_uiHFactor(2),
+        m_uiVFactor(1),
+        m_bCustomQTable(false),
+        m_nResult(0) {
+    m_uiQuality[0] = 96;
+    m_uiQuality[1] = 0;
+    // CPU has no restriction on the alignment of the buffers
+    SetDeviceCapabilities(V4L2_CAP_EXYNOS_JPEG_NO_STREAMBASE_ALIGN |
+                          V4L2_CAP_EXYNOS_JPEG_NO_IMAGEBASE_ALIGN |
+                          V4L2_CAP_EXYNOS_JPEG_NO_BUFFER_OVERRUN |
+                          V4L2_CAP_EXYNOS_JPEG_DMABUF_OFFSET);
+}
+
+CHWJpegSWCompressor::~CHWJpegSWCompressor() {
+    Release();
+}
+
+bool CHWJpegSWCompressor::SetChromaSampFactor(unsigned int horizontal, unsigned int vertical) {
+    if ((horizontal != 1 && horizontal != 2) || (vertical != 1 && vertical != 2)) {
+        ALOGE("Unsupported chroma subsampling factor %ux%u", horizontal, vertical);
+        return false;
+    }
+
+    m_uiHFactor = horizontal;
+    m_uiVFactor = vertical;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetQuality(unsigned int quality_factor, unsigned int quality_factor2) {
+    if (quality_factor > 100 || quality_factor2 > 100) {
+        ALOGE("Invalid quality factors %u, %u", quality_factor, quality_factor2);
+        return false;
+    }
+
+    // zero means unchanged like HWJPEG
+    if (quality_factor > 0) {
+        m_uiQuality[0] = quality_factor;
+        m_bCustomQTable = false;
+    }
+
+    if (quality_factor2 > 0) m_uiQuality[1] = quality_factor2;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetQuality(const unsigned char qtable[]) {
+    for (int i = 0; i < 128; i++) {
+        if (qtable[i] == 0) {
+            ALOGE("Quantizer %d in the given table is zero", i);
+            return false;
+        }
+    }
+
+    std::copy(qtable, qtable + 128, m_CustomQTable);
+    m_bCustomQTable = true;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetPadding(const unsigned char padding[], unsigned int num_planes) {
+    if (num_planes > 3) {
+        ALOGE("Attempting to set padding for incorrect number of buffers");
+        return false;
+    }
+
+    for (unsigned int i = 0; i < 3; i++) m_Image[0].padding[i] = (i < num_planes) ? padding[i] : 0;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetPadding2(const unsigned char padding[], unsigned int num_planes) {
+    if (num_planes > 3) {
+        ALOGE("Attempting to set padding for incorrect number of buffers");
+        return false;
+    }
+
+    for (unsigned int i = 0; i < 3; i++) m_Image[1].padding[i] = (i < num_planes) ? padding[i] : 0;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetImageFormat(unsigned int v4l2_fmt, unsigned int width,
+                                         unsigned int height, unsigned int sec_width,
+                                         unsigned int sec_height) {
+    bool multiplanar;
+    unsigned int hsub, vsub;
+
+    if (!GetSourceLayout(v4l2_fmt, multiplanar, hsub, vsub)) {
+        ALOGE("Format %#010x is not supported by the software compressor", v4l2_fmt);
+        return false;
+    }
+
+    if (width == 0 || height == 0 || width > 65535 || height > 65535 ||
+        sec_width > 65535 || sec_height > 65535) {
+        ALOGE("Invalid image size %ux%u (secondary %ux%u)", width, height, sec_width, sec_height);
+        return false;
+    }
+
+    if (m_uiFormat != v4l2_fmt || m_Image[0].width != width || m_Image[0].height != height) {
+        m_Image[0].configured = false;
+        m_Image[1].configured = false;
+    }
+
+    m_uiFormat = v4l2_fmt;
+    m_Image[0].width = width;
+    m_Image[0].height = height;
+    m_Image[1].width = sec_width;
+    m_Image[1].height = sec_height;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::GetPlaneSizes(const Image &image, size_t sizes[],
+                                        unsigned int *num_planes) {
+    bool multiplanar;
+    unsigned int hsub, vsub;
+
+    if (!GetSourceLayout(m_uiFormat, multiplanar, hsub, vsub)) return false;
+
+    size_t cwidth = (image.width + 1) / 2 * 2; // Cb and Cr interleaved
+    size_t cheight = (image.height + vsub - 1) / vsub;
+
+    if (IsPacked(m_uiFormat)) {
+        sizes[0] = (cwidth * 2 + image.padding[0]) * image.height;
+        *num_planes = 1;
+    } else if (multiplanar) {
+        sizes[0] = (image.width + image.padding[0]) * image.height;
+        sizes[1] = (cwidth + image.padding[1]) * cheight;
+        *num_planes = 2;
+    } else {
+        size_t pitch = std::max<size_t>(image.width, cwidth) + image.padding[0];
+        sizes[0] = pitch * (image.height + cheight);
+        *num_planes = 1;
+    }
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::GetImageBufferSizes(size_t buf_sizes[], unsigned int *num_buffers) {
+    size_t sizes[3];
+    unsigned int num_planes;
+
+    if (!GetPlaneSizes(m_Image[0], sizes, &num_planes)) return false;
+
+    if (num_buffers) {
+        if (*num_buffers < num_planes) {
+            ALOGE("The size array length %u is smaller than the number of required buffers %u",
+                  *num_buffers, num_planes);
+            return false;
+        }
+
+        *num_buffers = num_planes;
+    }
+
+    if (buf_sizes) std::copy(sizes, sizes + num_planes, buf_sizes);
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetImageBuffers(Image &image, char *buffers[], int fds[],
+                                          size_t len_buffers[], unsigned int num_buffers) {
+    size_t sizes[3];
+    unsigned int num_planes;
+
+    if (!GetPlaneSizes(image, sizes, &num_planes)) return false;
+
+    if (num_buffers < num_planes) {
+        ALOGE("The number of buffers %u is smaller than the required %u", num_buffers, num_planes);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < num_planes; i++) {
+        if (len_buffers[i] < sizes[i]) {
+            ALOGE("The size of the buffer[%u] %zu is smaller than required %zu", i, len_buffers[i],
+                  sizes[i]);
+            return false;
+        }
+
+        image.addr[i] = buffers ? buffers[i] : NULL;
+        image.fd[i] = fds ? fds[i] : -1;
+        image.len[i] = len_buffers[i];
+    }
+
+    image.dmabuf = (fds != NULL);
+    image.configured = true;
+
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetImageBuffer(char *buffers[], size_t len_buffers[],
+                                         unsigned int num_buffers) {
+    return SetImageBuffers(m_Image[0], buffers, NULL, len_buffers, num_buffers);
+}
+
+bool CHWJpegSWCompressor::SetImageBuffer(int buffers[], size_t len_buffers[],
+                                         unsigned int num_buffers) {
+    return SetImageBuffers(m_Image[0], NULL, buffers, len_buffers, num_buffers);
+}
+
+bool CHWJpegSWCompressor::SetImageBuffer2(char *buffers[], size_t len_buffers[],
+                                          unsigned int num_buffers) {
+    if (m_Image[1].width == 0 || m_Image[1].height == 0) {
+        ALOGE("The size of the secondary image is not configured");
+        return false;
+    }
+
+    return SetImageBuffers(m_Image[1], buffers, NULL, len_buffers, num_buffers);
+}
+
+bool CHWJpegSWCompressor::SetImageBuffer2(int buffers[], size_t len_buffers[],
+                                          unsigned int num_buffers) {
+    if (m_Image[1].width == 0 || m_Image[1].height == 0) {
+        ALOGE("The size of the secondary image is not configured");
+        return false;
+    }
+
+    return SetImageBuffers(m_Image[1], NULL, buffers, len_buffers, num_buffers);
+}
+
+bool CHWJpegSWCompressor::SetJpegBuffer(char *buffer, size_t len_buffer) {
+    m_Stream[0] = Stream();
+    m_Stream[0].addr = buffer;
+    m_Stream[0].len = len_buffer;
+    m_Stream[0].configured = true;
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetJpegBuffer(int buffer, size_t len_buffer, int offset) {
+    m_Stream[0] = Stream();
+    m_Stream[0].fd = buffer;
+    m_Stream[0].len = len_buffer;
+    m_Stream[0].offset = offset;
+    m_Stream[0].dmabuf = true;
+    m_Stream[0].configured = true;
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetJpegBuffer2(char *buffer, size_t len_buffer) {
+    m_Stream[1] = Stream();
+    m_Stream[1].addr = buffer;
+    m_Stream[1].len = len_buffer;
+    m_Stream[1].configured = true;
+    return true;
+}
+
+bool CHWJpegSWCompressor::SetJpegBuffer2(int buffer, size_t len_buffer) {
+    m_Stream[1] = Stream();
+    m_Stream[1].fd = buffer;
+    m_Stream[1].len = len_buffer;
+    m_Stream[1].dmabuf = true;
+    m_Stream[1].configured = true;
+    return true;
+}
+
+static void SyncDmabuf(int fd, uint64_t flags) {
+    dma_buf_sync sync{flags};
+
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) ALOGERR("Failed to sync dmabuf fd %d", fd);
+}
+
+ssize_t CHWJpegSWCompressor::CompressImage(unsigned int index) {
+    Image &image = m_Image[index];
+    Stream &stream = m_Stream[index];
+
+    if (!image.configured || !stream.configured) {
+        ALOGE("Buffers of the %s image are not configured", index ? "secondary" : "primary");
+        return -1;
+    }
+
+    size_t sizes[3];
+    unsigned int num_planes;
+    bool multiplanar;
+    unsigned int hsub, vsub;
+
+    GetPlaneSizes(image, sizes, &num_planes);
+    GetSourceLayout(m_uiFormat, multiplanar, hsub, vsub);
+
+    const uint8_t *planes[3] = {NULL, NULL, NULL};
+    ssize_t ret = -1;
+    unsigned int mapped;
+
+    for (mapped = 0; mapped < num_planes; mapped++) {
+        if (!image.dmabuf) {
+            planes[mapped] = reinterpret_cast<const uint8_t *>(image.addr[mapped]);
+            continue;
+        }
+
+        void *addr = mmap(NULL, image.len[mapped], PROT_READ, MAP_SHARED, image.fd[mapped], 0);
+        if (addr == MAP_FAILED) {
+            ALOGERR("Failed to map image buffer fd %d", image.fd[mapped]);
+            break;
+        }
+
+        SyncDmabuf(image.fd[mapped], DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+        planes[mapped] = reinterpret_cast<const uint8_t *>(addr);
+    }
+
+    if (mapped == num_planes) {
+        SWJpegSource src;
+        bool crcb = m_uiFormat == V4L2_PIX_FMT_NV21 || m_uiFormat == V4L2_PIX_FMT_NV21M ||
+                m_uiFormat == V4L2_PIX_FMT_NV61 || m_uiFormat == V4L2_PIX_FMT_YVYU;
+
+        src.width = image.width;
+        src.height = image.height;
+        src.hsub = hsub;
+        src.vsub = vsub;
+
+        if (IsPacked(m_uiFormat)) {
+            // Y and the chroma pairs are interleaved in the order of Y0 C0 Y1 C1 or C0 Y0 C1 Y1
+            bool uyvy = m_uiFormat == V4L2_PIX_FMT_UYVY;
+            const uint8_t *cplane = planes[0] + (uyvy ? 0 : 1);
+
+            src.ypitch = (image.width + 1) / 2 * 4 + image.padding[0];
+            src.ystep = 2;
+            src.y = planes[0] + (uyvy ? 1 : 0);
+            src.cpitch = src.ypitch;
+            src.cstep = 4;
+            src.cb = cplane + (crcb ? 2 : 0);
+            src.cr = cplane + (crcb ? 0 : 2);
+        } else {
+            const uint8_t *cplane;
+
+            src.ystep = 1;
+            src.cstep = 2;
+            src.y = planes[0];
+            if (multiplanar) {
+                src.ypitch = image.width + image.padding[0];
+                src.cpitch = (image.width + 1) / 2 * 2 + image.padding[1];
+                cplane = planes[1];
+            } else {
+                src.ypitch = std::max(image.width, (image.width + 1) / 2 * 2) + image.padding[0];
+                src.cpitch = src.ypitch;
+                cplane = planes[0] + src.ypitch * image.height;
+            }
+            src.cb = cplane + (crcb ? 1 : 0);
+            src.cr = cplane + (crcb ? 0 : 1);
+        }
+
+        unsigned char qtables[128];
+        if (m_bCustomQTable && index == 0) {
+            std::copy(m_CustomQTable, m_CustomQTable + 128, qtables);
+        } else {
+            unsigned int quality = (index && m_uiQuality[1]) ? m_uiQuality[1] : m_uiQuality[0];
+            BuildQuantTable(qtables, sStdQTable[0], quality);
+            BuildQuantTable(qtables + 64, sStdQTable[1], quality);
+        }
+
+        SWJpegTables tables;
+        PrepareTables(tables, qtables);
+
+        // Every band of MCU rows is a restart interval that is compressed by a thread
+        unsigned int mcus_per_row = (image.width + 8 * m_uiHFactor - 1) / (8 * m_uiHFactor);
+        unsigned int mcu_rows = (image.height + 8 * m_uiVFactor - 1) / (8 * m_uiVFactor);
+        unsigned int threads = std::min(std::max(std::thread::hardware_concurrency(), 1U),
+                                        static_cast<unsigned int>(SWJPEG_MAX_THREADS));
+        unsigned int rows_per_band = (mcu_rows + threads - 1) / threads;
+
+        if (mcus_per_row * rows_per_band > 65535) rows_per_band = mcu_rows;
+
+        unsigned int bands = (mcu_rows + rows_per_band - 1) / rows_per_band;
+        std::vector<std::vector<uint8_t>> segments(bands);
+        std::vector<std::thread> workers;
+
+        for (unsigned int i = 1; i < bands; i++)
+            workers.emplace_back(EncodeMCURows, std::cref(src), std::cref(tables), m_uiHFactor,
+                                 m_uiVFactor, i * rows_per_band,
+                                 std::min(mcu_rows, (i + 1) * rows_per_band), std::ref(segments[i]));
+
+        std::vector<uint8_t> out;
+        WriteHeaders(out, tables, image.width, image.height, m_uiHFactor, m_uiVFactor,
+                     (bands > 1) ? mcus_per_row * rows_per_band : 0);
+
+        EncodeMCURows(src, tables, m_uiHFactor, m_uiVFactor, 0, std::min(mcu_rows, rows_per_band),
+                      segments[0]);
+
+        for (auto &worker : workers) worker.join();
+
+        for (unsigned int i = 0; i < bands; i++) {
+            out.insert(out.end(), segments[i].begin(), segments[i].end());
+            if (i + 1 < bands) PutMarker(out, static_cast<uint8_t>(0xD0 + (i & 7)), 0); // RSTn
+        }
+
+        PutMarker(out, 0xD9, 0); // EOI
+
+        size_t limit = stream.len - std::min(stream.len, static_cast<size_t>(stream.offset));
+        if (out.size() > limit) {
+            ALOGE("Too small stream buffer %zu bytes for %zu bytes", limit, out.size());
+        } else if (!stream.dmabuf) {
+            memcpy(stream.addr, out.data(), out.size());
+            ret = static_cast<ssize_t>(out.size());
+        } else {
+            char *addr = reinterpret_cast<char *>(
+                    mmap(NULL, stream.len, PROT_READ | PROT_WRITE, MAP_SHARED, stream.fd, 0));
+            if (addr == MAP_FAILED) {
+                ALOGERR("Failed to map stream buffer fd %d", stream.fd);
+            } else {
+                SyncDmabuf(stream.fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+                memcpy(addr + stream.offset, out.data(), out.size());
+                SyncDmabuf(stream.fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+                munmap(addr, stream.len);
+                ret = static_cast<ssize_t>(out.size());
+            }
+        }
+    }
+
+    if (image.dmabuf) {
+        while (mapped-- > 0) {
+            SyncDmabuf(image.fd[mapped], DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+            munmap(const_cast<uint8_t *>(planes[mapped]), image.len[mapped]);
+        }
+    }
+
+    return ret;
+}
+
+ssize_t CHWJpegSWCompressor::CompressAll() {
+    ssize_t main_size = CompressImage(0);
+    if (main_size < 0) return main_size;
+
+    ssize_t sec_size = 0;
+    if (m_Image[1].width > 0 && m_Image[1].height > 0 && m_Stream[1].configured) {
+        sec_size = CompressImage(1);
+        if (sec_size < 0) return sec_size;
+    }
+
+    SetStreamSize(main_size, sec_size);
+
+    return main_size;
+}
+
+ssize_t CHWJpegSWCompressor::Compress(size_t *secondary_stream_size, bool block_mode) {
+    if (m_Worker.joinable()) {
+        ALOGE("The previous compression is not finished");
+        return -1;
+    }
+
+    if (!block_mode) {
+        m_Worker = std::thread([this] { m_nResult = CompressAll(); });
+        return 0;
+    }
+
+    ssize_t ret = CompressAll();
+    if (ret < 0) return ret;
+
+    return GetStreamSize(secondary_stream_size);
+}
+
+ssize_t CHWJpegSWCompressor::WaitForCompression(size_t *secondary_stream_size) {
+    if (m_Worker.joinable()) {
+        m_Worker.join();
+        if (m_nResult < 0) return m_nResult;
+    }
+
+    return GetStreamSize(secondary_stream_size);
+}
+
+void CHWJpegSWCompressor::Release() {
+    if (m_Worker.joinable()) m_Worker.join();
+
+    m_Image[0].configured = false;
+    m_Image[1].configured = false;
+    m_Stream[0].configured = false;
+    m_Stream[1].configured = false;
+}
@@ -76,6 +76,7 @@ class ExynosJpegEncoder {
     int m_v4l2Format;
     int m_jpegFormat;
     int m_nStreamSize;
+    unsigned char m_Padding[3];
 
     bool __EnsureFormatIsApplied();
 
@@ -97,6 +98,10 @@ protected:
 
     virtual bool EnsureFormatIsApplied() { return __EnsureFormatIsApplied(); }
 
+    static bool GetChromaSampFactor(int iV4l2JpegFormat, unsigned int *hfactor,
+                                    unsigned int *vfactor);
+    const unsigned char *getPadding() { return m_Padding; }
+
 public:
     ExynosJpegEncoder()
           : m_hwjpeg(),
@@ -108,7 +113,8 @@ public:
             m_nHeight(0),
             m_v4l2Format(0),
             m_jpegFormat(0),
-            m_nStreamSize(0) {
+            m_nStreamSize(0),
+            m_Padding{0, 0, 0} {
         /* To detect setInBuf() call without format setting */
         SetState(STATE_SIZE_CHANGED | STATE_PIXFMT_CHANGED);
     }
@@ -158,6 +164,7 @@ public:
     }
 
     int setJpegFormat(int iV4l2JpegFormat);
+    int getJpegFormat(void) { return m_jpegFormat; }
     int getColorFormat(void) { return m_v4l2Format; }
     int setColorFormat(int iV4l2ColorFormat) {
         if (iV4l2ColorFormat != m_v4l2Format) {
@@ -175,6 +182,8 @@ public:
         return 0;
     }
 
+    // 0 if the quantization tables are given by setQuality(q_table)
+    int getQuality(void) { return m_nQFactor; }
     int setQuality(const unsigned char q_table[]);
     int setPadding(const unsigned char *padding, unsigned int num_planes);
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HARDWARE_EXYNOS_JPEG_ENCODE_QUEUE_H__
+#define __HARDWARE_EXYNOS_JPEG_ENCODE_QUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ExynosJpegEncoderForCamera.h"
+
+/*
+ * ExynosJpegEncodeQueue - asynchronous compression of a sequence of captures
+ *
+ * ExynosJpegEncodeQueue accepts capture requests without waiting for the
+ * previous requests to complete. Each of its slots owns an instance of
+ * ExynosJpegEncoderForCamera and a worker thread that runs the whole encode()
+ * of a request. Therefore while HWJPEG compresses the main image of shot N in
+ * a slot, Exif and APP markers are written and the thumbnail is generated for
+ * shot N+1 in another slot.
+ * The completion of the requests is reported to the callback in the order of
+ * submission regardless of the slots that processed them. The callback is
+ * called from a worker thread.
+ * All buffers and the attributes referenced by a request should be valid until
+ * its completion is reported. HWFC is not supported by the queue.
+ */
+class ExynosJpegEncodeQueue {
+public:
+    struct Request {
+        int width = 0;
+        int height = 0;
+        int colorFormat = 0; // V4L2_PIX_FMT_* of the main image
+        int jpegFormat = 0;  // V4L2_PIX_FMT_JPEG_*
+        int quality = 0;
+        int thumbWidth = 0; // no thumbnail if 0
+        int thumbHeight = 0;
+        int thumbQuality = 0;
+
+        int bufType = JPEG_BUF_TYPE_DMA_BUF;
+        int inFd[3] = {-1, -1, -1};                // bufType == JPEG_BUF_TYPE_DMA_BUF
+        char* inBuf[3] = {nullptr, nullptr, nullptr}; // bufType == JPEG_BUF_TYPE_USER_PTR
+        int inSize[3] = {0, 0, 0};
+
+        int outFd = -1; // optional dma-buf of outBuf
+        char* outBuf = nullptr;
+        int outSize = 0;
+
+        exif_attribute_t* exif = nullptr;
+        debug_attribute_t* debug = nullptr;
+
+        void* cookie = nullptr; // not touched by the queue
+    };
+
+    // @status is 0 on success and -1 on failure. @size is the length of the
+    // JPEG stream written to Request::outBuf.
+    using Callback = std::function<void(const Request& request, int status, int size)>;
+
+    ExynosJpegEncodeQueue(Callback callback, unsigned int depth = 2);
+    ~ExynosJpegEncodeQueue();
+
+    // true if all slots are ready to compress
+    bool available() const { return mAvailable; }
+
+    // Queues @request and returns without waiting for it
+    bool submit(const Request& request);
+
+    // Waits until the completion of all the submitted requests is reported
+    void flush();
+
+private:
+    struct Entry {
+        Request request;
+        uint64_t sequence;
+    };
+
+    void workerLoop(ExynosJpegEncoderForCamera* encoder);
+    int encodeOne(ExynosJpegEncoderForCamera& encoder, const Request& request, int* size);
+
+    Callback mCallback;
+    bool mAvailable = true;
+
+    std::vector<std::unique_ptr<ExynosJpegEncoderForCamera>> mEncoders;
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mLock;
+    std::condition_variable mRequestCond;
+    std::condition_variable mCompletionCond;
+    std::deque<Entry> mRequests;
+    uint64_t mNextSequence = 0;     // sequence of the next submission
+    uint64_t mNextCompletion = 0;   // sequence of the next completion to report
+    bool mExiting = false;
+};
+
+#endif //__HARDWARE_EXYNOS_JPEG_ENCODE_QUEUE_H__
@@ -39,6 +39,11 @@ class ExynosJpegEncoderForCamera : public ExynosJpegEncoder {
 
     CHWJpegCompressor* m_phwjpeg4thumb;
     std::unique_ptr<ThumbnailScaler> mThumbnailScaler;
+    // software scaler that retries if mThumbnailScaler is busy or fails
+    std::unique_ptr<ThumbnailScaler> mFallbackThumbnailScaler;
+    // compresses the main image while HWJPEG is busy if m_bMainOverflowToCPU
+    std::unique_ptr<CHWJpegSWCompressor> m_pswjpeg4main;
+    bool m_bMainOverflowToCPU = false;
     int m_fdIONClient;
     int m_fdIONThumbImgBuffer;
     char* m_pIONThumbImgBuffer;
@@ -78,11 +83,13 @@ class ExynosJpegEncoderForCamera : public ExynosJpegEncoder {
     bool AllocThumbBuffer(int v4l2Format); /* For single compression */
     bool AllocThumbJpegBuffer();           /* For BTB compression */
     bool GenerateThumbnailImage();
+    bool RunThumbnailScaler(ThumbnailScaler& scaler, int main_width, int main_height);
     size_t CompressThumbnail();
     size_t CompressThumbnailOnly(size_t limit, int quality, unsigned int v4l2Format,
                                  int src_buftype);
     size_t RemoveTrailingDummies(char* base, size_t len);
     ssize_t FinishCompression(size_t mainlen, size_t thumblen);
+    ssize_t CompressMainImageOnCPU(size_t buffsize);
     bool ProcessExif(char* base, size_t limit, exif_attribute_t* exifInfo, extra_appinfo_t* extra);
     static void* tCompressThumbnail(void* p);
     bool PrepareCompression(bool thumbnail);
@@ -99,6 +106,13 @@ class ExynosJpegEncoderForCamera : public ExynosJpegEncoder {
                 !TestState(STATE_NO_BTBCOMP);
     }
 
+    // IsMainOverflowAllowed - true if the main image can be compressed by CPU. HWFC and
+    //                         the back-to-back compression of the thumbnail need HWJPEG.
+    inline bool IsMainOverflowAllowed(bool block_mode, bool thumbenc) {
+        return m_bMainOverflowToCPU && block_mode &&
+                (!thumbenc || IsThumbGenerationNeeded() || !IsBTBCompressionSupported());
+    }
+
 protected:
     virtual bool EnsureFormatIsApplied();
 
@@ -21,6 +21,7 @@
 #include <linux/videodev2.h>
 
 #include <cstddef> // size_t
+#include <thread>
 
 #if VIDEO_MAX_PLANES < 6
 #error VIDEO_MAX_PLANES should not be smaller than 6
@@ -62,6 +63,7 @@
  */
 class CHWJpegBase {
     int m_iFD;
+    bool m_bNoDevice; // constructed with NULL path
     unsigned int m_uiDeviceCaps;
     /*
      * Auxiliary option flags are implementation specific to derived classes
@@ -94,8 +96,9 @@ public:
      *
      * A user that creates this object *must* test if the object is successfully
      * created because some initialization in the constructor may fail.
+     * An object that needs no device is always ready to use.
      */
-    bool Okay() { return m_iFD >= 0; }
+    bool Okay() { return m_bNoDevice || m_iFD >= 0; }
     operator bool() { return Okay(); }
 
     /*
@@ -648,6 +651,87 @@ public:
     virtual void Release();
 };
 
+/*
+ * CHWJpegSWCompressor - JPEG compression on the CPU
+ *
+ * CHWJpegSWCompressor produces baseline JPEG streams with the quantization
+ * tables of the given quality factors and the typical Huffman tables in the
+ * JPEG standard without any device. Therefore it is able to compress images
+ * while HWJPEG is busy.
+ * The MCU rows of an image are divided into restart intervals and they are
+ * compressed concurrently by up to SWJPEG_MAX_THREADS threads.
+ * The supported image formats are NV12, NV21, NV16, NV61, NV12M, NV21M, YUYV,
+ * YVYU and UYVY. The chroma subsampling of the stream is independent of the
+ * image format.
+ * No device is opened and Okay() is true once an instance is constructed.
+ */
+#define SWJPEG_MAX_THREADS 4
+
+class CHWJpegSWCompressor : public CHWJpegCompressor {
+    struct Image {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned char padding[3] = {0, 0, 0};
+        bool dmabuf = false;
+        bool configured = false;
+        char *addr[3] = {NULL, NULL, NULL};
+        int fd[3] = {-1, -1, -1};
+        size_t len[3] = {0, 0, 0};
+    };
+
+    struct Stream {
+        bool dmabuf = false;
+        bool configured = false;
+        char *addr = NULL;
+        int fd = -1;
+        size_t len = 0;
+        int offset = 0;
+    };
+
+    unsigned int m_uiFormat;
+    unsigned int m_uiHFactor;
+    unsigned int m_uiVFactor;
+    unsigned int m_uiQuality[2];
+    bool m_bCustomQTable;
+    unsigned char m_CustomQTable[128];
+    Image m_Image[2];
+    Stream m_Stream[2];
+
+    std::thread m_Worker;
+    ssize_t m_nResult;
+
+    bool GetPlaneSizes(const Image &image, size_t sizes[], unsigned int *num_planes);
+    bool SetImageBuffers(Image &image, char *buffers[], int fds[], size_t len_buffers[],
+                         unsigned int num_buffers);
+    ssize_t CompressImage(unsigned int index);
+    ssize_t CompressAll();
+
+public:
+    CHWJpegSWCompressor();
+    virtual ~CHWJpegSWCompressor();
+
+    virtual bool SetChromaSampFactor(unsigned int horizontal, unsigned int vertical);
+    virtual bool SetQuality(unsigned int quality_factor, unsigned int quality_factor2 = 0);
+    virtual bool SetQuality(const unsigned char qtable[]);
+    virtual bool SetPadding(const unsigned char padding[], unsigned int num_planes);
+    virtual bool SetPadding2(const unsigned char padding[], unsigned int num_planes);
+
+    virtual bool SetImageFormat(unsigned int v4l2_fmt, unsigned int width, unsigned int height,
+                                unsigned int sec_width = 0, unsigned sec_height = 0);
+    virtual bool GetImageBufferSizes(size_t buf_sizes[], unsigned int *num_bufffers);
+    virtual bool SetImageBuffer(char *buffers[], size_t len_buffers[], unsigned int num_buffers);
+    virtual bool SetImageBuffer(int buffers[], size_t len_buffers[], unsigned int num_buffers);
+    virtual bool SetImageBuffer2(char *buffers[], size_t len_buffers[], unsigned int num_buffers);
+    virtual bool SetImageBuffer2(int buffers[], size_t len_buffers[], unsigned int num_buffers);
+    virtual bool SetJpegBuffer(char *buffer, size_t len_buffer);
+    virtual bool SetJpegBuffer(int buffer, size_t len_buffer, int offset = 0);
+    virtual bool SetJpegBuffer2(char *buffer, size_t len_buffer);
+    virtual bool SetJpegBuffer2(int buffer, size_t len_buffer);
+    virtual ssize_t Compress(size_t *secondary_stream_size = NULL, bool block_mode = true);
+    virtual ssize_t WaitForCompression(size_t *secondary_stream_size = NULL);
+    virtual void Release();
+};
+
 class CHWJpegV4L2Decompressor : public CHWJpegDecompressor, private CHWJpegFlagManager {
     enum {
         HWJPEG_FLAG_OUTPUT_READY = 0x10,  /* the output stream is ready */
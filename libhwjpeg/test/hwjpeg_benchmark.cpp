@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <exynos-hwjpeg.h>
+#include <linux/videodev2.h>
+
+#include <random>
+#include <vector>
+
+// Compresses an NV21 image of the given size into a 4:2:0 stream of quality 95.
+// The iteration time is the latency of a compression and the rate counters are
+// the throughput. With more than one thread, the compressions run concurrently
+// like the overflow of a burst capture. CHWJpegSWCompressor is scalar C++ and
+// splits an image into up to SWJPEG_MAX_THREADS restart intervals.
+template <class Compressor>
+static void BM_Compress(benchmark::State& state) {
+    const unsigned int width = static_cast<unsigned int>(state.range(0));
+    const unsigned int height = static_cast<unsigned int>(state.range(1));
+
+    Compressor jpeg;
+    if (!jpeg.Okay() || !jpeg.SetImageFormat(V4L2_PIX_FMT_NV21, width, height) ||
+        !jpeg.SetChromaSampFactor(2, 2) || !jpeg.SetQuality(95)) {
+        state.SkipWithError("Failed to configure the compressor");
+        return;
+    }
+
+    size_t sizes[3];
+    unsigned int num_planes = 3;
+    if (!jpeg.GetImageBufferSizes(sizes, &num_planes)) {
+        state.SkipWithError("Failed to get the image buffer sizes");
+        return;
+    }
+
+    // Noise is not compressible so the entropy coding is not underestimated
+    std::mt19937 random(width * height);
+    std::vector<std::vector<char>> planes(num_planes);
+    char* buffers[3];
+    size_t image_size = 0;
+    for (unsigned int i = 0; i < num_planes; i++) {
+        planes[i].resize(sizes[i]);
+        for (auto& pixel : planes[i]) pixel = static_cast<char>(random() & 0x3F) + 96;
+        buffers[i] = planes[i].data();
+        image_size += sizes[i];
+    }
+
+    std::vector<char> stream(image_size * 2);
+    if (!jpeg.SetImageBuffer(buffers, sizes, num_planes) ||
+        !jpeg.SetJpegBuffer(stream.data(), stream.size())) {
+        state.SkipWithError("Failed to configure the buffers");
+        return;
+    }
+
+    ssize_t stream_size = 0;
+    for (auto _ : state) {
+        stream_size = jpeg.Compress();
+        if (stream_size <= 0) {
+            state.SkipWithError("Failed to compress");
+            return;
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * image_size);
+    state.counters["MPixels"] =
+            benchmark::Counter(static_cast<double>(state.iterations()) * width * height / 1e6,
+                               benchmark::Counter::kIsRate);
+    state.counters["StreamBytes"] =
+            benchmark::Counter(static_cast<double>(stream_size), benchmark::Counter::kAvgThreads);
+}
+
+static void Resolutions(benchmark::internal::Benchmark* benchmark) {
+    benchmark->Args({320, 240})      // thumbnail
+            ->Args({1280, 720})
+            ->Args({1920, 1080})
+            ->Args({4000, 3000})     // 12MP
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime()
+            ->ThreadRange(1, 2);
+}
+
+BENCHMARK_TEMPLATE(BM_Compress, CHWJpegSWCompressor)->Apply(Resolutions);
+BENCHMARK_TEMPLATE(BM_Compress, CHWJpegV4L2Compressor)->Apply(Resolutions);
+
+BENCHMARK_MAIN();
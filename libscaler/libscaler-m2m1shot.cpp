@@ -269,14 +269,10 @@ bool CScalerM2M1SHOT::RunSWScaling()
         return false;
     }
 
-    if (m_task.op.rotate != 0) {
-        SC_LOGE("Rotation is not allowed for S/W Scaling");
-        return false;
-    }
-
-    SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d",
+    SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d (rot %d)",
             m_task.fmt_out.crop.width, m_task.fmt_out.crop.height,
-            m_task.fmt_cap.crop.width, m_task.fmt_cap.crop.height);
+            m_task.fmt_cap.crop.width, m_task.fmt_cap.crop.height,
+            m_task.op.rotate);
 
     CScalerSW *swsc;
     char *src[3], *dst[3];
@@ -314,6 +310,39 @@ bool CScalerM2M1SHOT::RunSWScaling()
 
             swsc = new CScalerSW_NV12(src[0], src[1], dst[0], dst[1]);
             break;
+        case V4L2_PIX_FMT_NV12M_P010:
+            if (!GetBuffer(m_task.buf_out, src))
+                return false;
+
+            if (!GetBuffer(m_task.buf_cap, dst)) {
+                PutBuffer(m_task.buf_out, src);
+                return false;
+            }
+
+            if (m_task.buf_out.num_planes == 1)
+                src[1] = src[0] + m_task.fmt_out.width * m_task.fmt_out.height * 2;
+
+            if (m_task.buf_cap.num_planes == 1)
+                dst[1] = dst[0] + m_task.fmt_cap.width * m_task.fmt_cap.height * 2;
+
+            swsc = new CScalerSW_P010(src[0], src[1], dst[0], dst[1]);
+            break;
+        case V4L2_PIX_FMT_RGB32:
+        case V4L2_PIX_FMT_BGR32:
+        case V4L2_PIX_FMT_RGB565:
+            if (!GetBuffer(m_task.buf_out, src))
+                return false;
+
+            if (!GetBuffer(m_task.buf_cap, dst)) {
+                PutBuffer(m_task.buf_out, src);
+                return false;
+            }
+
+            if (m_task.fmt_cap.fmt == V4L2_PIX_FMT_RGB565)
+                swsc = new CScalerSW_RGB565(src[0], dst[0]);
+            else
+                swsc = new CScalerSW_RGB32(src[0], dst[0]);
+            break;
         case V4L2_PIX_FMT_UYVY: // TODO: UYVY is not implemented yet.
         default:
             SC_LOGE("Format %x is not supported", m_task.fmt_out.fmt);
@@ -335,6 +364,9 @@ bool CScalerM2M1SHOT::RunSWScaling()
             m_task.fmt_cap.crop.width, m_task.fmt_cap.crop.height,
             m_task.fmt_cap.width);
 
+    swsc->SetRotate(m_task.op.rotate, !!(m_task.op.op & M2M1SHOT_OP_FLIP_HORI),
+            !!(m_task.op.op & M2M1SHOT_OP_FLIP_VIRT));
+
     bool ret = swsc->Scale();
 
     delete swsc;
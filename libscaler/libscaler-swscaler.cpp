@@ -1,5 +1,16 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
 #include "libscaler-swscaler.h"
 
+#define SW_SCALER_MAX_THREADS   4
+// Smallest number of destination rows that is worth a thread
+#define SW_SCALER_MIN_BAND_ROWS 32
+
 void CScalerSW::Clear() {
     m_pSrc[0] = NULL;
     m_pSrc[1] = NULL;
@@ -18,46 +29,353 @@ void CScalerSW::Clear() {
     m_nDstWidth = 0;
     m_nDstHeight = 0;
     m_nDstStride = 0;
+
+    m_nFilter = SW_FILTER_BILINEAR;
+    m_nRotDegree = 0;
+    m_bHFlip = false;
+    m_bVFlip = false;
+
+    m_nThreads = LibScaler::min(std::thread::hardware_concurrency(),
+                                static_cast<unsigned int>(SW_SCALER_MAX_THREADS));
+    if (m_nThreads == 0)
+        m_nThreads = 1;
 }
 
-bool CScalerSW_YUYV::Scale() {
-    if (((m_nSrcLeft | m_nSrcWidth | m_nDstWidth | m_nSrcStride) % 2) != 0) {
-        SC_LOGE("Width of YUV422 should be even");
+bool CScalerSW::SetRotate(int rot, bool hflip, bool vflip) {
+    if ((rot % 90) != 0) {
+        SC_LOGE("Rotation degree %d must be multiple of 90", rot);
         return false;
     }
 
-    unsigned int h_ratio = (m_nSrcWidth << 16) / m_nDstWidth;
-    unsigned int v_ratio = (m_nSrcHeight << 16) / m_nDstHeight;
+    rot = rot % 360;
+    if (rot < 0)
+        rot = 360 + rot;
+
+    m_nRotDegree = rot;
+    m_bHFlip = hflip;
+    m_bVFlip = vflip;
+
+    return true;
+}
+
+/*
+ * Coefficients of a separable filter along one axis. Every output has the
+ * same number of taps so that the inner loops have no data dependent bounds.
+ * The taps at the edges of the source are clamped into the source by shifting
+ * start[] and zero-padding the weights.
+ */
+struct SWFilterTable {
+    unsigned int taps;
+    std::vector<unsigned int> start;
+    std::vector<float> weight;
+};
+
+static float FilterWeight(unsigned int filter, float x)
+{
+    x = fabsf(x);
+
+    if (filter == SW_FILTER_BICUBIC) {
+        // Keys cubic convolution with a = -0.5
+        if (x < 1.0f)
+            return (1.5f * x - 2.5f) * x * x + 1.0f;
+        if (x < 2.0f)
+            return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+        return 0.0f;
+    }
+
+    return (x < 1.0f) ? 1.0f - x : 0.0f;
+}
+
+static void BuildFilterTable(SWFilterTable &table, unsigned int filter,
+                             unsigned int src_size, unsigned int dst_size)
+{
+    table.start.resize(dst_size);
+
+    if (filter == SW_FILTER_NEAREST) {
+        table.taps = 1;
+        table.weight.assign(dst_size, 1.0f);
+        for (unsigned int i = 0; i < dst_size; i++)
+            table.start[i] = LibScaler::min(static_cast<unsigned int>(
+                        ((2ULL * i + 1) * src_size) / (2ULL * dst_size)), src_size - 1);
+        return;
+    }
+
+    float ratio = static_cast<float>(src_size) / dst_size;
+    // The filter is stretched on downscaling to cover all the source pixels
+    float scale = (ratio > 1.0f) ? ratio : 1.0f;
+    float support = ((filter == SW_FILTER_BICUBIC) ? 2.0f : 1.0f) * scale;
+
+    table.taps = LibScaler::min(static_cast<unsigned int>(ceilf(support)) * 2 + 1, src_size);
+    table.weight.assign(dst_size * table.taps, 0.0f);
+
+    for (unsigned int i = 0; i < dst_size; i++) {
+        float center = (i + 0.5f) * ratio;
+        int lo = static_cast<int>(center - support + 0.5f);
+        int hi = static_cast<int>(center + support + 0.5f);
+
+        lo = (lo < 0) ? 0 : lo;
+        hi = (hi > static_cast<int>(src_size)) ? src_size : hi;
+
+        unsigned int start = LibScaler::min(static_cast<unsigned int>(lo), src_size - table.taps);
+        float *weight = &table.weight[i * table.taps];
+        float sum = 0.0f;
+
+        for (int x = lo; x < hi; x++) {
+            float w = FilterWeight(filter, (x + 0.5f - center) / scale);
+            weight[x - start] = w;
+            sum += w;
+        }
+
+        if (sum != 0.0f) {
+            for (unsigned int k = 0; k < table.taps; k++)
+                weight[k] /= sum;
+        } else {
+            weight[LibScaler::min(static_cast<unsigned int>(center), src_size - 1) - start] = 1.0f;
+        }
+
+        table.start[i] = start;
+    }
+}
+
+static void LoadRow(const SWPlaneFormat &fmt, const char *row, unsigned int count, float *out)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(row);
+
+    switch (fmt.sample) {
+    case SW_SAMPLE_U8:
+        for (unsigned int i = 0; i < count; i++, p += fmt.bytes_per_pixel)
+            for (unsigned int c = 0; c < fmt.channels; c++)
+                *out++ = p[c * fmt.channel_step];
+        break;
+    case SW_SAMPLE_P010:
+        for (unsigned int i = 0; i < count; i++, p += fmt.bytes_per_pixel)
+            for (unsigned int c = 0; c < fmt.channels; c++)
+                *out++ = *reinterpret_cast<const uint16_t *>(p + c * fmt.channel_step) >> 6;
+        break;
+    case SW_SAMPLE_RGB565:
+        for (unsigned int i = 0; i < count; i++, p += fmt.bytes_per_pixel) {
+            uint16_t v = *reinterpret_cast<const uint16_t *>(p);
+            *out++ = (v >> 11) & 0x1F;
+            *out++ = (v >> 5) & 0x3F;
+            *out++ = v & 0x1F;
+        }
+        break;
+    }
+}
+
+static inline unsigned int Quantize(float v, unsigned int max)
+{
+    if (v <= 0.0f)
+        return 0;
+    unsigned int q = static_cast<unsigned int>(v + 0.5f);
+    return (q > max) ? max : q;
+}
+
+static void StorePixel(const SWPlaneFormat &fmt, char *pixel, const float *in)
+{
+    switch (fmt.sample) {
+    case SW_SAMPLE_U8:
+        for (unsigned int c = 0; c < fmt.channels; c++)
+            pixel[c * fmt.channel_step] = static_cast<char>(Quantize(in[c], 0xFF));
+        break;
+    case SW_SAMPLE_P010:
+        for (unsigned int c = 0; c < fmt.channels; c++)
+            *reinterpret_cast<uint16_t *>(pixel + c * fmt.channel_step) =
+                static_cast<uint16_t>(Quantize(in[c], 0x3FF) << 6);
+        break;
+    case SW_SAMPLE_RGB565:
+        *reinterpret_cast<uint16_t *>(pixel) = static_cast<uint16_t>(
+                (Quantize(in[0], 0x1F) << 11) | (Quantize(in[1], 0x3F) << 5) | Quantize(in[2], 0x1F));
+        break;
+    }
+}
+
+struct SWScaleJob {
+    const SWPlaneFormat *fmt;
+    const char *src;        // the top-left pixel of the source rectangle
+    size_t src_pitch;
+    unsigned int src_width;
+    SWFilterTable htab;
+    SWFilterTable vtab;
+    char *dst;              // the destination pixel of the first pixel of the first row
+    ptrdiff_t dst_row_step; // distance of the adjacent rows in the destination
+    ptrdiff_t dst_col_step; // distance of the adjacent pixels of a row in the destination
+    unsigned int width;     // width of the scaled image before rotation
+};
+
+template <unsigned int CH>
+static void FilterRowHorizontal(const SWScaleJob &job, const float *row, char *dst)
+{
+    const unsigned int taps = job.htab.taps;
+
+    for (unsigned int x = 0; x < job.width; x++) {
+        const float *w = &job.htab.weight[x * taps];
+        const float *p = row + job.htab.start[x] * CH;
+        float px[CH] = {};
+
+        for (unsigned int k = 0; k < taps; k++)
+            for (unsigned int c = 0; c < CH; c++)
+                px[c] += w[k] * p[k * CH + c];
+
+        StorePixel(*job.fmt, dst, px);
+        dst += job.dst_col_step;
+    }
+}
 
-    unsigned int src_x;
-    unsigned int src_y = m_nSrcTop << 16;
+/*
+ * Scales the rows from @begin to @end before rotation. The vertical pass is
+ * a multiply-accumulate of the whole source rows into @acc that compilers
+ * vectorize to NEON or SSE as it is. The horizontal pass then reduces @acc
+ * to the destination pixels that are stored along the rotated direction.
+ */
+static void ScaleRows(const SWScaleJob &job, unsigned int begin, unsigned int end)
+{
+    const unsigned int count = job.src_width * job.fmt->channels;
+    const unsigned int taps = job.vtab.taps;
+    std::vector<float> acc(count);
+    std::vector<float> line(count);
 
-    // Luminance + Chrominance at once
-    for (unsigned int y = m_nDstTop; y < (m_nDstTop + m_nDstHeight); y++) {
-        src_x = m_nSrcLeft << 16;
-        for (unsigned int x = m_nDstLeft; x < (m_nDstLeft + m_nDstWidth); x++) {
-            m_pDst[0][y * (m_nDstStride * 2) + x * 2] =
-                m_pSrc[0][(src_y >> 16) * (m_nSrcStride * 2) + (src_x >> 16) * 2];
+    for (unsigned int y = begin; y < end; y++) {
+        const float *w = &job.vtab.weight[y * taps];
+        const char *src = job.src + job.vtab.start[y] * job.src_pitch;
 
-            if (!(x & 1)) {
-                unsigned int cx = (src_x >> 16) & ~1;
+        if (taps == 1) {
+            LoadRow(*job.fmt, src, job.src_width, acc.data());
+        } else {
+            std::fill(acc.begin(), acc.end(), 0.0f);
 
-                m_pDst[0][y * (m_nDstStride * 2) + x * 2 + 1] =
-                    m_pSrc[0][(src_y >> 16) * (m_nSrcStride * 2) + cx * 2 + 1];
-                m_pDst[0][y * (m_nDstStride * 2) + x * 2 + 3] =
-                    m_pSrc[0][(src_y >> 16) * (m_nSrcStride * 2) + cx * 2 + 3];
+            for (unsigned int k = 0; k < taps; k++, src += job.src_pitch) {
+                if (w[k] == 0.0f)
+                    continue;
 
+                LoadRow(*job.fmt, src, job.src_width, line.data());
+
+                float *__restrict a = acc.data();
+                const float *__restrict l = line.data();
+                const float weight = w[k];
+                for (unsigned int i = 0; i < count; i++)
+                    a[i] += weight * l[i];
             }
+        }
 
-            src_x = LibScaler::min(src_x + h_ratio, (m_nSrcLeft + m_nSrcWidth) << 16);
+        char *dst = job.dst + static_cast<ptrdiff_t>(y) * job.dst_row_step;
+        switch (job.fmt->channels) {
+        case 1: FilterRowHorizontal<1>(job, acc.data(), dst); break;
+        case 2: FilterRowHorizontal<2>(job, acc.data(), dst); break;
+        case 3: FilterRowHorizontal<3>(job, acc.data(), dst); break;
+        default: FilterRowHorizontal<4>(job, acc.data(), dst); break;
         }
+    }
+}
+
+/*
+ * Destination coordinate of (@x, @y) of the scaled image of @width x @height
+ * that is flipped and then rotated clockwise by @rot.
+ */
+static void TransformPoint(unsigned int rot, bool hflip, bool vflip,
+                           unsigned int width, unsigned int height,
+                           int x, int y, int &dx, int &dy)
+{
+    if (hflip)
+        x = width - 1 - x;
+    if (vflip)
+        y = height - 1 - y;
+
+    switch (rot) {
+    case 90:
+        dx = height - 1 - y;
+        dy = x;
+        break;
+    case 180:
+        dx = width - 1 - x;
+        dy = height - 1 - y;
+        break;
+    case 270:
+        dx = y;
+        dy = width - 1 - x;
+        break;
+    default:
+        dx = x;
+        dy = y;
+        break;
+    }
+}
+
+bool CScalerSW::ScalePlane(char *src, char *dst, const SWPlaneFormat &fmt) {
+    unsigned int src_width = m_nSrcWidth / fmt.hdiv;
+    unsigned int src_height = m_nSrcHeight / fmt.vdiv;
+    unsigned int dst_width = m_nDstWidth / fmt.hdiv;
+    unsigned int dst_height = m_nDstHeight / fmt.vdiv;
+
+    if ((src_width == 0) || (src_height == 0) || (dst_width == 0) || (dst_height == 0)) {
+        SC_LOGE("Invalid scaling %ux%u -> %ux%u", m_nSrcWidth, m_nSrcHeight, m_nDstWidth, m_nDstHeight);
+        return false;
+    }
 
-        src_y = LibScaler::min(src_y + v_ratio, (m_nSrcTop + m_nSrcHeight) << 16);
+    bool transpose = (m_nRotDegree == 90) || (m_nRotDegree == 270);
+    unsigned int width = transpose ? dst_height : dst_width;
+    unsigned int height = transpose ? dst_width : dst_height;
+
+    SWScaleJob job;
+    size_t dst_pitch = (m_nDstStride / fmt.hdiv) * fmt.bytes_per_pixel;
+
+    job.fmt = &fmt;
+    job.src_pitch = (m_nSrcStride / fmt.hdiv) * fmt.bytes_per_pixel;
+    job.src = src + (m_nSrcTop / fmt.vdiv) * job.src_pitch + (m_nSrcLeft / fmt.hdiv) * fmt.bytes_per_pixel;
+    job.src_width = src_width;
+    job.width = width;
+
+    BuildFilterTable(job.htab, m_nFilter, src_width, width);
+    BuildFilterTable(job.vtab, m_nFilter, src_height, height);
+
+    int x0, y0, x1, y1;
+    TransformPoint(m_nRotDegree, m_bHFlip, m_bVFlip, width, height, 0, 0, x0, y0);
+
+    job.dst = dst + (m_nDstTop / fmt.vdiv + y0) * dst_pitch +
+              (m_nDstLeft / fmt.hdiv + x0) * fmt.bytes_per_pixel;
+
+    TransformPoint(m_nRotDegree, m_bHFlip, m_bVFlip, width, height, 1, 0, x1, y1);
+    job.dst_col_step = (y1 - y0) * static_cast<ptrdiff_t>(dst_pitch) + (x1 - x0) * static_cast<ptrdiff_t>(fmt.bytes_per_pixel);
+
+    TransformPoint(m_nRotDegree, m_bHFlip, m_bVFlip, width, height, 0, 1, x1, y1);
+    job.dst_row_step = (y1 - y0) * static_cast<ptrdiff_t>(dst_pitch) + (x1 - x0) * static_cast<ptrdiff_t>(fmt.bytes_per_pixel);
+
+    unsigned int bands = LibScaler::min(m_nThreads, height / SW_SCALER_MIN_BAND_ROWS);
+    if (bands < 2) {
+        ScaleRows(job, 0, height);
+        return true;
     }
 
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < bands; i++)
+        workers.emplace_back(ScaleRows, std::cref(job), height * i / bands, height * (i + 1) / bands);
+
+    ScaleRows(job, 0, height / bands);
+
+    for (auto &worker : workers)
+        worker.join();
+
     return true;
 }
 
+bool CScalerSW_YUYV::Scale() {
+    if (((m_nSrcLeft | m_nSrcWidth | m_nDstLeft | m_nDstWidth | m_nSrcStride | m_nDstStride) % 2) != 0) {
+        SC_LOGE("Width of YUV422 should be even");
+        return false;
+    }
+
+    if ((m_nRotDegree == 90) || (m_nRotDegree == 270)) {
+        SC_LOGE("YUV422 cannot be rotated by %u degree", m_nRotDegree);
+        return false;
+    }
+
+    static const SWPlaneFormat luma = {2, 1, 1, SW_SAMPLE_U8, 1, 1};
+    static const SWPlaneFormat chroma = {4, 2, 2, SW_SAMPLE_U8, 2, 1};
+
+    return ScalePlane(m_pSrc[0], m_pDst[0], luma) &&
+           ScalePlane(m_pSrc[0] + 1, m_pDst[0] + 1, chroma);
+}
+
 bool CScalerSW_NV12::Scale() {
     if (((m_nSrcLeft | m_nSrcTop | m_nSrcWidth | m_nSrcHeight | m_nSrcStride |
                     m_nDstLeft | m_nDstTop | m_nDstWidth | m_nDstHeight | m_nDstStride) % 2) != 0) {
@@ -65,42 +383,35 @@ bool CScalerSW_NV12::Scale() {
         return false;
     }
 
-    unsigned int h_ratio = (m_nSrcWidth << 16) / m_nDstWidth;
-    unsigned int v_ratio = (m_nSrcHeight << 16) / m_nDstHeight;
-
-    unsigned int src_x;
-    unsigned int src_y = m_nSrcTop << 16;
-
-    // Luminance
-    for (unsigned int y = m_nDstTop; y < (m_nDstTop + m_nDstHeight); y++) {
-        src_x = m_nSrcLeft << 16;
-        for (unsigned int x = m_nDstLeft; x < (m_nDstLeft + m_nDstWidth); x++) {
-            m_pDst[0][y * m_nDstStride + x] = m_pSrc[0][(src_y >> 16) * m_nSrcStride + (src_x >> 16)];
+    static const SWPlaneFormat luma = {1, 1, 1, SW_SAMPLE_U8, 1, 1};
+    static const SWPlaneFormat chroma = {2, 2, 1, SW_SAMPLE_U8, 2, 2};
 
-            src_x = LibScaler::min(src_x + h_ratio, (m_nSrcLeft + m_nSrcWidth) << 16);
-        }
+    return ScalePlane(m_pSrc[0], m_pDst[0], luma) &&
+           ScalePlane(m_pSrc[1], m_pDst[1], chroma);
+}
 
-        src_y = LibScaler::min(src_y + v_ratio, (m_nSrcTop + m_nSrcHeight) << 16);
+bool CScalerSW_P010::Scale() {
+    if (((m_nSrcLeft | m_nSrcTop | m_nSrcWidth | m_nSrcHeight | m_nSrcStride |
+                    m_nDstLeft | m_nDstTop | m_nDstWidth | m_nDstHeight | m_nDstStride) % 2) != 0) {
+        SC_LOGE("Both of width and height of YUV420 should be even");
+        return false;
     }
 
-    // Chrominance
+    static const SWPlaneFormat luma = {2, 1, 2, SW_SAMPLE_P010, 1, 1};
+    static const SWPlaneFormat chroma = {4, 2, 2, SW_SAMPLE_P010, 2, 2};
 
-    // change pointers to 1-byte to pointers to 2-byte storage.
-    unsigned short *src = reinterpret_cast<unsigned short *>(m_pSrc[1]);
-    unsigned short *dst = reinterpret_cast<unsigned short *>(m_pDst[1]);
+    return ScalePlane(m_pSrc[0], m_pDst[0], luma) &&
+           ScalePlane(m_pSrc[1], m_pDst[1], chroma);
+}
 
-    src_y = (m_nSrcTop / 2) << 16;
-    for (unsigned int y = m_nDstTop / 2; y < ((m_nDstTop + m_nDstHeight) / 2); y++) {
-        // Move 2 pixels at once (CbCr)
-        src_x = (m_nSrcLeft / 2) << 16;
-        for (unsigned int x = m_nDstLeft / 2; x < ((m_nDstLeft + m_nDstWidth) / 2); x++) {
-            dst[y * (m_nDstStride / 2) + x] = src[(src_y >> 16) * (m_nSrcStride / 2) + (src_x >> 16)];
+bool CScalerSW_RGB32::Scale() {
+    static const SWPlaneFormat rgb = {4, 4, 1, SW_SAMPLE_U8, 1, 1};
 
-            src_x = LibScaler::min(src_x + h_ratio, ((m_nSrcLeft + m_nSrcWidth) / 2) << 16);
-        }
+    return ScalePlane(m_pSrc[0], m_pDst[0], rgb);
+}
 
-        src_y = LibScaler::min(src_y + v_ratio, ((m_nSrcTop + m_nSrcHeight) / 2) << 16);
-    }
+bool CScalerSW_RGB565::Scale() {
+    static const SWPlaneFormat rgb = {2, 3, 0, SW_SAMPLE_RGB565, 1, 1};
 
-    return true;
+    return ScalePlane(m_pSrc[0], m_pDst[0], rgb);
 }
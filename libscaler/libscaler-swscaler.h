@@ -3,6 +3,32 @@
 
 #include "libscaler-common.h"
 
+enum {
+    SW_FILTER_NEAREST,
+    SW_FILTER_BILINEAR,
+    SW_FILTER_BICUBIC,
+};
+
+enum {
+    SW_SAMPLE_U8,       // 8-bit per channel
+    SW_SAMPLE_P010,     // 10-bit in MSB of 16-bit per channel
+    SW_SAMPLE_RGB565,   // 5:6:5 packed in 16-bit
+};
+
+/*
+ * Layout of a plane. Chroma planes of YUV are described with the subsampling
+ * factors in hdiv and vdiv while the scaling and the transformation are
+ * configured in the unit of luma pixels.
+ */
+struct SWPlaneFormat {
+    unsigned int bytes_per_pixel;
+    unsigned int channels;
+    unsigned int channel_step;  // distance of the channels in a pixel in bytes
+    unsigned int sample;        // SW_SAMPLE_*
+    unsigned int hdiv;
+    unsigned int vdiv;
+};
+
 class CScalerSW {
     protected:
         char *m_pSrc[3];
@@ -13,6 +39,13 @@ class CScalerSW {
         unsigned int m_nDstLeft, m_nDstTop;
         unsigned int m_nDstWidth, m_nDstHeight;
         unsigned int m_nDstStride;
+        unsigned int m_nFilter;
+        unsigned int m_nRotDegree;
+        bool m_bHFlip;
+        bool m_bVFlip;
+        unsigned int m_nThreads;
+
+        bool ScalePlane(char *src, char *dst, const SWPlaneFormat &fmt);
     public:
         CScalerSW() { Clear(); }
         virtual ~CScalerSW() { };
@@ -34,6 +67,17 @@ class CScalerSW {
             m_nDstHeight = height;
             m_nDstStride = stride;
         }
+
+        void SetFilter(unsigned int filter) { m_nFilter = filter; }
+
+        // The source is flipped first and then rotated clockwise by @rot.
+        // The destination rectangle is the size after rotation.
+        bool SetRotate(int rot, bool hflip, bool vflip);
+
+        // Rows of the destination are split into @num_threads bands at most.
+        void SetThreadCount(unsigned int num_threads) {
+            m_nThreads = (num_threads > 0) ? num_threads : 1;
+        }
 };
 
 class CScalerSW_YUYV: public CScalerSW {
@@ -58,4 +102,36 @@ class CScalerSW_NV12: public CScalerSW {
         virtual bool Scale();
 };
 
+class CScalerSW_P010: public CScalerSW {
+    public:
+        CScalerSW_P010(char *src0, char *src1, char *dst0, char *dst1) {
+            m_pSrc[0] = src0;
+            m_pDst[0] = dst0;
+            m_pSrc[1] = src1;
+            m_pDst[1] = dst1;
+        }
+
+        virtual bool Scale();
+};
+
+class CScalerSW_RGB32: public CScalerSW {
+    public:
+        CScalerSW_RGB32(char *src, char *dst) {
+            m_pSrc[0] = src;
+            m_pDst[0] = dst;
+        }
+
+        virtual bool Scale();
+};
+
+class CScalerSW_RGB565: public CScalerSW {
+    public:
+        CScalerSW_RGB565(char *src, char *dst) {
+            m_pSrc[0] = src;
+            m_pDst[0] = dst;
+        }
+
+        virtual bool Scale();
+};
+
 #endif //__LIBSCALER_SWSCALER_H__
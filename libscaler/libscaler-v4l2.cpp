@@ -63,6 +63,7 @@ CScalerV4L2::CScalerV4L2(int instance, int allow_drm)
     m_nRotDegree = 0;
     m_fStatus = 0;
     m_filter = 0;
+    m_colorspace = V4L2_COLORSPACE_DEFAULT;
 
     memset(&m_frmSrc, 0, sizeof(m_frmSrc));
     memset(&m_frmDst, 0, sizeof(m_frmDst));
@@ -191,7 +192,7 @@ bool CScalerV4L2::SetCtrl()
         SC_LOGD("Skipping rotation and flip setting due to no change");
     }
 
-    if (m_filter > 0) {
+    if (TestFlag(m_fStatus, SCF_FILTER_FRESH) && (m_filter > 0)) {
         if (!Stop())
             return false;
 
@@ -202,6 +203,7 @@ bool CScalerV4L2::SetCtrl()
             return false;
         }
     }
+    ClearFlag(m_fStatus, SCF_FILTER_FRESH);
 
     if (TestFlag(m_fStatus, SCF_CSC_FRESH)) {
         if (!Stop())
@@ -440,6 +442,10 @@ bool CScalerV4L2::SetRotate(int rot, int flip_h, int flip_v)
 
     SetRotDegree(rot);
 
+    if ((!!flip_h != TestFlag(m_fStatus, SCF_VFLIP)) ||
+            (!!flip_v != TestFlag(m_fStatus, SCF_HFLIP)))
+        SetFlag(m_fStatus, SCF_ROTATION_FRESH);
+
     if (flip_h)
         SetFlag(m_fStatus, SCF_VFLIP);
     else
@@ -450,8 +456,6 @@ bool CScalerV4L2::SetRotate(int rot, int flip_h, int flip_v)
     else
         ClearFlag(m_fStatus, SCF_HFLIP);
 
-    SetFlag(m_fStatus, SCF_ROTATION_FRESH);
-
     return true;
 }
 
@@ -551,14 +555,9 @@ bool CScalerV4L2::RunSWScaling()
         return false;
     }
 
-    if (m_nRotDegree != 0) {
-        SC_LOGE("Rotation is not allowed for S/W Scaling");
-        return false;
-    }
-
-    SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d",
+    SC_LOGI("Running S/W Scaler: %dx%d -> %dx%d (rot %u)",
             m_frmSrc.crop.width, m_frmSrc.crop.height,
-            m_frmDst.crop.width, m_frmDst.crop.height);
+            m_frmDst.crop.width, m_frmDst.crop.height, m_nRotDegree);
 
     CScalerSW *swsc;
     char *src[3], *dst[3];
@@ -622,6 +621,57 @@ bool CScalerV4L2::RunSWScaling()
 
             swsc = new CScalerSW_NV12(src[0], src[1], dst[0], dst[1]);
             break;
+        case V4L2_PIX_FMT_NV12M_P010:
+            m_frmSrc.out_num_planes = 2;
+            m_frmDst.out_num_planes = 2;
+            m_frmSrc.out_plane_size[0] = m_frmSrc.width * m_frmSrc.height * 2;
+            m_frmDst.out_plane_size[0] = m_frmDst.width * m_frmDst.height * 2;
+            m_frmSrc.out_plane_size[1] = m_frmSrc.out_plane_size[0] / 2;
+            m_frmDst.out_plane_size[1] = m_frmDst.out_plane_size[0] / 2;
+
+            if (!GetBuffer(m_frmSrc, src))
+                return false;
+
+            if (!GetBuffer(m_frmDst, dst)) {
+                PutBuffer(m_frmSrc, src);
+                return false;
+            }
+
+            swsc = new CScalerSW_P010(src[0], src[1], dst[0], dst[1]);
+            break;
+        case V4L2_PIX_FMT_RGB32:
+        case V4L2_PIX_FMT_BGR32:
+            m_frmSrc.out_num_planes = 1;
+            m_frmSrc.out_plane_size[0] = m_frmSrc.width * m_frmSrc.height * 4;
+            m_frmDst.out_num_planes = 1;
+            m_frmDst.out_plane_size[0] = m_frmDst.width * m_frmDst.height * 4;
+
+            if (!GetBuffer(m_frmSrc, src))
+                return false;
+
+            if (!GetBuffer(m_frmDst, dst)) {
+                PutBuffer(m_frmSrc, src);
+                return false;
+            }
+
+            swsc = new CScalerSW_RGB32(src[0], dst[0]);
+            break;
+        case V4L2_PIX_FMT_RGB565:
+            m_frmSrc.out_num_planes = 1;
+            m_frmSrc.out_plane_size[0] = m_frmSrc.width * m_frmSrc.height * 2;
+            m_frmDst.out_num_planes = 1;
+            m_frmDst.out_plane_size[0] = m_frmDst.width * m_frmDst.height * 2;
+
+            if (!GetBuffer(m_frmSrc, src))
+                return false;
+
+            if (!GetBuffer(m_frmDst, dst)) {
+                PutBuffer(m_frmSrc, src);
+                return false;
+            }
+
+            swsc = new CScalerSW_RGB565(src[0], dst[0]);
+            break;
         case V4L2_PIX_FMT_UYVY: // TODO: UYVY is not implemented yet.
         default:
             SC_LOGE("Format %x is not supported", m_frmSrc.color_format);
@@ -641,6 +691,9 @@ bool CScalerV4L2::RunSWScaling()
     swsc->SetDstRect(m_frmDst.crop.left, m_frmDst.crop.top,
             m_frmDst.crop.width, m_frmDst.crop.height, m_frmDst.width);
 
+    // SCF_VFLIP and SCF_HFLIP keep the horizontal and the vertical flip respectively
+    swsc->SetRotate(m_nRotDegree, TestFlag(m_fStatus, SCF_VFLIP), TestFlag(m_fStatus, SCF_HFLIP));
+
     bool ret = swsc->Scale();
 
     delete swsc;
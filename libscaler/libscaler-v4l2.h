@@ -71,6 +71,7 @@ public:
         SCF_ROTATION_FRESH,
         SCF_CSC_FRESH,
         SCF_DRM_FRESH,
+        SCF_FILTER_FRESH,
         // h/w setting setting
         SCF_HFLIP,
         SCF_VFLIP,
@@ -117,8 +118,10 @@ private:
         if (rot < 0)
             rot = 360 + rot;
 
-        m_nRotDegree = rot;
-        SetFlag(m_fStatus, SCF_ROTATION_FRESH);
+        if (m_nRotDegree != static_cast<unsigned int>(rot)) {
+            m_nRotDegree = rot;
+            SetFlag(m_fStatus, SCF_ROTATION_FRESH);
+        }
     }
 
     bool DevSetFormat(FrameInfo &frm);
@@ -127,30 +130,42 @@ private:
     bool StreamOn(FrameInfo &frm);
     bool DQBuf(FrameInfo &frm);
 
+    // The streaming session is kept if the format and the crop are unchanged
     inline bool SetFormat(FrameInfo &frm, unsigned int width, unsigned int height,
                    unsigned int v4l2_colorformat) {
-        frm.color_format = v4l2_colorformat;
-        frm.width = width;
-        frm.height = height;
-        SetFlag(frm.flags, SCFF_BUF_FRESH);
+        if ((frm.color_format != v4l2_colorformat) ||
+                (frm.width != width) || (frm.height != height)) {
+            frm.color_format = v4l2_colorformat;
+            frm.width = width;
+            frm.height = height;
+            SetFlag(frm.flags, SCFF_BUF_FRESH);
+        }
         return true;
     }
 
     inline bool SetCrop(FrameInfo &frm, unsigned int left, unsigned int top,
                  unsigned int width, unsigned int height) {
-        frm.crop.left = left;
-        frm.crop.top = top;
-        frm.crop.width = width;
-        frm.crop.height = height;
-        SetFlag(frm.flags, SCFF_BUF_FRESH);
+        if ((frm.crop.left != static_cast<int>(left)) ||
+                (frm.crop.top != static_cast<int>(top)) ||
+                (frm.crop.width != width) || (frm.crop.height != height)) {
+            frm.crop.left = left;
+            frm.crop.top = top;
+            frm.crop.width = width;
+            frm.crop.height = height;
+            SetFlag(frm.flags, SCFF_BUF_FRESH);
+        }
         return true;
     }
 
     inline void SetPremultiplied(FrameInfo &frm, unsigned int premultiplied) {
+        if (!!premultiplied == TestFlag(frm.flags, SCFF_PREMULTIPLIED))
+            return;
+
         if (premultiplied)
             SetFlag(frm.flags, SCFF_PREMULTIPLIED);
         else
             ClearFlag(frm.flags, SCFF_PREMULTIPLIED);
+        SetFlag(frm.flags, SCFF_BUF_FRESH);
     }
 
     inline void SetCacheable(FrameInfo &frm, bool __UNUSED__ cacheable) {
@@ -162,6 +177,9 @@ private:
         for (int i = 0; i < SC_MAX_PLANES; i++)
             frm.addr[i] = addr[i];
 
+        // the buffers requested for the other memory type are not reusable
+        if (frm.memory != static_cast<v4l2_memory>(mem_type))
+            SetFlag(frm.flags, SCFF_BUF_FRESH);
         frm.memory = static_cast<v4l2_memory>(mem_type);
         frm.fdAcquireFence = fence;
     }
@@ -267,6 +285,9 @@ public:
     }
 
     inline void SetCSCWide(bool wide) {
+        if (wide == TestFlag(m_fStatus, SCF_CSC_WIDE))
+            return;
+
         if (wide)
             SetFlag(m_fStatus, SCF_CSC_WIDE);
         else
@@ -277,14 +298,19 @@ public:
 
     inline void SetCSCEq(unsigned int v4l2_colorspace) {
         if (v4l2_colorspace == V4L2_COLORSPACE_SMPTE170M)
-            m_colorspace = V4L2_COLORSPACE_DEFAULT;
-        else
+            v4l2_colorspace = V4L2_COLORSPACE_DEFAULT;
+
+        if (m_colorspace != v4l2_colorspace) {
             m_colorspace = v4l2_colorspace;
-        SetFlag(m_fStatus, SCF_CSC_FRESH);
+            SetFlag(m_fStatus, SCF_CSC_FRESH);
+        }
     }
 
     inline void SetFilter(unsigned int filter) {
-        m_filter = filter;
+        if (m_filter != filter) {
+            m_filter = filter;
+            SetFlag(m_fStatus, SCF_FILTER_FRESH);
+        }
     }
 
     inline void SetSrcCacheable(bool cacheable) {
@@ -317,8 +343,10 @@ public:
     }
 
     inline void SetFrameRate(int framerate) {
-        m_frameRate = framerate;
-        SetFlag(m_fStatus, SCF_FRAMERATE);
+        if (m_frameRate != static_cast<unsigned int>(framerate)) {
+            m_frameRate = framerate;
+            SetFlag(m_fStatus, SCF_FRAMERATE);
+        }
     }
 };
 
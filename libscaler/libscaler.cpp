@@ -36,6 +36,9 @@
 #include <unistd.h>
 #include <system/graphics.h>
 
+#include <memory>
+#include <mutex>
+
 #include "exynos_scaler.h"
 
 #include "libscaler-common.h"
@@ -183,15 +186,34 @@ static bool find_pixel(unsigned int sc_pxfmt, unsigned int __out *v4l2_pxfmt)
     return false;
 }
 
+#define SC_NUM_OF_COPY_PIXELS_DEV 4 // CScalerM2M1SHOT accepts instance 0 ~ 3
+
+// The instances of exynos_sc_copy_pixels() are kept open across the calls
+// not to open and close the device node for every copy.
+static std::mutex sCopyPixelsLock[SC_NUM_OF_COPY_PIXELS_DEV];
+static std::unique_ptr<CScalerM2M1SHOT> sCopyPixelsScaler[SC_NUM_OF_COPY_PIXELS_DEV];
+
 bool exynos_sc_copy_pixels(exynos_sc_pxinfo *pxinfo, int dev_num)
 {
     unsigned int srcfmt;
     unsigned int dstfmt;
 
-    CScalerM2M1SHOT sc(dev_num);
+    if ((dev_num < 0) || (dev_num >= SC_NUM_OF_COPY_PIXELS_DEV)) {
+        SC_LOGE("Invalid device instance ID %d", dev_num);
+        return false;
+    }
 
-    if (!sc.Valid())
+    std::lock_guard<std::mutex> lock(sCopyPixelsLock[dev_num]);
+
+    if (!sCopyPixelsScaler[dev_num] || !sCopyPixelsScaler[dev_num]->Valid())
+        sCopyPixelsScaler[dev_num].reset(new CScalerM2M1SHOT(dev_num));
+
+    CScalerM2M1SHOT &sc = *sCopyPixelsScaler[dev_num];
+
+    if (!sc.Valid()) {
+        sCopyPixelsScaler[dev_num].reset();
         return false;
+    }
 
     if (!find_pixel(pxinfo->src.pxfmt, &srcfmt))
         return false;